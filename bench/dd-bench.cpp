@@ -0,0 +1,68 @@
+/*
+ * Cost and drift of double, double-double and long double state accumulation
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "control/classic/pid.h"
+#include "control/system/dd.h"
+#include "control/system/ss.h"
+
+namespace {
+
+using namespace control::system;
+
+constexpr long steps = 10000000;
+
+/**
+ * Double integrator driven by a constant input; exact position n^2 u / 2
+ *
+ * Prints ns per step and the relative error of the final position, and ns per PI step
+ */
+template<typename T>
+void integrator(const char *name) {
+  using P = ss<T, 2>;
+  typename P::TA A;
+  typename P::TB B;
+  typename P::TC C;
+  typename P::TD D;
+  A << T(1), T(1), T(0), T(1);
+  B << T(0.5), T(1);
+  C << T(1), T(0);
+  D << T(0);
+  P p(A, B, C, D);
+  const typename P::Tu u = P::Tu::Constant(T(0.1));
+
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < steps; i++)
+    p.step(u);
+  std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+
+  // n^2 u / 2 exactly in double-double: 0.1 and n^2 fit in 106 bits
+  const dd<double> exact = dd<double>(0.1) * double(steps) * double(steps) / 2.;
+  const dd<double> got = dd<double>(double(p.y(0)), double(p.y(0) - T(double(p.y(0)))));
+  const double err = std::abs(double(got - exact)) / double(exact);
+
+  // A PI controller integrating a constant error
+  control::classic::PI<T> pi(T(0.001), T(1), T(0.5));
+  auto start2 = std::chrono::steady_clock::now();
+  T v = 0;
+  for (long i = 0; i < steps; i++)
+    v = pi.step(T(0.1));
+  std::chrono::duration<double, std::nano> t2 = std::chrono::steady_clock::now() - start2;
+  volatile double sink = double(v);
+  (void) sink;
+
+  std::printf("%-14s  %8.2f  %10.2e  %8.2f\n", name, t.count() / steps, err, t2.count() / steps);
+}
+
+}
+
+int main() {
+  std::printf("%-14s  %8s  %10s  %8s\n", "type", "ss ns", "ss error", "PI ns");
+  integrator<double>("double");
+  integrator<dd<double>>("dd<double>");
+  integrator<long double>("long double");
+}
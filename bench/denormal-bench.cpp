@@ -0,0 +1,119 @@
+/*
+ * Per-sample cost through decay tails
+ *
+ * Excites each IIR component with noise, then feeds zeros and reports the cost
+ * per sample in consecutive windows of the tail. Without protection the cost
+ * jumps once the states turn subnormal; with snap() per block or a
+ * FlushDenormals guard it stays flat.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "control/classic/pid.h"
+#include "control/filter/biquad.h"
+#include "control/filter/design.h"
+#include "control/filter/realization.h"
+#include "control/system/denormal.h"
+#include "control/system/ss.h"
+
+namespace {
+
+using namespace control;
+
+constexpr size_t block = 64;
+constexpr size_t window = 16384;
+constexpr size_t windows = 24;
+
+// Double pole at 0.999, a slow decay known at compile time
+struct slow {
+  static constexpr filter::sos<double> value{1e-6, 2e-6, 1e-6, -1.998, 0.998001};
+};
+
+enum class mode { none, snap, flush };
+
+template<typename F>
+auto step(F &f, float x) {
+  if constexpr (std::is_invocable_v<decltype(&F::step), F &, float>)
+    return f.step(x);
+  else
+    return f.step(F::Tu::Constant(x))(0);
+}
+
+/**
+ * Minimum and maximum ns/sample over the windows of the tail
+ */
+template<typename F>
+std::pair<double, double> tail(F f, mode m) {
+  std::minstd_rand e(1);
+  std::uniform_real_distribution<float> d(-1, 1);
+  volatile float sink = 0;
+
+  for (size_t i = 0; i < window; i++)
+    sink = sink + step(f, d(e));
+
+  std::optional<system::FlushDenormals> guard;
+  if (m == mode::flush)
+    guard.emplace();
+
+  double lo = 1e9, hi = 0;
+  for (size_t w = 0; w < windows; w++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < window; i += block) {
+      for (size_t j = 0; j < block; j++)
+        sink = sink + step(f, 0.f);
+      if (m == mode::snap)
+        f.snap();
+    }
+    std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+    lo = std::min(lo, t.count() / window);
+    hi = std::max(hi, t.count() / window);
+  }
+
+  return {lo, hi};
+}
+
+template<typename F>
+void report(const char *name, const F &f) {
+  std::printf("%-16s", name);
+  for (auto m : {mode::none, mode::snap, mode::flush}) {
+    auto[lo, hi] = tail(f, m);
+    std::printf("  %6.2f %6.2f", lo, hi);
+  }
+  std::printf("\n");
+}
+
+}
+
+int main() {
+  // Slow decay, so the tail passes through the whole subnormal range
+  auto s = filter::design::butter<4>(0.002f);
+
+  using ss4 = system::ss<float, 4>;
+  ss4::TA A;
+  ss4::TB B;
+  ss4::TC C;
+  ss4::TD D;
+  A << 0.999f, 0.01f, 0, 0, 0, 0.998f, 0.01f, 0, 0, 0, 0.997f, 0.01f, 0, 0, 0, 0.996f;
+  B << 0, 0, 0, 1e-3f;
+  C << 1, 0, 0, 0;
+  D << 0;
+
+  std::printf("%-16s  %13s  %13s  %13s\n", "ns/sample", "none", "snap", "flush");
+  std::printf("%-16s  %6s %6s  %6s %6s  %6s %6s\n", "", "min", "max", "min", "max", "min", "max");
+  report("Biquad", filter::Biquad<float>(s[1]));
+  report("BiquadDF1", filter::BiquadDF1<float>(s[1]));
+  report("BiquadCoupled", filter::BiquadCoupled<float>(s[1]));
+  report("BiquadSVF", filter::BiquadSVF<float>(s[1]));
+  report("StaticBiquad", filter::StaticBiquad<float, slow>());
+  report("BiquadCascade", filter::design::cascade(s));
+  report("BiquadChain", filter::BiquadChain<filter::Biquad<float>, filter::BiquadSVF<float>>(s[0], s[1]));
+  report("PD", classic::PD<float>(1e-3f, 1, 0.05f, 10));
+  report("ss", ss4(A, B, C, D));
+
+  return 0;
+}
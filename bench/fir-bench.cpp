@@ -0,0 +1,57 @@
+/*
+ * Per-sample cost of FIR filters, direct form against partitioned overlap-save
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "control/filter/fir.h"
+
+namespace {
+
+using namespace control::filter;
+
+constexpr size_t samples = 1 << 18;
+
+template<size_t N, size_t B>
+double cost() {
+  std::minstd_rand e(1);
+  std::uniform_real_distribution<float> d(-1, 1);
+
+  std::array<float, N> h;
+  for (auto &k : h)
+    k = d(e);
+  std::vector<float> x(samples), y(samples);
+  for (auto &s : x)
+    s = d(e);
+
+  auto f = std::make_unique<Fir<float, N, B>>(h);
+  auto start = std::chrono::steady_clock::now();
+  f->process(x.data(), x.size(), y.data());
+  std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+
+  volatile float sink = y.back();
+  (void) sink;
+  return t.count() / samples;
+}
+
+template<size_t N>
+void report() {
+  std::printf("%6zu  %8.1f  %8.1f  (B = %zu)\n", N, cost<N, 0>(), cost<N, detail::fir_partition(N)>(),
+              detail::fir_partition(N));
+}
+
+}
+
+int main() {
+  std::printf("%6s  %8s  %8s\n", "taps", "direct", "partit.");
+  report<256>();
+  report<512>();
+  report<1024>();
+  report<2048>();
+  report<4096>();
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Per-step cost of EKF and UKF on 12 states: six coupled pendulums
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "control/system/kalman.h"
+
+namespace {
+
+using namespace control::system;
+
+constexpr size_t steps = 20000;
+constexpr double Ts = 1e-3;
+
+// Angles, then angular velocities; torque on the first, all angles measured
+auto chain() {
+  auto f = [](const auto &x, const auto &u) {
+    auto r = x.eval();
+    auto q = x.template topRows<6>();
+    auto w = x.template bottomRows<6>();
+    r.template topRows<6>() += Ts * w;
+    r.template bottomRows<6>() -= Ts * (9.81 * q.array().sin().matrix() + 0.2 * w);
+    r.template bottomRows<5>() -= Ts * 5. * (q.template bottomRows<5>() - q.template topRows<5>());
+    r.template middleRows<5>(6) -= Ts * 5. * (q.template topRows<5>() - q.template bottomRows<5>());
+    r.row(6) += Ts * u.row(0);
+    return r;
+  };
+  auto h = [](const auto &x) { return x.template topRows<6>().eval(); };
+  return nonlinear<double, 12, 1, 6>(f, h);
+}
+
+template<typename K, typename S>
+double cost(K &k, S P) {
+  std::minstd_rand e(1);
+  std::normal_distribution<double> d(0, 1e-3);
+
+  std::chrono::duration<double, std::micro> t{0};
+  for (size_t i = 0; i < steps; i++) {
+    typename S::Tu u(std::sin(1e-3 * i));
+    typename S::Ty z = P.step(u);
+    for (int j = 0; j < 6; j++)
+      z(j) += d(e);
+    auto start = std::chrono::steady_clock::now();
+    k.step(u, z);
+    t += std::chrono::steady_clock::now() - start;
+  }
+
+  volatile double sink = k.x(0);
+  (void) sink;
+  return t.count() / steps;
+}
+
+}
+
+int main() {
+  auto P = chain();
+  using S = decltype(P);
+  P.x(0) = 0.5;
+  Eigen::Matrix<double, 12, 12> Q = 1e-8 * Eigen::Matrix<double, 12, 12>::Identity();
+  Eigen::Matrix<double, 6, 6> R = 1e-6 * Eigen::Matrix<double, 6, 6>::Identity();
+
+  ekf<S> en(P, Q, R);
+  ekf<S, jacobian::autodiff> ea(P, Q, R);
+  ukf<S> ub(P, Q, R);
+  ukf<S, false> uc(P, Q, R);
+
+  std::printf("%-22s  %8s\n", "filter (12 states)", "us/step");
+  std::printf("%-22s  %8.2f\n", "ekf numeric", cost(en, P));
+  std::printf("%-22s  %8.2f\n", "ekf autodiff", cost(ea, P));
+  std::printf("%-22s  %8.2f\n", "ukf batched", cost(ub, P));
+  std::printf("%-22s  %8.2f\n", "ukf per sigma point", cost(uc, P));
+}
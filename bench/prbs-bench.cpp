@@ -0,0 +1,66 @@
+/*
+ * Throughput of random excitation: Philox words and multichannel PRBS
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "control/ident/idsignal.h"
+
+namespace {
+
+using namespace control::ident;
+
+template<typename F>
+double seconds(F f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+  return t.count();
+}
+
+template<typename E>
+double per_sample(PRBS<float, E> P, size_t n) {
+  float s = 0;
+  double t = seconds([&] {
+    for (size_t i = 0; i < n; i++)
+      s += P.get();
+  });
+  volatile float sink = s;
+  (void) sink;
+  return t;
+}
+
+}
+
+int main() {
+  const size_t n = size_t(1) << 24, channels = 64;
+
+  std::vector<uint32_t> w(n);
+  philox4x32 e(1);
+  e.generate(w.data(), n);
+  double t = seconds([&] { e.generate(w.data(), n); });
+  std::printf("%-34s  %8.2f Gbit/s\n", "philox4x32 generate", 32e-9 * n / t);
+  t = seconds([&] {
+    for (auto &v : w)
+      v = e();
+  });
+  std::printf("%-34s  %8.2f Gbit/s\n", "philox4x32 one word at a time", 32e-9 * n / t);
+
+  std::printf("%-34s  %8.2f Msample/s\n", "PRBS<float, default_random_engine>",
+              1e-6 * n / per_sample(PRBS<float, std::default_random_engine>(), n));
+  std::printf("%-34s  %8.2f Msample/s\n", "PRBS<float>", 1e-6 * n / per_sample(PRBS<float>(), n));
+
+  std::vector<std::vector<float>> y(channels, std::vector<float>(n / 8));
+  std::vector<float *> yp;
+  for (auto &c : y)
+    yp.push_back(c.data());
+  prbs(yp, n / 8, 1, 1);
+  for (unsigned threads : {1u, std::max(1u, std::thread::hardware_concurrency())}) {
+    t = seconds([&] { prbs(yp, n / 8, 1, threads); });
+    std::printf("prbs %zu channels, %2u threads      %8.2f Msample/s\n", channels, threads, 1e-6 * channels * (n / 8) / t);
+  }
+}
@@ -0,0 +1,47 @@
+/*
+ * Throughput of multichannel Welch estimates against the number of threads
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "control/ident/spectral.h"
+
+namespace {
+
+using namespace control::ident;
+
+constexpr size_t channels = 64;
+constexpr size_t samples = 1 << 19;
+
+}
+
+int main() {
+  std::minstd_rand e(1);
+  std::uniform_real_distribution<float> d(-1, 1);
+  std::vector<float> u(samples);
+  for (auto &s : u)
+    s = d(e);
+  std::vector<std::vector<float>> y(channels, std::vector<float>(samples));
+  std::vector<const float *> yp;
+  for (auto &c : y) {
+    for (size_t i = 1; i < samples; i++)
+      c[i] = 0.9f * c[i - 1] + 0.1f * u[i] + 0.01f * d(e);
+    yp.push_back(c.data());
+  }
+
+  std::printf("%d channels of %zu samples, segments of 1024\n", int(channels), samples);
+  std::printf("%8s  %10s  %14s  %18s\n", "threads", "seconds", "Msamples/s", "1 h at 1 kHz (s)");
+  for (unsigned t = 1; t <= std::max(1u, std::thread::hardware_concurrency()); t *= 2) {
+    auto start = std::chrono::steady_clock::now();
+    auto s = welch<1024>(u.data(), yp, samples, 1000.f, 512, t);
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+    volatile float sink = s[0].Pyy[1];
+    (void) sink;
+    const double rate = channels * samples / dt.count();
+    std::printf("%8u  %10.3f  %14.1f  %18.2f\n", t, dt.count(), rate / 1e6, 3600e3 * channels / rate);
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * Per-stream cost of K streams through one small state-space: K ss instances against an ssbank
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "control/system/ssbank.h"
+
+namespace {
+
+using namespace control::system;
+
+constexpr size_t samples = 5000000;
+
+template<size_t Nx>
+void compare(size_t K) {
+  using P = ss<float, Nx>;
+  typename P::TA A = P::TA::Random() * (0.3f / Nx);
+  typename P::TB B = P::TB::Random();
+  typename P::TC C = P::TC::Random();
+  typename P::TD D = P::TD::Random();
+  P p(A, B, C, D);
+
+  const size_t n = samples / K;
+  std::minstd_rand e(1);
+  std::uniform_real_distribution<float> d(-1, 1);
+  std::vector<float> u(n * K), y(n * K);
+  for (auto &v : u)
+    v = d(e);
+
+  std::vector<P> each(K, p);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < n; t++)
+    for (size_t k = 0; k < K; k++)
+      y[t * K + k] = each[k].step(typename P::Tu(u[t * K + k]))(0);
+  std::chrono::duration<double, std::nano> ts = std::chrono::steady_clock::now() - start;
+
+  ssbank<float, Nx> bank(p, K);
+  start = std::chrono::steady_clock::now();
+  bank.process(u.data(), n, y.data());
+  std::chrono::duration<double, std::nano> tb = std::chrono::steady_clock::now() - start;
+
+  volatile float sink = y.back();
+  (void) sink;
+  std::printf("%4zu  %6zu  %10.2f  %10.2f\n", Nx, K, ts.count() / double(n * K), tb.count() / double(n * K));
+}
+
+}
+
+int main() {
+  std::printf("%4s  %6s  %10s  %10s\n", "Nx", "K", "ss ns", "ssbank ns");
+  for (size_t K : {16, 256, 4096, 65536}) {
+    compare<4>(K);
+    compare<8>(K);
+    compare<16>(K);
+  }
+}
@@ -0,0 +1,78 @@
+/*
+ * Validation of large populations of biquads and state-spaces
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "control/system/stability.h"
+
+namespace {
+
+using namespace control::system;
+using control::filter::Biquad;
+using control::filter::sos;
+
+template<typename F>
+double ns(F f, size_t n) {
+  double best = 1e300;
+  for (int r = 0; r < 5; r++) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+    best = std::min(best, t.count() / double(n));
+  }
+  return best;
+}
+
+}
+
+int main() {
+  const size_t n = 100000;
+  const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::minstd_rand e(1);
+  std::uniform_real_distribution<double> d(-2, 2);
+  std::normal_distribution<double> g(0, 0.4);
+
+  std::vector<sos<double>> s(n);
+  for (auto &c : s)
+    c = {1, 0, 0, d(e), d(e) / 2};
+  std::vector<Biquad<double>> b(s.begin(), s.end());
+
+  size_t count = 0;
+  std::printf("%-34s  %8s\n", "100k biquads", "ns each");
+  std::printf("%-34s  %8.2f\n", "poles() magnitudes", ns([&] {
+    for (auto &f : b) {
+      auto p = f.poles();
+      count += std::abs(p.first) <= 1 && std::abs(p.second) <= 1;
+    }
+  }, n));
+  std::printf("%-34s  %8.2f\n", "stable()", ns([&] {
+    for (auto &f : b)
+      count += f.stable();
+  }, n));
+  std::vector<double> m;
+  std::printf("%-34s  %8.2f\n", "margins, 1 thread", ns([&] { m = margins(s, 1); }, n));
+  std::printf("margins, %2u threads                 %8.2f\n", threads, ns([&] { m = margins(s, threads); }, n));
+
+  const size_t k = 10000;
+  std::vector<ss<double, 6>> P;
+  for (size_t i = 0; i < k; i++) {
+    ss<double, 6>::TA A = ss<double, 6>::TA::NullaryExpr([&]() { return g(e); });
+    P.emplace_back(A, ss<double, 6>::TB::Ones(), ss<double, 6>::TC::Ones(), ss<double, 6>::TD::Zero());
+  }
+  std::printf("\n%-34s  %8s\n", "10k ss<double, 6>", "ns each");
+  std::printf("%-34s  %8.2f\n", "asymptotically_stable()", ns([&] {
+    for (auto &p : P)
+      count += asymptotically_stable(p);
+  }, k));
+  std::printf("%-34s  %8.2f\n", "margins, 1 thread", ns([&] { m = margins(P, 1); }, k));
+  std::printf("margins, %2u threads                 %8.2f\n", threads, ns([&] { m = margins(P, threads); }, k));
+
+  volatile size_t sink = count;
+  (void) sink;
+}
@@ -78,6 +78,11 @@ class AbstractController : public system::SISO<T> {
    */
   virtual void reset() {};
 
+  /**
+   * Snap decaying states of the controller to zero before they become subnormal
+   */
+  virtual void snap() {};
+
  protected:
 
   /**
@@ -176,6 +181,14 @@ class PID : public AbstractController<T> {
       (2 * Td / N - Ts) / (2 * Td / N + Ts)
   ) {};
 
+  /**
+   * Constructor of PID controller from the coefficients of its biquad
+   *
+   * @param c coefficients, as returned by coefficients()
+   * @param Limit Maximum output
+   */
+  explicit PID(const filter::sos<T> &c, T Limit = max<T>()) : AbstractController<T>(Limit), B(c) {};
+
   /**
    * Poles of the PID controller
    *
@@ -185,6 +198,15 @@ class PID : public AbstractController<T> {
     return B.poles();
   }
 
+  /**
+   * Coefficients of the controller's biquad
+   *
+   * @return filter::sos<T>
+   */
+  filter::sos<T> coefficients() const {
+    return B.coefficients();
+  }
+
   /**
    * Reset the state of the controller
    */
@@ -192,6 +214,33 @@ class PID : public AbstractController<T> {
     B.reset();
   }
 
+  /**
+   * Snap decaying states of the controller to zero
+   *
+   * @see filter::Biquad::snap()
+   */
+  void snap() {
+    B.snap();
+  }
+
+  /**
+   * State of the controller's biquad, e.g. to checkpoint it
+   *
+   * @return std::array<T, 2>
+   */
+  std::array<T, 2> state() const {
+    return B.state();
+  }
+
+  /**
+   * Restore the state
+   *
+   * @param w state as returned by state()
+   */
+  void state(const std::array<T, 2> &w) {
+    B.state(w);
+  }
+
  protected:
 
   /**
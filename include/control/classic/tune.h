@@ -0,0 +1,469 @@
+/*
+ * PID tuning by closed-loop simulation
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "control/classic/pid.h"
+#include "control/filter/biquad.h"
+#include "control/system/ss.h"
+
+namespace control::classic::tune {
+
+/**
+ * PID gains, as in PID(Ts, Kp, Ti, Td, N, Limit)
+ */
+template<typename T>
+struct gains {
+  T Kp;
+  T Ti;
+  T Td;
+};
+
+/**
+ * Step response metrics of a closed loop
+ *
+ * Integrals are in units of seconds. Overshoot is relative to the reference.
+ * Settling is the time after which the output stays within the band; infinite
+ * when it has not settled at the end of the simulation or when the loop is
+ * unstable.
+ */
+template<typename T>
+struct metrics {
+  T ise;
+  T iae;
+  T overshoot;
+  T settling;
+  bool stable;
+};
+
+/**
+ * Closed loop of a PID controller and a SISO plant
+ *
+ *        r    +----------+  +   e   +-----+   u   +-------+
+ *      ---->--| prefilter |-->(+)--->| PID |------>| plant |---+---> y
+ *             +----------+    - ^   +-----+       +-------+   |
+ *                               +-----------------------------+
+ *
+ * The controller output saturates at Limit. The prefilter shapes the reference
+ * step; by default it passes it unchanged.
+ *
+ * @tparam T arithmetic type
+ * @tparam Nx number of plant states
+ */
+template<typename T, size_t Nx>
+struct loop {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  // Plant, simulated from its zero state
+  system::ss<T, Nx> plant;
+
+  // Sample time (s)
+  T Ts;
+
+  // Simulated samples
+  size_t steps;
+
+  // Derivative filter coefficient and output limit of the controller
+  T N = max<T>();
+  T Limit = max<T>();
+
+  // Reference step, reference prefilter and settling band relative to r
+  T r = 1;
+  filter::Biquad<T, T> prefilter{1, 0, 0, 0, 0};
+  T band = T(0.02);
+
+  // |y| above bound times |r| counts as unstable
+  T bound = T(1e6);
+
+  /**
+   * @param g gains
+   * @return PID<T> controller with these gains
+   */
+  PID<T> controller(const gains<T> &g) const {
+    return PID<T>(Ts, g.Kp, g.Ti, g.Td, N, Limit);
+  }
+};
+
+/**
+ * Simulate the step response of a closed loop
+ *
+ * Does not allocate.
+ *
+ * @param l closed loop
+ * @param g gains
+ * @return metrics<T>
+ */
+template<typename T, size_t Nx>
+metrics<T> simulate(const loop<T, Nx> &l, const gains<T> &g) {
+  auto pid = l.controller(g);
+  auto plant = l.plant;
+  auto pre = l.prefilter;
+  plant.x.setZero();
+  pre.reset();
+
+  using Tu = typename system::ss<T, Nx>::Tu;
+  const T inf = std::numeric_limits<T>::infinity(), lim = l.bound * std::abs(l.r);
+
+  metrics<T> m{0, 0, 0, 0, true};
+  T y = 0, ymax = 0;
+  size_t outside = 0;
+  for (size_t i = 0; i < l.steps; i++) {
+    T e = pre.step(l.r) - y;
+    m.ise += e * e * l.Ts;
+    m.iae += std::abs(e) * l.Ts;
+    if (std::abs(y - l.r) > l.band * std::abs(l.r))
+      outside = i + 1;
+    ymax = std::max(ymax, y * (l.r < 0 ? -1 : 1));
+
+    y = plant.step(Tu::Constant(pid.step(e)))(0);
+    if (!(std::abs(y) <= lim))
+      return {inf, inf, inf, inf, false};
+  }
+
+  m.overshoot = std::max(T(0), ymax / std::abs(l.r) - 1);
+  m.settling = outside == l.steps ? inf : T(outside) * l.Ts;
+  return m;
+}
+
+/**
+ * Simulate the step responses of K controllers in lockstep
+ *
+ * The controllers and plant copies run as K lanes of fixed-size Eigen arrays,
+ * so every sample is a handful of vector operations and one small matrix
+ * product over all lanes. Results match simulate() per lane up to rounding.
+ * Does not allocate.
+ *
+ * @tparam K number of lanes
+ * @param l closed loop
+ * @param g gains per lane
+ * @return std::array<metrics<T>, K>
+ */
+template<size_t K, typename T, size_t Nx>
+std::array<metrics<T>, K> simulate(const loop<T, Nx> &l, const std::array<gains<T>, K> &g) {
+  using V = Eigen::Array<T, 1, int(K)>;
+  using X = Eigen::Matrix<T, int(Nx), int(K)>;
+
+  // Controller biquads as lanes
+  V b0, b1, b2, a1, a2;
+  for (size_t k = 0; k < K; k++) {
+    auto c = l.controller(g[k]).coefficients();
+    b0(k) = c.b0;
+    b1(k) = c.b1;
+    b2(k) = c.b2;
+    a1(k) = c.a1;
+    a2(k) = c.a2;
+  }
+
+  const auto &A = l.plant.getA();
+  const auto &B = l.plant.getB();
+  const auto &C = l.plant.getC();
+  const T D = l.plant.getD()(0), L = l.Limit, band = l.band * std::abs(l.r);
+  const T inf = std::numeric_limits<T>::infinity(), lim = l.bound * std::abs(l.r), sign = l.r < 0 ? -1 : 1;
+  auto pre = l.prefilter;
+  pre.reset();
+
+  X x = X::Zero();
+  V y = V::Zero(), w0 = V::Zero(), w1 = V::Zero(), ymax = V::Zero();
+  V ise = V::Zero(), iae = V::Zero();
+  Eigen::Array<size_t, 1, int(K)> outside = decltype(outside)::Zero();
+  Eigen::Array<bool, 1, int(K)> stable = decltype(stable)::Constant(true);
+
+  for (size_t i = 0; i < l.steps; i++) {
+    V e = pre.step(l.r) - y;
+    ise += e * e * l.Ts;
+    iae += e.abs() * l.Ts;
+    outside = ((y - l.r).abs() > band).select(decltype(outside)::Constant(i + 1), outside);
+    ymax = ymax.max(y * sign);
+
+    // Direct form II transposed, then saturation
+    V u = b0 * e + w0;
+    w0 = b1 * e - a1 * u + w1;
+    w1 = b2 * e - a2 * u;
+    u = u.min(L).max(-L);
+
+    x = A * x + B * u.matrix();
+    y = (C * x).array() + D * u;
+    stable = stable && (y.abs() <= lim);
+  }
+
+  std::array<metrics<T>, K> m;
+  for (size_t k = 0; k < K; k++)
+    m[k] = stable(k)
+           ? metrics<T>{ise(k), iae(k), std::max(T(0), ymax(k) / std::abs(l.r) - 1),
+                        outside(k) == l.steps ? inf : T(outside(k)) * l.Ts, true}
+           : metrics<T>{inf, inf, inf, inf, false};
+  return m;
+}
+
+/**
+ * Simulate many controllers on a pool of threads
+ *
+ * Threads claim batches of 8 candidates from a shared counter and run each
+ * batch in lockstep.
+ *
+ * @param l closed loop
+ * @param candidates gains
+ * @param threads number of threads, 0 for the hardware concurrency
+ * @return std::vector<metrics<T>> metrics per candidate
+ */
+template<typename T, size_t Nx>
+std::vector<metrics<T>> sweep(const loop<T, Nx> &l, const std::vector<gains<T>> &candidates, unsigned threads = 0) {
+  constexpr size_t K = 8;
+  const size_t n = candidates.size(), batches = (n + K - 1) / K;
+  std::vector<metrics<T>> m(n);
+
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    for (size_t b; (b = next.fetch_add(1)) < batches;) {
+      std::array<gains<T>, K> g;
+      for (size_t k = 0; k < K; k++)
+        g[k] = candidates[std::min(b * K + k, n - 1)];
+      auto r = simulate(l, g);
+      for (size_t k = 0; k < K && b * K + k < n; k++)
+        m[b * K + k] = r[k];
+    }
+  };
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < std::min<size_t>(threads, batches); t++)
+    pool.emplace_back(work);
+  for (auto &t : pool)
+    t.join();
+
+  return m;
+}
+
+/**
+ * Values from lo to hi, spaced geometrically when lo > 0 and linearly otherwise
+ *
+ * @param lo
+ * @param hi
+ * @param n number of values
+ * @return std::vector<T>
+ */
+template<typename T>
+std::vector<T> space(T lo, T hi, size_t n) {
+  std::vector<T> v(n, lo);
+  for (size_t i = 1; i < n; i++) {
+    T f = T(i) / T(n - 1);
+    v[i] = lo > 0 ? lo * std::pow(hi / lo, f) : lo + (hi - lo) * f;
+  }
+  return v;
+}
+
+/**
+ * All combinations of gains
+ *
+ * @return std::vector<gains<T>>
+ */
+template<typename T>
+std::vector<gains<T>> grid(const std::vector<T> &Kp, const std::vector<T> &Ti, const std::vector<T> &Td) {
+  std::vector<gains<T>> g;
+  g.reserve(Kp.size() * Ti.size() * Td.size());
+  for (auto p : Kp)
+    for (auto i : Ti)
+      for (auto d : Td)
+        g.push_back({p, i, d});
+  return g;
+}
+
+/**
+ * Default cost: integral of squared error
+ */
+template<typename T>
+T ise(const metrics<T> &m) {
+  return m.ise;
+}
+
+/**
+ * Best candidate of a sweep
+ *
+ * @param m metrics per candidate
+ * @param cost cost of metrics, lower is better
+ * @return size_t index of the best candidate
+ */
+template<typename T, typename F>
+size_t best(const std::vector<metrics<T>> &m, F cost) {
+  size_t b = 0;
+  for (size_t i = 1; i < m.size(); i++)
+    if (cost(m[i]) < cost(m[b]))
+      b = i;
+  return b;
+}
+
+/**
+ * Local search with the Nelder-Mead simplex method
+ *
+ * Searches the logarithms of Kp, Ti and Td, which keeps the gains positive and
+ * makes the steps relative. When x0.Td is zero, a PI controller is tuned and Td
+ * stays zero.
+ *
+ * @param l closed loop
+ * @param x0 initial gains
+ * @param cost cost of metrics, lower is better
+ * @param iterations maximum number of iterations
+ * @param tol relative spread of the simplex costs at which to stop
+ * @return gains<T>
+ */
+template<typename T, size_t Nx, typename F>
+gains<T> nelder_mead(const loop<T, Nx> &l, const gains<T> &x0, F cost, size_t iterations = 200, T tol = T(1e-6)) {
+  using P = Eigen::Matrix<T, 3, 1>;
+  const size_t n = x0.Td > 0 ? 3 : 2;
+
+  auto to = [n](const P &p) {
+    return gains<T>{std::exp(p(0)), std::exp(p(1)), n == 3 ? std::exp(p(2)) : T(0)};
+  };
+  auto f = [&](const P &p) {
+    return cost(simulate(l, to(p)));
+  };
+
+  // Initial simplex of steps of 20%
+  std::array<P, 4> s;
+  std::array<T, 4> c;
+  s[0] << std::log(x0.Kp), std::log(x0.Ti), n == 3 ? std::log(x0.Td) : T(0);
+  for (size_t i = 1; i <= n; i++) {
+    s[i] = s[0];
+    s[i](i - 1) += std::log(T(1.2));
+  }
+  for (size_t i = 0; i <= n; i++)
+    c[i] = f(s[i]);
+
+  for (size_t it = 0; it < iterations; it++) {
+    // Order best to worst
+    std::array<size_t, 4> o{0, 1, 2, 3};
+    std::sort(o.begin(), o.begin() + n + 1, [&c](size_t a, size_t b) { return c[a] < c[b]; });
+    std::array<P, 4> so;
+    std::array<T, 4> co;
+    for (size_t i = 0; i <= n; i++) {
+      so[i] = s[o[i]];
+      co[i] = c[o[i]];
+    }
+    s = so;
+    c = co;
+
+    if (std::abs(c[n] - c[0]) <= tol * std::abs(c[0]))
+      break;
+
+    P m = P::Zero();
+    for (size_t i = 0; i < n; i++)
+      m += s[i] / T(n);
+
+    P r = m + (m - s[n]);
+    T cr = f(r);
+    if (cr < c[0]) {
+      P e = m + 2 * (m - s[n]);
+      T ce = f(e);
+      s[n] = ce < cr ? e : r;
+      c[n] = std::min(ce, cr);
+    } else if (cr < c[n - 1]) {
+      s[n] = r;
+      c[n] = cr;
+    } else {
+      P k = cr < c[n] ? P(m + (r - m) / 2) : P(m + (s[n] - m) / 2);
+      T ck = f(k);
+      if (ck < std::min(cr, c[n])) {
+        s[n] = k;
+        c[n] = ck;
+      } else {
+        // Shrink towards the best
+        for (size_t i = 1; i <= n; i++) {
+          s[i] = s[0] + (s[i] - s[0]) / 2;
+          c[i] = f(s[i]);
+        }
+      }
+    }
+  }
+
+  return to(s[std::min_element(c.begin(), c.begin() + n + 1) - c.begin()]);
+}
+
+/**
+ * Ultimate gain and period of a plant
+ */
+template<typename T>
+struct ultimate {
+  T Ku;
+  T Tu;
+};
+
+/**
+ * Relay feedback experiment (Astrom-Hagglund)
+ *
+ * Closes the loop over the plant with a relay u = u0 +- h with hysteresis eps
+ * around the reference, lets the limit cycle settle and measures its period Tu
+ * and amplitude a over the last cycles. The describing function of the relay
+ * gives the ultimate gain Ku = 4h / (pi a). The plant starts from its zero
+ * state, so r and u0 should be an equilibrium, e.g. zero for a linear model.
+ *
+ * @param l closed loop, of which the plant, Ts, r and steps are used
+ * @param h relay amplitude
+ * @param eps relay hysteresis
+ * @param u0 relay bias
+ * @return ultimate<T> zero when no limit cycle was found
+ */
+template<typename T, size_t Nx>
+ultimate<T> relay(const loop<T, Nx> &l, T h, T eps = 0, T u0 = 0) {
+  using Tu = typename system::ss<T, Nx>::Tu;
+  auto plant = l.plant;
+  plant.x.setZero();
+
+  // Instants of switching down, and output extrema per cycle between them
+  std::vector<size_t> downs;
+  std::vector<T> amplitude;
+  bool high = true;
+  T y = 0, ymin = 0, ymax = 0;
+  for (size_t i = 0; i < l.steps; i++) {
+    T e = l.r - y;
+    if (high && e < -eps) {
+      high = false;
+      if (!downs.empty())
+        amplitude.push_back((ymax - ymin) / 2);
+      downs.push_back(i);
+      ymin = ymax = y;
+    } else if (!high && e > eps) {
+      high = true;
+    }
+    ymin = std::min(ymin, y);
+    ymax = std::max(ymax, y);
+    y = plant.step(Tu::Constant(high ? u0 + h : u0 - h))(0);
+  }
+
+  // Average over the second half of the cycles, after the transient
+  const size_t cycles = amplitude.size();
+  if (cycles < 4)
+    return {0, 0};
+  const size_t first = cycles / 2;
+  T period = T(downs.back() - downs[first]) * l.Ts / T(cycles - first);
+  T a = 0;
+  for (size_t i = first; i < cycles; i++)
+    a += amplitude[i] / T(cycles - first);
+
+  const T pi = T(std::acos(-1.));
+  return {4 * h / (pi * a), period};
+}
+
+/**
+ * Ziegler-Nichols PID gains from the ultimate gain and period
+ *
+ * @param u ultimate gain and period
+ * @return gains<T> Kp = 0.6 Ku, Ti = Tu / 2, Td = Tu / 8
+ */
+template<typename T>
+gains<T> ziegler_nichols(const ultimate<T> &u) {
+  return {T(0.6) * u.Ku, u.Tu / 2, u.Tu / 8};
+}
+
+}
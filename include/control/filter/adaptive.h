@@ -0,0 +1,490 @@
+/*
+ * Adaptive filters
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+
+#include <Eigen/Core>
+
+#include "control/filter/biquad.h"
+#include "control/filter/delay.h"
+#include "control/filter/fft.h"
+#include "control/filter/fir.h"
+
+namespace control::filter {
+
+namespace detail {
+
+/**
+ * Vectorized update a += c b of N contiguous values
+ */
+template<typename T, size_t N>
+void axpy(T *a, T c, const T *b) {
+  using V = Eigen::Matrix<T, int(N), 1>;
+  Eigen::Map<V>(a) += c * Eigen::Map<const V>(b);
+}
+
+/**
+ * Taps of an adaptive filter, newest input first, from its weights applied
+ * oldest first
+ */
+template<typename T, size_t N>
+std::array<T, N> newest_first(const T *w) {
+  std::array<T, N> h;
+  for (size_t k = 0; k < N; k++)
+    h[k] = w[N - 1 - k];
+  return h;
+}
+
+}
+
+/**
+ * Adaptive FIR filter, least mean squares
+ *
+ * Every step filters the reference x, compares the output with the desired
+ * signal d and moves the taps along the error times the window of inputs:
+ * w += mu e x. In vibration cancellation, x is a reference of the vibration
+ * and d the measurement it is to be removed from; the error is the cleaned
+ * signal. The filter and the update are each one vectorized pass over the
+ * taps.
+ *
+ *    Lms<float, 512> f(1e-4f);
+ *    float e = f.step(x, d);
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ */
+template<typename T, size_t N>
+class Lms {
+ public:
+  /**
+   * @param mu step size, below 2 / (N times the input power) for stability
+   */
+  explicit Lms(T mu) : mu(mu) {}
+
+  /**
+   * Step the filter and adapt its taps
+   *
+   * @param x reference input
+   * @param d desired output
+   * @return T error d - y
+   */
+  T step(T x, T d) {
+    line.push(x);
+    const T e = d - detail::dot<T, N>(w.data(), line.window());
+    detail::axpy<T, N>(w.data(), mu * e, line.window());
+    return e;
+  }
+
+  /**
+   * Process a block
+   *
+   * @param x n reference inputs
+   * @param d n desired outputs
+   * @param n number of samples
+   * @param e n errors, may alias x or d
+   */
+  void process(const T *x, const T *d, size_t n, T *e) {
+    for (size_t i = 0; i < n; i++)
+      e[i] = step(x[i], d[i]);
+  }
+
+  /**
+   * @return std::array<T, N> taps, h[0] applying to the newest input as in Fir
+   */
+  std::array<T, N> taps() const {
+    return detail::newest_first<T, N>(w.data());
+  }
+
+  /**
+   * Reset the taps and the inputs
+   */
+  void reset() {
+    w.fill(T(0));
+    line.reset();
+  }
+
+ protected:
+  T mu;
+  // Taps, oldest input first
+  std::array<T, N> w{};
+  DelayLine<T, N> line;
+};
+
+/**
+ * Adaptive FIR filter, normalized least mean squares
+ *
+ * As Lms with the step divided by the energy of the window of inputs,
+ * w += mu e x / (eps + x'x), which makes the convergence independent of the
+ * input level. The energy is kept up to date with the sample that enters and
+ * the one that leaves the window, and recomputed once every N samples so that
+ * rounding does not accumulate.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ */
+template<typename T, size_t N>
+class Nlms : public Lms<T, N> {
+ public:
+  /**
+   * @param mu step size, in (0, 2) for stability and 1 for the fastest convergence
+   * @param eps regularization of the energy
+   */
+  explicit Nlms(T mu, T eps = T(1e-6)) : Lms<T, N>(mu), eps(eps) {}
+
+  /**
+   * Step the filter and adapt its taps
+   *
+   * @param x reference input
+   * @param d desired output
+   * @return T error d - y
+   */
+  T step(T x, T d) {
+    const T old = line.window()[0];
+    line.push(x);
+    const T *v = line.window();
+    if (++t == N) {
+      t = 0;
+      p = detail::dot<T, N>(v, v);
+    } else {
+      p = std::max(p + x * x - old * old, T(0));
+    }
+    const T e = d - detail::dot<T, N>(w.data(), v);
+    detail::axpy<T, N>(w.data(), mu * e / (eps + p), v);
+    return e;
+  }
+
+  /**
+   * @see Lms::process()
+   */
+  void process(const T *x, const T *d, size_t n, T *e) {
+    for (size_t i = 0; i < n; i++)
+      e[i] = step(x[i], d[i]);
+  }
+
+  /**
+   * Reset the taps and the inputs
+   */
+  void reset() {
+    Lms<T, N>::reset();
+    p = 0;
+    t = 0;
+  }
+
+ protected:
+  using Lms<T, N>::mu;
+  using Lms<T, N>::w;
+  using Lms<T, N>::line;
+
+  T eps;
+  // Energy of the window, samples since it was recomputed
+  T p = 0;
+  size_t t = 0;
+};
+
+/**
+ * Adaptive FIR filter, block frequency-domain least mean squares
+ *
+ * Filters every sample in direct form, without latency, but updates the taps
+ * once per block of N samples. The gradient of the block, the correlation of
+ * its errors with the inputs, is computed with real FFTs of 2N points: the
+ * spectrum of the last two blocks of inputs and that of the errors, each
+ * product normalized by a running estimate of the input power in its bin,
+ * back to the time domain. The per-bin normalization converges on coloured
+ * references about as fast as Nlms does on white ones, and the update costs
+ * three FFTs per block instead of N multiply-adds per sample.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps and block size, a power of two
+ */
+template<typename T, size_t N>
+class FdLms {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "Block size must be a power of two");
+
+  using complex = std::complex<T>;
+  static constexpr size_t F = N + 1;
+ public:
+  /**
+   * @param mu step size, comparable to that of Nlms, below 1 for stability
+   * @param lambda forgetting factor of the power estimates, per block
+   * @param eps regularization of the power estimates, relative to their mean:
+   *            lower for faster convergence on broadband references, higher,
+   *            up to 1, for narrowband ones such as a few harmonics
+   */
+  explicit FdLms(T mu, T lambda = T(0.9), T eps = T(0.1)) : mu(mu), lambda(lambda), eps(eps) {}
+
+  /**
+   * Step the filter, and adapt its taps at the end of a block
+   *
+   * @param x reference input
+   * @param d desired output
+   * @return T error d - y
+   */
+  T step(T x, T d) {
+    line.push(x);
+    const T e = d - detail::dot<T, N>(w.data(), line.window());
+    in[N + t] = x;
+    err[t] = e;
+    if (++t == N) {
+      t = 0;
+      update();
+    }
+    return e;
+  }
+
+  /**
+   * @see Lms::process()
+   */
+  void process(const T *x, const T *d, size_t n, T *e) {
+    for (size_t i = 0; i < n; i++)
+      e[i] = step(x[i], d[i]);
+  }
+
+  /**
+   * @return std::array<T, N> taps, h[0] applying to the newest input as in Fir
+   */
+  std::array<T, N> taps() const {
+    return detail::newest_first<T, N>(w.data());
+  }
+
+  /**
+   * Reset the taps, the inputs and the power estimates
+   */
+  void reset() {
+    w.fill(T(0));
+    line.reset();
+    in.fill(T(0));
+    P.fill(T(0));
+    t = 0;
+    first = true;
+  }
+
+ protected:
+  T mu, lambda, eps;
+  // Taps, oldest input first
+  std::array<T, N> w{};
+  DelayLine<T, N> line;
+
+  RealFFT<T, 2 * N> fft;
+
+  // Previous and current block of inputs, errors of the current block
+  std::array<T, 2 * N> in{};
+  std::array<T, N> err{};
+  size_t t = 0;
+
+  // Input power per bin
+  std::array<T, F> P{};
+  bool first = true;
+
+  void update() {
+    std::array<complex, F> X, E;
+    fft.forward(in.data(), X.data());
+
+    std::array<T, 2 * N> buf;
+    std::fill_n(buf.begin(), N, T(0));
+    std::copy(err.begin(), err.end(), buf.begin() + N);
+    fft.forward(buf.data(), E.data());
+
+    T mean = 0;
+    for (size_t f = 0; f < F; f++) {
+      const T x2 = std::norm(X[f]);
+      P[f] = first ? x2 : lambda * P[f] + (1 - lambda) * x2;
+      mean += P[f] / F;
+    }
+    first = false;
+
+    // Bins without input power, such as between the lines of a periodic
+    // reference, would otherwise amplify the noise in the error without bound
+    const T floor = eps * mean + std::numeric_limits<T>::min();
+    for (size_t f = 0; f < F; f++)
+      E[f] = FFT<T, 2 * N>::mul(std::conj(X[f]), E[f]) * (T(1) / (floor + P[f]));
+
+    // Sample k of the correlation is the gradient of the tap on input n - k
+    fft.inverse(E.data(), buf.data());
+    for (size_t k = 0; k < N; k++)
+      w[N - 1 - k] += 2 * mu * buf[k];
+
+    std::copy(in.begin() + N, in.end(), in.begin());
+  }
+};
+
+/**
+ * Adaptive FIR filter, exponentially weighted recursive least squares
+ *
+ * Minimizes the weighted sum of all past squared errors exactly, with the
+ * inverse correlation matrix of the inputs updated each step. It converges in
+ * about 2N samples whatever the colour of the input, but costs O(N^2) per
+ * sample: meant for short filters and identification, Nlms and FdLms for long
+ * ones.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ */
+template<typename T, size_t N>
+class Rls {
+  using V = Eigen::Matrix<T, int(N), 1>;
+  using M = Eigen::Matrix<T, int(N), int(N)>;
+ public:
+  /**
+   * @param lambda forgetting factor, in (0, 1]
+   * @param delta initial inverse correlation, large for little prior knowledge
+   */
+  explicit Rls(T lambda = T(0.999), T delta = T(100)) : lambda(lambda), delta(delta) {
+    reset();
+  }
+
+  /**
+   * Step the filter and adapt its taps
+   *
+   * @param x reference input
+   * @param d desired output
+   * @return T error d - y, a priori
+   */
+  T step(T x, T d) {
+    line.push(x);
+    Eigen::Map<const V> v(line.window());
+    const V Pv = P * v;
+    const V k = Pv / (lambda + v.dot(Pv));
+    const T e = d - w.dot(v);
+    w += e * k;
+    P = (P - k * Pv.transpose()) / lambda;
+    return e;
+  }
+
+  /**
+   * @see Lms::process()
+   */
+  void process(const T *x, const T *d, size_t n, T *e) {
+    for (size_t i = 0; i < n; i++)
+      e[i] = step(x[i], d[i]);
+  }
+
+  /**
+   * @return std::array<T, N> taps, h[0] applying to the newest input as in Fir
+   */
+  std::array<T, N> taps() const {
+    return detail::newest_first<T, N>(w.data());
+  }
+
+  /**
+   * Reset the taps, the inputs and the inverse correlation
+   */
+  void reset() {
+    w.setZero();
+    P = delta * M::Identity();
+    line.reset();
+  }
+
+ protected:
+  T lambda, delta;
+  // Taps, oldest input first, and the inverse correlation of the inputs
+  V w;
+  M P;
+  DelayLine<T, N> line;
+};
+
+/**
+ * Adaptive notch filter
+ *
+ * Removes a sinusoid of unknown, drifting frequency. The notch is a
+ * Biquad<T, T> of fixed bandwidth, with unity gain away from the notch as
+ * design::notch(), and with its frequency parameter a = -2 cos(w) adapted
+ * each step by the normalized gradient of the squared output. The gradient
+ * follows from the removed component, the input minus the output, through
+ * the denominator of the notch; the biquad is retuned through coefficients()
+ * without trigonometry and without losing its state. Cascade one per
+ * harmonic.
+ *
+ *    AdaptiveNotch<float> n(0.1f, 0.01f);
+ *    float y = n.step(x);
+ *
+ * @tparam T arithmetic type
+ */
+template<typename T>
+class AdaptiveNotch {
+ public:
+  /**
+   * @param w initial notch frequency, normalized to the Nyquist frequency
+   * @param bw -3 dB bandwidth, normalized to the Nyquist frequency
+   * @param mu step size, in (0, 1)
+   * @param lambda forgetting factor of the gradient power
+   * @param eps regularization of the gradient power
+   */
+  AdaptiveNotch(T w, T bw, T mu = T(0.01), T lambda = T(0.99), T eps = T(1e-9))
+      : g(1 / (1 + std::tan(pi() * bw / 2))), a(-2 * std::cos(pi() * w)),
+        mu(mu), lambda(lambda), eps(eps), notch(coefficients()) {}
+
+  /**
+   * Filter a sample and adapt the notch frequency
+   *
+   * @param x input
+   * @return T output, with the sinusoid removed
+   */
+  T step(T x) {
+    const T y = notch.step(x);
+
+    // Derivative of y to a
+    const T s = g * (x1 - y1) - g * a * s1 - (2 * g - 1) * s2;
+    p = lambda * p + (1 - lambda) * s * s;
+    a = std::clamp(a - mu * y * s / (eps + p), T(-2), T(2));
+    notch.coefficients(coefficients());
+
+    x1 = x;
+    y1 = y;
+    s2 = s1;
+    s1 = s;
+    return y;
+  }
+
+  /**
+   * Process a block
+   *
+   * @param x n inputs
+   * @param n number of samples
+   * @param y n outputs, may alias x
+   */
+  void process(const T *x, size_t n, T *y) {
+    for (size_t i = 0; i < n; i++)
+      y[i] = step(x[i]);
+  }
+
+  /**
+   * @return T notch frequency, normalized to the Nyquist frequency
+   */
+  T frequency() const {
+    return std::acos(-a / 2) / pi();
+  }
+
+  /**
+   * @return const Biquad<T, T>& the notch as currently tuned
+   */
+  const Biquad<T, T> &filter() const {
+    return notch;
+  }
+
+ protected:
+  // Numerator gain 1 / (1 + alpha), frequency parameter -2 cos(w)
+  T g, a;
+  T mu, lambda, eps;
+  Biquad<T, T> notch;
+
+  // Previous input and output, gradient and gradient power
+  T x1 = 0, y1 = 0, s1 = 0, s2 = 0, p = 0;
+
+  sos<T> coefficients() const {
+    return {g, g * a, g, g * a, 2 * g - 1};
+  }
+
+  static T pi() {
+    return std::acos(T(-1));
+  }
+};
+
+}
@@ -0,0 +1,176 @@
+/*
+ * Banks of biquad cascades
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "control/filter/biquad.h"
+#include "control/system/denormal.h"
+
+namespace control::filter {
+
+/**
+ * Bank of K biquad cascades of N sections each
+ *
+ * Structure of arrays: coefficient c of section n of all channels is a
+ * contiguous run of K values at coefficients() + (c N + n) K, with c in b0, b1,
+ * b2, a1, a2 order, and state w of section n at state() + (w N + n) K. Every
+ * step runs the direct form II transposed section by section, vectorized over
+ * the channels. Memory is allocated on construction only.
+ *
+ * @tparam T arithmetic type
+ */
+template<typename T>
+class BiquadBank {
+  using V = Eigen::Array<T, Eigen::Dynamic, 1>;
+  using M = Eigen::Map<V>;
+ public:
+  /**
+   * Bank of pass-through sections with zero state
+   *
+   * @param K_ channels
+   * @param N_ sections per channel
+   */
+  BiquadBank(size_t K_, size_t N_) : K(K_), N(N_), c(5 * K_ * N_, T(0)), w(2 * K_ * N_, T(0)), tmp(2 * K_) {
+    for (size_t k = 0; k < K; k++)
+      for (size_t n = 0; n < N; n++)
+        section(k, n, {1, 0, 0, 0, 0});
+  }
+
+  /**
+   * Step all channels one sample
+   *
+   * @param x K inputs
+   * @param y K outputs, may alias x
+   */
+  void step(const T *x, T *y) {
+    M v(tmp.data(), K), o(tmp.data() + K, K);
+    v = Eigen::Map<const V>(x, K);
+    for (size_t n = 0; n < N; n++) {
+      M b0 = coeff(n, 0), b1 = coeff(n, 1), b2 = coeff(n, 2), a1 = coeff(n, 3), a2 = coeff(n, 4);
+      M w0(&w[n * K], K), w1(&w[(N + n) * K], K);
+      o = b0 * v + w0;
+      w0 = b1 * v - a1 * o + w1;
+      w1 = b2 * v - a2 * o;
+      v = o;
+    }
+    M(y, K) = v;
+  }
+
+  /**
+   * Process samples of all channels, interleaved: x[t K + k]
+   *
+   * @param x n K inputs
+   * @param n samples per channel
+   * @param y n K outputs, may alias x
+   */
+  void process(const T *x, size_t n, T *y) {
+    for (size_t t = 0; t < n; t++)
+      step(x + t * K, y + t * K);
+  }
+
+  /**
+   * @param k channel
+   * @param n section
+   * @return sos<T> coefficients
+   */
+  sos<T> section(size_t k, size_t n) const {
+    auto at = [&](size_t i) { return c[(i * N + n) * K + k]; };
+    return {at(0), at(1), at(2), at(3), at(4)};
+  }
+
+  /**
+   * Set the coefficients of one section
+   *
+   * @param k channel
+   * @param n section
+   * @param s coefficients
+   */
+  void section(size_t k, size_t n, const sos<T> &s) {
+    const T v[5] = {s.b0, s.b1, s.b2, s.a1, s.a2};
+    for (size_t i = 0; i < 5; i++)
+      c[(i * N + n) * K + k] = v[i];
+  }
+
+  /**
+   * Set channel k to the sections of a cascade, including its state
+   *
+   * @param k channel
+   * @param b cascade of at most N sections
+   */
+  template<typename S, size_t Ns>
+  void channel(size_t k, const BiquadCascade<Biquad<T, S>, Ns> &b) {
+    for (size_t n = 0; n < Ns && n < N; n++) {
+      section(k, n, b.sections()[n].coefficients());
+      auto s = b.sections()[n].state();
+      w[n * K + k] = s[0];
+      w[(N + n) * K + k] = s[1];
+    }
+  }
+
+  /**
+   * Reset the state of all channels
+   */
+  void reset() {
+    std::fill(w.begin(), w.end(), T(0));
+  }
+
+  /**
+   * Snap decaying states of all channels to zero
+   *
+   * @see Biquad::snap()
+   */
+  void snap() {
+    for (auto &v : w)
+      v = system::snap(v);
+  }
+
+  size_t channels() const {
+    return K;
+  }
+
+  size_t sections() const {
+    return N;
+  }
+
+  /**
+   * @return T* 5 N K coefficients
+   */
+  T *coefficients() {
+    return c.data();
+  }
+
+  const T *coefficients() const {
+    return c.data();
+  }
+
+  /**
+   * @return T* 2 N K states
+   */
+  T *state() {
+    return w.data();
+  }
+
+  const T *state() const {
+    return w.data();
+  }
+
+ protected:
+  size_t K, N;
+  std::vector<T> c, w;
+
+  // Section input and output of all channels
+  std::vector<T> tmp;
+
+  M coeff(size_t n, size_t i) {
+    return M(&c[(i * N + n) * K], K);
+  }
+};
+
+}
@@ -5,9 +5,11 @@
 #pragma once
 
 #include <array>
+#include <cmath>
 #include <complex>
 #include <tuple>
 
+#include "control/system/denormal.h"
 #include "control/system/type.h"
 
 namespace control::filter {
@@ -18,6 +20,16 @@ using TC = std::complex<T>;
 template<typename T = float>
 using TCS = std::pair<TC<T>, TC<T>>;
 
+/**
+ * Normalized coefficients of a second-order section
+ *
+ * @tparam T arithmetic type
+ */
+template<typename T = float>
+struct sos {
+  T b0, b1, b2, a1, a2;
+};
+
 /**
  * Biquad
  *
@@ -60,6 +72,14 @@ class Biquad : public system::SISO<T> {
    */
   Biquad(T b0, T b1, T b2, T a0, T a1, T a2) : B{b0 / a0, b1 / a0, b2 / a0}, A{a1 / a0, a2 / a0} {};
 
+  /**
+   * Initialize a biquad with a normalized second-order section
+   *
+   * @param sos<U> c coefficients, rounded to T
+   */
+  template<typename U>
+  Biquad(const sos<U> &c) : B{T(c.b0), T(c.b1), T(c.b2)}, A{T(c.a1), T(c.a2)} {};
+
   /**
    * Initialize a biquad with ZPK
    *
@@ -89,6 +109,29 @@ class Biquad : public system::SISO<T> {
     return y;
   }
 
+  /**
+   * Coefficients of the biquad
+   *
+   * @return sos<T>
+   */
+  sos<T> coefficients() const {
+    return {B[0], B[1], B[2], A[0], A[1]};
+  }
+
+  /**
+   * Update the coefficients of the biquad, retaining its state
+   *
+   * @param sos<T> c coefficients
+   */
+  void coefficients(const sos<T> &c) {
+    static_assert(!std::is_const<S>::value, "Storage type S must be non-const to update coefficients.");
+    B[0] = c.b0;
+    B[1] = c.b1;
+    B[2] = c.b2;
+    A[0] = c.a1;
+    A[1] = c.a2;
+  }
+
   /**
    * Poles of the biquad
    *
@@ -114,26 +157,58 @@ class Biquad : public system::SISO<T> {
   /**
    * Stability of the biquad
    *
-   * Checks stability through evaluating the magnitude of the poles
+   * Checks that the magnitude of both poles is leq unity with the Jury
+   * criterion on the denominator, |a2| <= 1 and |a1| <= 1 + a2, without
+   * solving for the poles. The closed unit disc counts, so marginally stable
+   * sections such as PID integrators are stable; system::asymptotically_stable()
+   * requires the open disc for sections and state-spaces alike, and
+   * system::margins() tells marginal cases apart.
    *
    * @return bool whether stable
    */
-  bool stable() {
-    auto p = poles();
-
-    // Whether the magnitude of both poles is leq unity
-    return abs(std::get<0>(p)) <= (T) 1
-        && abs(std::get<1>(p)) <= (T) 1;
+  bool stable() const {
+    using std::abs;
+    return abs(A[1]) <= (T) 1
+        && abs(A[0]) <= (T) 1 + A[1];
   }
 
   /**
    * Reset the biquad
    */
-  void reset() {
+  virtual void reset() {
     wz[0] = 0;
     wz[1] = 0;
   }
 
+  /**
+   * Snap decaying states to zero before they become subnormal
+   *
+   * Call at least once per block of samples while the input may fall silent.
+   */
+  virtual void snap() {
+    wz[0] = system::snap(wz[0]);
+    wz[1] = system::snap(wz[1]);
+  }
+
+  /**
+   * State of the direct form II transposed, e.g. to checkpoint it
+   *
+   * @return std::array<T, 2>
+   */
+  std::array<T, 2> state() const {
+    return {wz[0], wz[1]};
+  }
+
+  /**
+   * Restore the state
+   *
+   * @param w state as returned by state()
+   */
+  void state(const std::array<T, 2> &w) {
+    wz[0] = w[0];
+    wz[1] = w[1];
+  }
+
  protected:
 
   /**
@@ -217,6 +292,159 @@ class Biquad : public system::SISO<T> {
 
 };
 
+/**
+ * Biquad with compile-time coefficients
+ *
+ * Same transfer function and realization (Direct form II transposed) as Biquad,
+ * but the coefficients are constants of the type. Products with coefficients of
+ * zero and one are removed at compile-time, as is state that stays zero, so
+ * sparse sections like notches, differentiators and pass-throughs cost only
+ * the operations they need.
+ *
+ * The coefficients are given by a type C with a constant member `value`
+ * convertible to sos<T>:
+ *
+ *    struct notch { static constexpr sos<double> value{1, 0, 1, 0, 0.5}; };
+ *    StaticBiquad<float, notch> b;
+ *
+ * @tparam T arithmetic type
+ * @tparam C coefficient type
+ */
+template<typename T, typename C>
+class StaticBiquad : public system::SISO<T> {
+  // b0, b1, b2, -a1, -a2
+  static constexpr T k[5] = {T(C::value.b0), T(C::value.b1), T(C::value.b2), -T(C::value.a1), -T(C::value.a2)};
+
+  // Number of non-trivial states
+  static constexpr size_t order = (k[2] != 0 || k[4] != 0) ? 2 : (k[1] != 0 || k[3] != 0) ? 1 : 0;
+
+ public:
+  /**
+   * Step the biquad
+   *
+   * @param T x input value
+   * @return T output value
+   */
+  T step(T x) {
+    T y;
+
+    /* Direct form II transposed */
+    if constexpr (order == 0) {
+      y = mul<0>(x);
+    } else {
+      y = madd<0>(wz[0], x);
+    }
+
+    if constexpr (order == 2) {
+      wz[0] = madd<3>(madd<1>(wz[1], x), y);
+      if constexpr (k[2] != 0)
+        wz[1] = madd<4>(mul<2>(x), y);
+      else
+        wz[1] = mul<4>(y);
+    } else if constexpr (order == 1) {
+      if constexpr (k[1] != 0)
+        wz[0] = madd<3>(mul<1>(x), y);
+      else
+        wz[0] = mul<3>(y);
+    }
+
+    return y;
+  }
+
+  /**
+   * Coefficients of the biquad
+   *
+   * @return sos<T>
+   */
+  static constexpr sos<T> coefficients() {
+    return {k[0], k[1], k[2], -k[3], -k[4]};
+  }
+
+  /**
+   * Poles of the biquad
+   *
+   * @see Biquad::poles()
+   * @return TCS<T>
+   */
+  TCS<T> poles() {
+    return Biquad<T>(coefficients()).poles();
+  }
+
+  /**
+   * Zeros of the biquad
+   *
+   * @see Biquad::zeros()
+   * @return TCS<T>
+   */
+  TCS<T> zeros() {
+    return Biquad<T>(coefficients()).zeros();
+  }
+
+  /**
+   * Stability of the biquad
+   *
+   * @see Biquad::stable()
+   * @return bool whether stable
+   */
+  bool stable() {
+    return Biquad<T>(coefficients()).stable();
+  }
+
+  /**
+   * Reset the biquad
+   */
+  void reset() {
+    wz[0] = 0;
+    wz[1] = 0;
+  }
+
+  /**
+   * Snap decaying states to zero before they become subnormal
+   *
+   * @see Biquad::snap()
+   */
+  void snap() {
+    wz[0] = system::snap(wz[0]);
+    wz[1] = system::snap(wz[1]);
+  }
+
+ protected:
+
+  /**
+   * State variables
+   * @var T[]
+   */
+  T wz[2] = {0, 0};
+
+  /**
+   * Product of coefficient I and v, for non-zero coefficients
+   */
+  template<size_t I>
+  static T mul(T v) {
+    if constexpr (k[I] == 1)
+      return v;
+    else if constexpr (k[I] == -1)
+      return -v;
+    else
+      return k[I] * v;
+  }
+
+  /**
+   * Accumulate the product of coefficient I and v
+   */
+  template<size_t I>
+  static T madd(T acc, T v) {
+    if constexpr (k[I] == 0)
+      return acc;
+    else if constexpr (k[I] == 1)
+      return acc + v;
+    else if constexpr (k[I] == -1)
+      return acc - v;
+    else
+      return acc + k[I] * v;
+  }
+};
+
 /**
  * Type traits for deducing the typename of T and S of a biquad
  * @tparam T
@@ -268,6 +496,30 @@ class BiquadCascade : public system::SISO<typename inspect_types<B>::arithmetic_
     return u;
   }
 
+  /**
+   * Snap decaying states of all biquads to zero
+   *
+   * @see Biquad::snap()
+   */
+  void snap() {
+    for (auto &b : bs)
+      b.snap();
+  }
+
+  /**
+   * @return BS& the sections, in order of application
+   */
+  BS &sections() {
+    return bs;
+  }
+
+  /**
+   * @return const BS& the sections, in order of application
+   */
+  const BS &sections() const {
+    return bs;
+  }
+
  protected:
 
   /**
@@ -276,5 +528,59 @@ class BiquadCascade : public system::SISO<typename inspect_types<B>::arithmetic_
   BS bs;
 };
 
+/**
+ * Chain of biquads of different types
+ *
+ * Like BiquadCascade, but each section can be a different biquad type,
+ * for instance a StaticBiquad followed by a run-time Biquad.
+ *
+ * @tparam Bs biquad classes, in order of application
+ */
+template<typename... Bs>
+class BiquadChain
+    : public system::SISO<typename inspect_types<std::tuple_element_t<0, std::tuple<Bs...>>>::arithmetic_type> {
+  using T = typename inspect_types<std::tuple_element_t<0, std::tuple<Bs...>>>::arithmetic_type;
+ public:
+
+  /**
+   * Initialize chain with default-constructed biquads
+   */
+  BiquadChain() = default;
+
+  /**
+   * Initialize chain with biquads
+   *
+   * @param bs biquads
+   */
+  BiquadChain(Bs... bs) : bs{bs...} {}
+
+  /**
+   * Step the biquad chain one time
+   *
+   * @param u T input
+   * @return T output
+   */
+  T step(T u) {
+    std::apply([&u](auto &... b) { ((u = b.step(u)), ...); }, bs);
+    return u;
+  }
+
+  /**
+   * Snap decaying states of all biquads to zero
+   *
+   * @see Biquad::snap()
+   */
+  void snap() {
+    std::apply([](auto &... b) { (b.snap(), ...); }, bs);
+  }
+
+ protected:
+
+  /**
+   * Container of biquads
+   */
+  std::tuple<Bs...> bs;
+};
+
 }
 
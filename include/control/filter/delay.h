@@ -0,0 +1,82 @@
+/*
+ * Delay line
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace control::filter {
+
+/**
+ * Delay line
+ *
+ * Keeps the last N samples contiguous in memory without shifting and without
+ * a modulo in the hot path: every sample is written twice, N apart, into a
+ * buffer of 2N. The window of the last N samples then always starts at the
+ * write position.
+ *
+ * @tparam T arithmetic type
+ * @tparam N length
+ */
+template<typename T, size_t N>
+class DelayLine {
+  static_assert(N > 0, "Delay line must hold at least one sample");
+ public:
+  /**
+   * Push a sample, dropping the oldest
+   *
+   * @param x sample
+   */
+  void push(T x) {
+    buf[i] = x;
+    buf[i + N] = x;
+    if (++i == N)
+      i = 0;
+  }
+
+  /**
+   * Window of the last N samples, oldest first and newest last
+   *
+   * @return const T* pointer to N contiguous samples
+   */
+  const T *window() const {
+    return &buf[i];
+  }
+
+  /**
+   * Inner product of the window with N coefficients
+   *
+   * @param h coefficients, applied oldest first
+   * @return T
+   */
+  T dot(const T *h) const {
+    const T *w = window();
+    T acc[4] = {0, 0, 0, 0};
+    size_t k = 0;
+    for (; k + 4 <= N; k += 4) {
+      acc[0] += h[k] * w[k];
+      acc[1] += h[k + 1] * w[k + 1];
+      acc[2] += h[k + 2] * w[k + 2];
+      acc[3] += h[k + 3] * w[k + 3];
+    }
+    for (; k < N; k++)
+      acc[0] += h[k] * w[k];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+  }
+
+  /**
+   * Clear the delay line
+   */
+  void reset() {
+    buf.fill(T(0));
+    i = 0;
+  }
+
+ protected:
+  std::array<T, 2 * N> buf{};
+  size_t i = 0;
+};
+
+}
@@ -0,0 +1,501 @@
+/*
+ * IIR filter design
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include "control/filter/biquad.h"
+
+namespace control::filter::design {
+
+/**
+ * Pass-band of a design
+ */
+enum class pass {
+  low,
+  high
+};
+
+/**
+ * Zeros, poles and gain
+ *
+ * Holds up to N zeros and exactly N poles. Zeros beyond nz are at infinity.
+ *
+ * @tparam T arithmetic type
+ * @tparam N order
+ */
+template<typename T, size_t N>
+struct zpk {
+  std::array<TC<T>, N> z;
+  std::array<TC<T>, N> p;
+  size_t nz;
+  T k;
+};
+
+namespace detail {
+
+template<typename T>
+constexpr T pi = T(3.14159265358979323846264338327950288L);
+
+// Number of descending Landen moduli, sufficient for double precision
+constexpr size_t landen_steps = 7;
+
+/**
+ * Descending Landen sequence of elliptic moduli
+ */
+template<typename T>
+std::array<T, landen_steps> landen(T k) {
+  std::array<T, landen_steps> v{};
+  for (auto &vn : v) {
+    k = std::pow(k / (1 + std::sqrt(1 - k * k)), 2);
+    vn = k;
+  }
+  return v;
+}
+
+/**
+ * Complete elliptic integral of the first kind, by the arithmetic-geometric mean
+ */
+template<typename T>
+T ellipk(T k) {
+  T a = 1, b = std::sqrt(1 - k * k);
+  for (size_t i = 0; i < 32 && std::abs(a - b) > std::numeric_limits<T>::epsilon() * a; i++)
+    std::tie(a, b) = std::make_pair((a + b) / 2, std::sqrt(a * b));
+  return pi<T> / (2 * a);
+}
+
+/**
+ * Jacobi elliptic cd, with argument normalized to the quarter period
+ */
+template<typename T>
+TC<T> cde(TC<T> u, T k) {
+  auto v = landen(k);
+  TC<T> w = std::cos(u * pi<T> / T(2));
+  for (auto n = v.rbegin(); n != v.rend(); n++)
+    w = (1 + *n) * w / (T(1) + *n * w * w);
+  return w;
+}
+
+/**
+ * Jacobi elliptic sn, with argument normalized to the quarter period
+ */
+template<typename T>
+TC<T> sne(TC<T> u, T k) {
+  auto v = landen(k);
+  TC<T> w = std::sin(u * pi<T> / T(2));
+  for (auto n = v.rbegin(); n != v.rend(); n++)
+    w = (1 + *n) * w / (T(1) + *n * w * w);
+  return w;
+}
+
+/**
+ * Inverse of cde
+ */
+template<typename T>
+TC<T> acde(TC<T> w, T k) {
+  auto v = landen(k);
+  T v1 = k;
+  for (auto vn : v) {
+    w = w / (T(1) + std::sqrt(T(1) - w * w * v1 * v1)) * T(2) / (1 + vn);
+    v1 = vn;
+  }
+  TC<T> u = T(2) / pi<T> * std::acos(w);
+
+  // Reduce to the fundamental period rectangle
+  auto srem = [](T x, T y) { return x - y * std::round(x / y); };
+  T R = ellipk(std::sqrt(1 - k * k)) / ellipk(k);
+  return {srem(u.real(), 4), srem(u.imag(), 2 * R)};
+}
+
+/**
+ * Inverse of sne
+ */
+template<typename T>
+TC<T> asne(TC<T> w, T k) {
+  return T(1) - acde(w, k);
+}
+
+/**
+ * Solve the degree equation for the elliptic modulus
+ */
+template<size_t N, typename T>
+T ellipdeg(T k1) {
+  T kc = std::sqrt(1 - k1 * k1);
+  T kp = std::pow(kc, T(N));
+  for (size_t i = 1; i <= N / 2; i++)
+    kp *= std::pow(sne(TC<T>(T(2 * i - 1) / N), kc).real(), 4);
+  return std::sqrt(1 - kp * kp);
+}
+
+template<typename T>
+bool isreal(TC<T> c) {
+  return std::abs(c.imag()) <= 100 * std::numeric_limits<T>::epsilon() * std::abs(c);
+}
+
+template<typename T, size_t N>
+T realprod(const std::array<TC<T>, N> &c, size_t n, TC<T> s, T sign) {
+  TC<T> r = 1;
+  for (size_t i = 0; i < n; i++)
+    r *= s + sign * c[i];
+  return r.real();
+}
+
+template<typename B, typename T, size_t N, size_t... I>
+BiquadCascade<B, N> cascade(const std::array<sos<T>, N> &s, std::index_sequence<I...>) {
+  return BiquadCascade<B, N>(B(s[I])...);
+}
+
+}
+
+/**
+ * Analog Butterworth prototype with unity cut-off
+ *
+ * @tparam N order
+ * @tparam T arithmetic type
+ */
+template<size_t N, typename T>
+zpk<T, N> butter_analog() {
+  zpk<T, N> a{{}, {}, 0, 1};
+  for (size_t i = 0; i < N; i++)
+    a.p[i] = std::polar(T(1), detail::pi<T> * (2 * i + N + 1) / (2 * N));
+  return a;
+}
+
+/**
+ * Analog Chebyshev type I prototype with unity pass-band edge
+ *
+ * @tparam N order
+ * @tparam T arithmetic type
+ * @param rp pass-band ripple (dB)
+ */
+template<size_t N, typename T>
+zpk<T, N> cheby1_analog(T rp) {
+  zpk<T, N> a{{}, {}, 0, 1};
+  T eps = std::sqrt(std::pow(T(10), rp / 10) - 1);
+  T mu = std::asinh(1 / eps) / N;
+  for (size_t i = 0; i < N; i++) {
+    T th = detail::pi<T> * (2 * i + 1) / (2 * N);
+    a.p[i] = {-std::sinh(mu) * std::sin(th), std::cosh(mu) * std::cos(th)};
+  }
+  a.k = detail::realprod(a.p, N, TC<T>(0), T(-1));
+  if (N % 2 == 0)
+    a.k /= std::sqrt(1 + eps * eps);
+  return a;
+}
+
+/**
+ * Analog elliptic (Cauer) prototype with unity pass-band edge
+ *
+ * Follows S. J. Orfanidis, Lecture Notes on Elliptic Filter Design, 2006.
+ *
+ * @tparam N order
+ * @tparam T arithmetic type
+ * @param rp pass-band ripple (dB)
+ * @param rs stop-band attenuation (dB)
+ */
+template<size_t N, typename T>
+zpk<T, N> ellip_analog(T rp, T rs) {
+  zpk<T, N> a{{}, {}, 0, 1};
+  T ep = std::sqrt(std::pow(T(10), rp / 10) - 1);
+  T es = std::sqrt(std::pow(T(10), rs / 10) - 1);
+  T k1 = ep / es;
+  T k = detail::ellipdeg<N>(k1);
+
+  TC<T> j(0, 1);
+  TC<T> v0 = -j * detail::asne(j / ep, k1) / T(N);
+
+  size_t n = 0;
+  for (size_t i = 1; i <= N / 2; i++) {
+    T u = T(2 * i - 1) / N;
+    TC<T> z = j / (k * detail::cde(TC<T>(u), k));
+    TC<T> p = j * detail::cde(u - j * v0, k);
+    a.z[n] = z;
+    a.z[n + 1] = std::conj(z);
+    a.p[n] = p;
+    a.p[n + 1] = std::conj(p);
+    n += 2;
+  }
+  a.nz = n;
+  if (N % 2)
+    a.p[n] = (j * detail::sne(j * v0, k)).real();
+
+  // Unity gain at DC for odd, pass-band ripple for even order
+  a.k = detail::realprod(a.p, N, TC<T>(0), T(-1)) / detail::realprod(a.z, a.nz, TC<T>(0), T(-1));
+  if (N % 2 == 0)
+    a.k /= std::sqrt(1 + ep * ep);
+  return a;
+}
+
+/**
+ * Bilinear transform of an analog prototype with prewarped cut-off
+ *
+ * Moves the unity edge of the prototype to w and maps the result to the z-domain.
+ * Zeros at infinity end up at z = -1 (low-pass) or z = 1 (high-pass).
+ *
+ * @param a analog prototype
+ * @param w cut-off frequency normalized to the Nyquist frequency, 0 < w < 1
+ * @param type pass-band
+ * @return zpk<T, N> digital zeros, poles and gain
+ */
+template<typename T, size_t N>
+zpk<T, N> bilinear(zpk<T, N> a, T w, pass type = pass::low) {
+  T c = std::tan(detail::pi<T> * w / 2);
+
+  if (type == pass::low) {
+    for (size_t i = 0; i < a.nz; i++)
+      a.z[i] *= c;
+    for (auto &p : a.p)
+      p *= c;
+    a.k *= std::pow(c, T(N - a.nz));
+  } else {
+    a.k *= detail::realprod(a.z, a.nz, TC<T>(0), T(-1)) / detail::realprod(a.p, N, TC<T>(0), T(-1));
+    for (size_t i = 0; i < a.nz; i++)
+      a.z[i] = c / a.z[i];
+    for (auto &p : a.p)
+      p = c / p;
+    for (; a.nz < N; a.nz++)
+      a.z[a.nz] = 0;
+  }
+
+  // s = (z - 1) / (z + 1)
+  a.k *= detail::realprod(a.z, a.nz, TC<T>(1), T(-1)) / detail::realprod(a.p, N, TC<T>(1), T(-1));
+  for (size_t i = 0; i < a.nz; i++)
+    a.z[i] = (T(1) + a.z[i]) / (T(1) - a.z[i]);
+  for (auto &p : a.p)
+    p = (T(1) + p) / (T(1) - p);
+  for (; a.nz < N; a.nz++)
+    a.z[a.nz] = -1;
+
+  return a;
+}
+
+namespace detail {
+
+/**
+ * Pair np > 0 poles and nz <= np finite zeros into (np + 1) / 2 second-order sections
+ *
+ * Zeros beyond nz are at infinity and appear as leading zero coefficients of
+ * the numerators, i.e. as delays. zused and pused are scratch flags of nz and
+ * np entries.
+ *
+ * @see zpk2sos
+ */
+template<typename T>
+void zpk2sos(const TC<T> *z, size_t nz, const TC<T> *p, size_t np, T k, bool *zused, bool *pused, sos<T> *s) {
+  enum { any, real, complex };
+  const size_t M = (np + 1) / 2;
+  std::fill(zused, zused + nz, false);
+  std::fill(pused, pused + np, false);
+
+  // Take the remaining root closest to r, preferring the conjugate of r
+  auto take = [](const TC<T> *c, size_t n, bool *used, TC<T> r, int kind) {
+    size_t best = n;
+    for (size_t i = 0; i < n; i++) {
+      if (used[i] || (kind == real && !isreal(c[i])) || (kind == complex && isreal(c[i])))
+        continue;
+      if (best == n || std::abs(c[i] - r) < std::abs(c[best] - r))
+        best = i;
+    }
+    if (best < n)
+      used[best] = true;
+    return best;
+  };
+
+  auto poly = [](TC<T> r1, TC<T> r2) {
+    return std::make_pair(-(r1 + r2).real(), (r1 * r2).real());
+  };
+
+  for (size_t m = M; m-- > 0;) {
+    s[m] = {};
+
+    // Pole closest to the unit circle
+    size_t p1 = np;
+    for (size_t i = 0; i < np; i++)
+      if (!pused[i] && (p1 == np || 1 - std::abs(p[i]) < 1 - std::abs(p[p1])))
+        p1 = i;
+    pused[p1] = true;
+
+    // Its conjugate, or the nearest real pole
+    bool r = isreal(p[p1]);
+    size_t p2 = take(p, np, pused, r ? p[p1] : std::conj(p[p1]), r ? real : any);
+
+    if (p2 == np) {
+      // First-order section with a real zero, or one at infinity
+      s[m].a1 = -p[p1].real();
+      size_t z1 = take(z, nz, zused, p[p1], real);
+      if (z1 < nz) {
+        s[m].b0 = 1;
+        s[m].b1 = -z[z1].real();
+      } else {
+        s[m].b1 = 1;
+      }
+      continue;
+    }
+
+    std::tie(s[m].a1, s[m].a2) = poly(p[p1], p[p2]);
+
+    // Zeros nearest to the pole: a conjugate pair or two real zeros
+    size_t z1 = take(z, nz, zused, p[p1], any), z2 = nz;
+    if (z1 < nz && isreal(z[z1])) {
+      z2 = take(z, nz, zused, p[p1], real);
+      if (z2 == nz) {
+        size_t c = take(z, nz, zused, p[p1], complex);
+        if (c < nz) {
+          zused[z1] = false;
+          z1 = c;
+        }
+      }
+    }
+    if (z1 < nz && !isreal(z[z1]))
+      z2 = take(z, nz, zused, std::conj(z[z1]), any);
+
+    if (z2 < nz) {
+      s[m].b0 = 1;
+      std::tie(s[m].b1, s[m].b2) = poly(z[z1], z[z2]);
+    } else if (z1 < nz) {
+      s[m].b1 = 1;
+      s[m].b2 = -z[z1].real();
+    } else {
+      s[m].b2 = 1;
+    }
+  }
+
+  s[0].b0 *= k;
+  s[0].b1 *= k;
+  s[0].b2 *= k;
+}
+
+}
+
+/**
+ * Pair digital zeros and poles into second-order sections
+ *
+ * Repeatedly takes the remaining pole closest to the unit circle together with
+ * its conjugate and the zeros nearest to it. These sections are placed last, so
+ * the cascade is ordered by increasing pole radius (increasing Q), which keeps
+ * internal peaking and noise gain low. The gain is applied to the first section.
+ * Zeros beyond nz are at infinity and become delays in the numerators.
+ *
+ * @param d digital zeros, poles and gain
+ * @return std::array<sos<T>, (N + 1) / 2>
+ */
+template<typename T, size_t N>
+std::array<sos<T>, (N + 1) / 2> zpk2sos(zpk<T, N> d) {
+  std::array<sos<T>, (N + 1) / 2> s{};
+  std::array<bool, N> zused{}, pused{};
+  detail::zpk2sos(d.z.data(), d.nz, d.p.data(), N, d.k, zused.data(), pused.data(), s.data());
+  return s;
+}
+
+/**
+ * Butterworth filter
+ *
+ * @tparam N order
+ * @param w cut-off frequency normalized to the Nyquist frequency
+ * @param type pass-band
+ * @return std::array<sos<T>, (N + 1) / 2> second-order sections
+ */
+template<size_t N, typename T>
+std::array<sos<T>, (N + 1) / 2> butter(T w, pass type = pass::low) {
+  return zpk2sos(bilinear(butter_analog<N, T>(), w, type));
+}
+
+/**
+ * Chebyshev type I filter
+ *
+ * @tparam N order
+ * @param rp pass-band ripple (dB)
+ * @param w pass-band edge normalized to the Nyquist frequency
+ * @param type pass-band
+ * @return std::array<sos<T>, (N + 1) / 2> second-order sections
+ */
+template<size_t N, typename T>
+std::array<sos<T>, (N + 1) / 2> cheby1(T rp, T w, pass type = pass::low) {
+  return zpk2sos(bilinear(cheby1_analog<N, T>(rp), w, type));
+}
+
+/**
+ * Elliptic (Cauer) filter
+ *
+ * @tparam N order
+ * @param rp pass-band ripple (dB)
+ * @param rs stop-band attenuation (dB)
+ * @param w pass-band edge normalized to the Nyquist frequency
+ * @param type pass-band
+ * @return std::array<sos<T>, (N + 1) / 2> second-order sections
+ */
+template<size_t N, typename T>
+std::array<sos<T>, (N + 1) / 2> ellip(T rp, T rs, T w, pass type = pass::low) {
+  return zpk2sos(bilinear(ellip_analog<N, T>(rp, rs), w, type));
+}
+
+/**
+ * Notch filter
+ *
+ * Second-order notch with unity gain away from the notch. Cheap enough to
+ * retune at run-time through Biquad<T, T>::coefficients().
+ *
+ * @param w notch frequency normalized to the Nyquist frequency
+ * @param Q quality factor, the ratio of w to the -3 dB bandwidth
+ * @return sos<T>
+ */
+template<typename T>
+sos<T> notch(T w, T Q) {
+  T c = std::cos(detail::pi<T> * w);
+  T alpha = std::sin(detail::pi<T> * w) / (2 * Q);
+  T a0 = 1 + alpha;
+  return {1 / a0, -2 * c / a0, 1 / a0, -2 * c / a0, (1 - alpha) / a0};
+}
+
+/**
+ * Cascade of biquads from second-order sections
+ *
+ * @param s sections
+ * @return BiquadCascade<Biquad<T>, N>
+ */
+template<typename T, size_t N>
+BiquadCascade<Biquad<T>, N> cascade(const std::array<sos<T>, N> &s) {
+  return detail::cascade<Biquad<T>>(s, std::make_index_sequence<N>());
+}
+
+/**
+ * Cascade of biquads of type B from second-order sections
+ *
+ * Allows designing in double and filtering in another type or realization:
+ *
+ *    auto lp = cascade<BiquadSVF<float>>(butter<4>(0.001));
+ *
+ * @tparam B biquad class
+ * @param s sections
+ * @return BiquadCascade<B, N>
+ */
+template<typename B, typename T, size_t N>
+BiquadCascade<B, N> cascade(const std::array<sos<T>, N> &s) {
+  return detail::cascade<B>(s, std::make_index_sequence<N>());
+}
+
+/**
+ * Frequency response of second-order sections
+ *
+ * @param s sections
+ * @param w frequency normalized to the Nyquist frequency
+ * @return TC<T> complex gain
+ */
+template<typename T, size_t N>
+TC<T> freqz(const std::array<sos<T>, N> &s, T w) {
+  TC<T> z1 = std::polar(T(1), -detail::pi<T> * w);
+  TC<T> h = 1;
+  for (auto &c : s)
+    h *= (c.b0 + (c.b1 + c.b2 * z1) * z1) / (T(1) + (c.a1 + c.a2 * z1) * z1);
+  return h;
+}
+
+}
@@ -0,0 +1,168 @@
+/*
+ * Fast Fourier transform
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+
+namespace control::filter {
+
+/**
+ * Radix-2 complex FFT of fixed size
+ *
+ * Twiddles and the bit-reversal permutation are computed once, in double
+ * precision. Transforms are in-place and do not allocate.
+ *
+ * @tparam T arithmetic type
+ * @tparam N size, a power of two
+ */
+template<typename T, size_t N>
+class FFT {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "FFT size must be a power of two");
+ public:
+  using complex = std::complex<T>;
+
+  FFT() {
+    const double pi = std::acos(-1.);
+    for (size_t k = 0; k < N / 2; k++) {
+      auto w = std::polar(1., -2 * pi * double(k) / double(N));
+      tw[k] = complex(T(w.real()), T(w.imag()));
+    }
+    for (size_t i = 0, j = 0; i < N; i++) {
+      rev[i] = j;
+      size_t bit = N >> 1;
+      for (; j & bit; bit >>= 1)
+        j ^= bit;
+      j |= bit;
+    }
+  }
+
+  /**
+   * Forward transform, X[k] = sum_n x[n] e^(-2 pi i k n / N)
+   *
+   * @param x N values, replaced by their spectrum
+   */
+  void forward(complex *x) const {
+    transform(x, false);
+  }
+
+  /**
+   * Inverse transform, including the 1/N scaling
+   *
+   * @param x N spectral values, replaced by the signal
+   */
+  void inverse(complex *x) const {
+    transform(x, true);
+    for (size_t i = 0; i < N; i++)
+      x[i] *= T(1) / T(N);
+  }
+
+  /**
+   * Product without the NaN and infinity recovery of std::complex
+   *
+   * @param a
+   * @param b
+   * @return complex a b
+   */
+  static complex mul(const complex &a, const complex &b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+  }
+
+ protected:
+  std::array<complex, N / 2> tw;
+  std::array<size_t, N> rev;
+
+  void transform(complex *x, bool inv) const {
+    for (size_t i = 0; i < N; i++)
+      if (i < rev[i])
+        std::swap(x[i], x[rev[i]]);
+
+    for (size_t len = 2; len <= N; len <<= 1) {
+      const size_t half = len / 2, stride = N / len;
+      for (size_t i = 0; i < N; i += len)
+        for (size_t j = 0; j < half; j++) {
+          complex w = tw[j * stride];
+          if (inv)
+            w = std::conj(w);
+          complex u = x[i + j], v = mul(x[i + j + half], w);
+          x[i + j] = u + v;
+          x[i + j + half] = u - v;
+        }
+    }
+  }
+};
+
+/**
+ * Real-input FFT of fixed size
+ *
+ * Packs even and odd samples into a complex FFT of half the size and separates
+ * the spectra afterwards, which halves the work of a complex transform of real
+ * data. Only the N/2 + 1 non-redundant bins are produced and consumed.
+ *
+ * @tparam T arithmetic type
+ * @tparam N size, a power of two of at least 4
+ */
+template<typename T, size_t N>
+class RealFFT {
+  static_assert(N >= 4, "Real FFT size must be at least 4");
+  static constexpr size_t M = N / 2;
+ public:
+  using complex = std::complex<T>;
+
+  RealFFT() {
+    const double pi = std::acos(-1.);
+    for (size_t k = 0; k < M; k++) {
+      auto w = std::polar(1., -2 * pi * double(k) / double(N));
+      tw[k] = complex(T(w.real()), T(w.imag()));
+    }
+  }
+
+  /**
+   * Forward transform
+   *
+   * @param x N real values
+   * @param X N/2 + 1 spectral values
+   */
+  void forward(const T *x, complex *X) const {
+    std::array<complex, M> z;
+    for (size_t n = 0; n < M; n++)
+      z[n] = complex(x[2 * n], x[2 * n + 1]);
+    fft.forward(z.data());
+
+    for (size_t k = 0; k <= M; k++) {
+      complex a = z[k % M], b = std::conj(z[(M - k) % M]), d = a - b;
+      complex e = T(0.5) * (a + b), o(T(0.5) * d.imag(), T(-0.5) * d.real());
+      X[k] = e + FFT<T, M>::mul(k < M ? tw[k] : complex(-1, 0), o);
+    }
+  }
+
+  /**
+   * Inverse transform, including the 1/N scaling
+   *
+   * @param X N/2 + 1 spectral values
+   * @param x N real values
+   */
+  void inverse(const complex *X, T *x) const {
+    std::array<complex, M> z;
+    for (size_t k = 0; k < M; k++) {
+      complex a = X[k], b = std::conj(X[M - k]);
+      complex e = a + b, o = FFT<T, M>::mul(a - b, std::conj(tw[k]));
+      z[k] = T(0.5) * (e + complex(-o.imag(), o.real()));
+    }
+    fft.inverse(z.data());
+    for (size_t n = 0; n < M; n++) {
+      x[2 * n] = z[n].real();
+      x[2 * n + 1] = z[n].imag();
+    }
+  }
+
+ protected:
+  FFT<T, M> fft;
+  std::array<complex, M> tw;
+};
+
+}
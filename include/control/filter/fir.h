@@ -0,0 +1,247 @@
+/*
+ * FIR filters
+ */
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <cstddef>
+
+#include <Eigen/Core>
+
+#include "control/filter/delay.h"
+#include "control/filter/fft.h"
+
+namespace control::filter {
+
+namespace detail {
+
+/**
+ * Vectorized inner product of N contiguous values
+ */
+template<typename T, size_t N>
+T dot(const T *a, const T *b) {
+  using V = Eigen::Matrix<T, int(N), 1>;
+  return Eigen::Map<const V>(a).dot(Eigen::Map<const V>(b));
+}
+
+/**
+ * Default partition size: direct form up to 512 taps, above which the
+ * partitioned form wins even against a vectorized inner product; otherwise the
+ * power of two (at least 32) nearest above sqrt(N) / 2, which balances the
+ * direct head against the spectral products and transforms per sample
+ */
+constexpr size_t fir_partition(size_t N) {
+  if (N <= 512)
+    return 0;
+  size_t B = 32;
+  while (4 * B * B < N)
+    B <<= 1;
+  return B;
+}
+
+}
+
+/**
+ * FIR filter, uniformly partitioned overlap-save
+ *
+ * Computes y[n] = sum_{k<N} h[k] x[n-k] without latency. The first B taps run
+ * in direct form; the remaining taps are split in partitions of B, convolved
+ * in the frequency domain with FFTs of 2B points and a delay line of input
+ * spectra. Once every B samples the input block is transformed, multiplied
+ * with all partition spectra and transformed back, which yields the tail of
+ * the next B outputs. The per-sample cost is about B + 2N/B multiply-adds plus
+ * two FFTs per block, instead of N; the work per sample is bounded but bursty.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ * @tparam B partition size, a power of two; 0 selects the direct form
+ */
+template<typename T, size_t N, size_t B = detail::fir_partition(N)>
+class Fir {
+  static_assert(B < N, "Partition size must be smaller than the number of taps");
+
+  using complex = std::complex<T>;
+
+  // Tail partitions and stored bins of their real-input spectra
+  static constexpr size_t P = (N - 1) / B;
+  static constexpr size_t F = B + 1;
+ public:
+  /**
+   * Initialize with impulse response h, h[0] applying to the newest input
+   *
+   * @param h taps
+   */
+  explicit Fir(const std::array<T, N> &h) {
+    for (size_t k = 0; k < B; k++)
+      hr[k] = h[B - 1 - k];
+
+    std::array<T, 2 * B> buf;
+    std::array<complex, F> spec;
+    for (size_t p = 0; p < P; p++) {
+      buf.fill(T(0));
+      for (size_t i = 0; i < B && (p + 1) * B + i < N; i++)
+        buf[i] = h[(p + 1) * B + i];
+      fft.forward(buf.data(), spec.data());
+      for (size_t f = 0; f < F; f++) {
+        Hr[p][f] = spec[f].real();
+        Hi[p][f] = spec[f].imag();
+      }
+    }
+  }
+
+  /**
+   * Step the filter
+   *
+   * @param x input
+   * @return T output
+   */
+  T step(T x) {
+    line.push(x);
+    T y = detail::dot<T, B>(hr.data(), line.window()) + tail[t];
+    in[B + t] = x;
+    if (++t == B) {
+      t = 0;
+      partitions();
+    }
+    return y;
+  }
+
+  /**
+   * Process a block of inputs
+   *
+   * @param x n inputs
+   * @param n number of inputs
+   * @param y n outputs
+   */
+  void process(const T *x, size_t n, T *y) {
+    for (size_t i = 0; i < n; i++)
+      y[i] = step(x[i]);
+  }
+
+  /**
+   * Reset the filter
+   */
+  void reset() {
+    line.reset();
+    for (size_t p = 0; p < P; p++) {
+      Xr[p].fill(T(0));
+      Xi[p].fill(T(0));
+    }
+    in.fill(T(0));
+    tail.fill(T(0));
+    t = 0;
+    xi = 0;
+  }
+
+ protected:
+  // Direct-form head, oldest input first
+  std::array<T, B> hr;
+  DelayLine<T, B> line;
+
+  RealFFT<T, 2 * B> fft;
+
+  // Partition spectra and the delay line of input spectra, X[xi] newest, with
+  // real and imaginary parts apart so the spectral products vectorize
+  std::array<std::array<T, F>, P> Hr, Hi;
+  std::array<std::array<T, F>, P> Xr{}, Xi{};
+  size_t xi = 0;
+
+  // Previous and current input block, tail of the current output block
+  std::array<T, 2 * B> in{};
+  std::array<T, B> tail{};
+  size_t t = 0;
+
+  void partitions() {
+    using A = Eigen::Array<T, int(F), 1>;
+
+    std::array<complex, F> spec;
+    fft.forward(in.data(), spec.data());
+
+    xi = xi == 0 ? P - 1 : xi - 1;
+    for (size_t f = 0; f < F; f++) {
+      Xr[xi][f] = spec[f].real();
+      Xi[xi][f] = spec[f].imag();
+    }
+
+    A yr = A::Zero(), yi = A::Zero();
+    for (size_t p = 0, j = xi; p < P; p++) {
+      Eigen::Map<const A> xre(Xr[j].data()), xim(Xi[j].data()), hre(Hr[p].data()), him(Hi[p].data());
+      yr += xre * hre - xim * him;
+      yi += xre * him + xim * hre;
+      if (++j == P)
+        j = 0;
+    }
+
+    for (size_t f = 0; f < F; f++)
+      spec[f] = complex(yr(f), yi(f));
+
+    std::array<T, 2 * B> out;
+    fft.inverse(spec.data(), out.data());
+    for (size_t i = 0; i < B; i++) {
+      tail[i] = out[B + i];
+      in[i] = in[B + i];
+    }
+  }
+};
+
+/**
+ * FIR filter, direct form
+ *
+ * Keeps the last N inputs contiguous in a DelayLine and evaluates the output as
+ * a single vectorized inner product.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ */
+template<typename T, size_t N>
+class Fir<T, N, 0> {
+ public:
+  /**
+   * Initialize with impulse response h, h[0] applying to the newest input
+   *
+   * @param h taps
+   */
+  explicit Fir(const std::array<T, N> &h) {
+    for (size_t k = 0; k < N; k++)
+      hr[k] = h[N - 1 - k];
+  }
+
+  /**
+   * Step the filter
+   *
+   * @param x input
+   * @return T output
+   */
+  T step(T x) {
+    line.push(x);
+    return detail::dot<T, N>(hr.data(), line.window());
+  }
+
+  /**
+   * Process a block of inputs
+   *
+   * @param x n inputs
+   * @param n number of inputs
+   * @param y n outputs
+   */
+  void process(const T *x, size_t n, T *y) {
+    for (size_t i = 0; i < n; i++)
+      y[i] = step(x[i]);
+  }
+
+  /**
+   * Reset the filter
+   */
+  void reset() {
+    line.reset();
+  }
+
+ protected:
+  // Taps, oldest input first
+  std::array<T, N> hr;
+  DelayLine<T, N> line;
+};
+
+}
@@ -0,0 +1,415 @@
+/*
+ * Multirate filters
+ */
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <utility>
+
+#include "control/filter/biquad.h"
+#include "control/filter/delay.h"
+#include "control/system/type.h"
+
+namespace control::filter {
+
+/**
+ * Polyphase FIR decimator
+ *
+ * Filters and keeps one of every M samples. Only the kept outputs are
+ * computed, so the cost is N multiply-adds per output, N/M per input.
+ * Output m corresponds to the full-rate output at input mM + M - 1.
+ *
+ * As a SISO, step() runs at the input rate and holds the latest output, so
+ * the decimator fits where a step() component is expected (Instrumented,
+ * SISO pointers). Stage and system::process use process() instead and pass
+ * only the kept outputs on.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ * @tparam M decimation factor
+ */
+template<typename T, size_t N, size_t M>
+class FirDecimator : public system::SISO<T> {
+ public:
+  /**
+   * Initialize with impulse response h, h[0] applying to the newest input
+   *
+   * @param h taps
+   */
+  explicit FirDecimator(const std::array<T, N> &h) {
+    for (size_t k = 0; k < N; k++)
+      hr[k] = h[N - 1 - k];
+  }
+
+  /**
+   * Push an input sample
+   *
+   * @param x input
+   * @param y output, written when available
+   * @return bool whether an output was produced
+   */
+  bool push(T x, T &y) {
+    line.push(x);
+    if (++phase < M)
+      return false;
+    phase = 0;
+    y = line.dot(hr.data());
+    return true;
+  }
+
+  /**
+   * Step at the input rate
+   *
+   * @param x input
+   * @return T latest output, held between decimated samples
+   */
+  T step(T x) override {
+    push(x, held);
+    return held;
+  }
+
+  /**
+   * Process a block of inputs
+   *
+   * @param x n inputs
+   * @param n number of inputs
+   * @param y outputs, room for n / M + 1
+   * @return size_t number of outputs produced
+   */
+  size_t process(const T *x, size_t n, T *y) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+      m += push(x[i], y[m]);
+    return m;
+  }
+
+  /**
+   * Reset the decimator
+   */
+  void reset() {
+    line.reset();
+    phase = 0;
+    held = 0;
+  }
+
+ protected:
+  // Taps, oldest input first
+  std::array<T, N> hr;
+  DelayLine<T, N> line;
+  size_t phase = 0;
+  T held = 0;
+};
+
+/**
+ * Polyphase FIR interpolator
+ *
+ * Upsamples by L and filters, without multiplying the inserted zeros: every
+ * output uses one of the L sub-filters of ceil(N/L) taps. The taps are applied
+ * as given; for unity pass-band gain they should sum to L.
+ *
+ * Unlike the decimators this is not a SISO: every input produces L outputs,
+ * which neither step() nor Stage and system::process, which expect at most
+ * one output per input, can return. Use push() or process() directly.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of taps
+ * @tparam L interpolation factor
+ */
+template<typename T, size_t N, size_t L>
+class FirInterpolator {
+  static constexpr size_t P = (N + L - 1) / L;
+ public:
+  /**
+   * Initialize with impulse response h, h[0] applying to the newest input
+   *
+   * @param h taps
+   */
+  explicit FirInterpolator(const std::array<T, N> &h) {
+    for (size_t k = 0; k < L; k++)
+      for (size_t j = 0; j < P; j++) {
+        size_t i = k + L * (P - 1 - j);
+        hp[k][j] = i < N ? h[i] : T(0);
+      }
+  }
+
+  /**
+   * Push an input sample and produce L outputs
+   *
+   * @param x input
+   * @param y L outputs
+   */
+  void push(T x, T *y) {
+    line.push(x);
+    for (size_t k = 0; k < L; k++)
+      y[k] = line.dot(hp[k].data());
+  }
+
+  /**
+   * Process a block of inputs
+   *
+   * @param x n inputs
+   * @param n number of inputs
+   * @param y n * L outputs
+   */
+  void process(const T *x, size_t n, T *y) {
+    for (size_t i = 0; i < n; i++)
+      push(x[i], y + i * L);
+  }
+
+  /**
+   * Reset the interpolator
+   */
+  void reset() {
+    line.reset();
+  }
+
+ protected:
+  // Sub-filters, oldest input first
+  std::array<std::array<T, P>, L> hp;
+  DelayLine<T, P> line;
+};
+
+/**
+ * Cascaded integrator-comb decimator
+ *
+ * M integrators at the input rate, decimation by R, and M combs at the output
+ * rate: a multiplier-free low-pass with response (sum_{i<R} z^-i)^M. The DC
+ * gain is R^M, see gain(). Use an integer type with at least M log2(R) bits of
+ * headroom; the integrators grow without bound for DC inputs, which only
+ * cancels out in the combs with exact arithmetic. step() holds the latest
+ * output, as for FirDecimator.
+ *
+ * @tparam T arithmetic type
+ * @tparam R decimation factor
+ * @tparam M order
+ */
+template<typename T, size_t R, size_t M>
+class CIC : public system::SISO<T> {
+ public:
+  /**
+   * Push an input sample
+   *
+   * @param x input
+   * @param y output, written when available
+   * @return bool whether an output was produced
+   */
+  bool push(T x, T &y) {
+    for (auto &a : integ)
+      x = a += x;
+    if (++phase < R)
+      return false;
+    phase = 0;
+    for (auto &c : comb) {
+      T t = x - c;
+      c = x;
+      x = t;
+    }
+    y = x;
+    return true;
+  }
+
+  /**
+   * Step at the input rate
+   *
+   * @param x input
+   * @return T latest output, held between decimated samples
+   */
+  T step(T x) override {
+    push(x, held);
+    return held;
+  }
+
+  /**
+   * Process a block of inputs
+   *
+   * @param x n inputs
+   * @param n number of inputs
+   * @param y outputs, room for n / R + 1
+   * @return size_t number of outputs produced
+   */
+  size_t process(const T *x, size_t n, T *y) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+      m += push(x[i], y[m]);
+    return m;
+  }
+
+  /**
+   * DC gain R^M
+   *
+   * @return T
+   */
+  static constexpr T gain() {
+    T g = 1;
+    for (size_t i = 0; i < M; i++)
+      g *= T(R);
+    return g;
+  }
+
+  /**
+   * Reset the decimator
+   */
+  void reset() {
+    integ.fill(T(0));
+    comb.fill(T(0));
+    phase = 0;
+    held = 0;
+  }
+
+ protected:
+  std::array<T, M> integ{};
+  std::array<T, M> comb{};
+  size_t phase = 0;
+  T held = 0;
+};
+
+/**
+ * IIR decimator
+ *
+ * Decimates by M through a cascade of N biquads while computing only the kept
+ * outputs. Each section's denominator is multiplied by the polynomial that
+ * turns it into one in z^-M,
+ *
+ *    1 / ((1 - p1 z^-1)(1 - p2 z^-1)) =
+ *        (sum_{i<M} p1^i z^-i)(sum_{i<M} p2^i z^-i) / ((1 - p1^M z^-M)(1 - p2^M z^-M))
+ *
+ * The numerators become a single FIR of 2NM + 1 taps, evaluated only for kept
+ * samples, and the recursive part runs as a BiquadCascade at the output rate.
+ * A 4th order filter decimating by 10 costs about 50 multiply-adds per output
+ * instead of 100 for the full-rate cascade. step() holds the latest output,
+ * as for FirDecimator.
+ *
+ * @tparam T arithmetic type
+ * @tparam N number of sections
+ * @tparam M decimation factor
+ */
+template<typename T, size_t N, size_t M>
+class IIRDecimator : public system::SISO<T> {
+  static constexpr size_t K = 2 * N * M + 1;
+ public:
+  /**
+   * Initialize from second-order sections
+   *
+   * @param s sections, with poles strictly inside the unit circle
+   */
+  template<typename U>
+  explicit IIRDecimator(const std::array<sos<U>, N> &s)
+      : ar(allpole(s, std::make_index_sequence<N>())) {
+    using C = std::complex<U>;
+
+    // Numerator polynomial, in ascending powers of z^-1
+    std::array<C, K> c{};
+    c[0] = 1;
+    size_t n = 1;
+    auto conv = [&c, &n](const C *b, size_t nb) {
+      for (size_t i = n + nb - 1; i-- > 0;) {
+        C acc = 0;
+        for (size_t j = 0; j < nb; j++)
+          if (j <= i && i - j < n)
+            acc += b[j] * c[i - j];
+        c[i] = acc;
+      }
+      n += nb - 1;
+    };
+
+    for (auto &si : s) {
+      C b[3] = {si.b0, si.b1, si.b2};
+      conv(b, 3);
+      for (auto p : poles(si)) {
+        C g[M];
+        g[0] = 1;
+        for (size_t i = 1; i < M; i++)
+          g[i] = g[i - 1] * p;
+        conv(g, M);
+      }
+    }
+
+    for (size_t k = 0; k < K; k++)
+      hr[k] = T(c[K - 1 - k].real());
+  }
+
+  /**
+   * Push an input sample
+   *
+   * @param x input
+   * @param y output, written when available
+   * @return bool whether an output was produced
+   */
+  bool push(T x, T &y) {
+    line.push(x);
+    if (++phase < M)
+      return false;
+    phase = 0;
+    y = ar.step(line.dot(hr.data()));
+    return true;
+  }
+
+  /**
+   * Step at the input rate
+   *
+   * @param x input
+   * @return T latest output, held between decimated samples
+   */
+  T step(T x) override {
+    push(x, held);
+    return held;
+  }
+
+  /**
+   * Process a block of inputs
+   *
+   * @param x n inputs
+   * @param n number of inputs
+   * @param y outputs, room for n / M + 1
+   * @return size_t number of outputs produced
+   */
+  size_t process(const T *x, size_t n, T *y) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+      m += push(x[i], y[m]);
+    return m;
+  }
+
+  /**
+   * Reset the decimator
+   */
+  void reset() {
+    line.reset();
+    ar.reset();
+    phase = 0;
+    held = 0;
+  }
+
+ protected:
+  // Numerator taps, oldest input first
+  std::array<T, K> hr;
+  DelayLine<T, K> line;
+
+  // Denominators in z^-M, at the output rate
+  BiquadCascade<Biquad<T>, N> ar;
+
+  size_t phase = 0;
+  T held = 0;
+
+  template<typename U>
+  static std::array<std::complex<U>, 2> poles(const sos<U> &s) {
+    std::complex<U> d = std::sqrt(std::complex<U>(s.a1 * s.a1 - 4 * s.a2));
+    return {(-s.a1 + d) / U(2), (-s.a1 - d) / U(2)};
+  }
+
+  template<typename U>
+  static Biquad<T> decimated(const sos<U> &s) {
+    auto p = poles(s);
+    auto p1 = std::pow(p[0], int(M)), p2 = std::pow(p[1], int(M));
+    return Biquad<T>(1, 0, 0, T(-(p1 + p2).real()), T((p1 * p2).real()));
+  }
+
+  template<typename U, size_t... I>
+  static BiquadCascade<Biquad<T>, N> allpole(const std::array<sos<U>, N> &s, std::index_sequence<I...>) {
+    return BiquadCascade<Biquad<T>, N>(decimated(s[I])...);
+  }
+};
+
+}
@@ -0,0 +1,264 @@
+/*
+ * Alternative biquad realizations
+ */
+
+#pragma once
+
+#include <cmath>
+
+#include "control/filter/biquad.h"
+
+namespace control::filter {
+
+/**
+ * Biquad in Direct form I
+ *
+ * Keeps the past inputs and outputs instead of the intermediate states of the
+ * transposed form. The states never exceed the signal range, which suits
+ * fixed-point types and filters with high internal gain.
+ *
+ * @tparam T arithmetic type
+ * @tparam S parameter type (const T)
+ */
+template<typename T = float, typename S = const T>
+class BiquadDF1 : public Biquad<T, S> {
+ public:
+  using Biquad<T, S>::Biquad;
+
+  /**
+   * Step the biquad
+   *
+   * @param T x input value
+   * @return T output value
+   */
+  T step(T x) {
+    auto &B = this->B;
+    auto &A = this->A;
+    auto &yz = this->wz;
+
+    /* Direct form I */
+    T y = x * B[0] + xz[0] * B[1] + xz[1] * B[2] - yz[0] * A[0] - yz[1] * A[1];
+
+    xz[1] = xz[0];
+    xz[0] = x;
+    yz[1] = yz[0];
+    yz[0] = y;
+
+    return y;
+  }
+
+  /**
+   * Reset the biquad
+   */
+  void reset() {
+    Biquad<T, S>::reset();
+    xz[0] = 0;
+    xz[1] = 0;
+  }
+
+  /**
+   * Snap decaying inputs and outputs to zero before they become subnormal
+   */
+  void snap() {
+    Biquad<T, S>::snap();
+    xz[0] = system::snap(xz[0]);
+    xz[1] = system::snap(xz[1]);
+  }
+
+ protected:
+
+  /**
+   * Past inputs, the past outputs are kept in wz
+   * @var T[]
+   */
+  T xz[2] = {0, 0};
+};
+
+/**
+ * Biquad in coupled (Gold-Rader) form
+ *
+ * The state-transfer matrix is built from the real and imaginary parts of the
+ * poles, r cos(th) and r sin(th), rather than from the polynomial coefficients
+ * -2 r cos(th) and r^2. The representable poles are then uniformly spread over
+ * the unit disc, instead of sparse near z = 1, which keeps low cut-off filters
+ * accurate in single precision. Real poles are realized as two first-order
+ * sections in series.
+ *
+ *    s(n+1) = M s(n) + [1 0]' x(n)
+ *      y(n) = c0 x(n) + c1 s1(n) + c2 s2(n)
+ *
+ * Coefficients are derived in the precision of the sos, so designing in double
+ * and filtering in float retains the pole locations.
+ *
+ * @tparam T arithmetic type
+ * @tparam S parameter type (const T)
+ */
+template<typename T = float, typename S = const T>
+class BiquadCoupled : public Biquad<T, S> {
+ public:
+  /**
+   * Initialize a biquad with normalized (5) coefficients
+   */
+  BiquadCoupled(T b0, T b1, T b2, T a1, T a2) : BiquadCoupled(sos<T>{b0, b1, b2, a1, a2}) {};
+
+  /**
+   * Initialize a biquad with a normalized second-order section
+   *
+   * @param sos<U> c coefficients
+   */
+  template<typename U>
+  BiquadCoupled(const sos<U> &c) : Biquad<T, S>(c), k(derive(c)) {};
+
+  /**
+   * Step the biquad
+   *
+   * @param T x input value
+   * @return T output value
+   */
+  T step(T x) {
+    auto &s = this->wz;
+
+    T y = k.c[0] * x + k.c[1] * s[0] + k.c[2] * s[1];
+
+    T s0 = k.M[0] * s[0] + k.M[1] * s[1] + x;
+    s[1] = k.M[2] * s[0] + k.M[3] * s[1];
+    s[0] = s0;
+
+    return y;
+  }
+
+  /**
+   * Update the coefficients of the biquad, retaining its state
+   *
+   * @param sos<T> c coefficients
+   */
+  void coefficients(const sos<T> &c) {
+    Biquad<T, S>::coefficients(c);
+    k = derive(c);
+  }
+
+  using Biquad<T, S>::coefficients;
+
+ protected:
+
+  /**
+   * Realization coefficients
+   */
+  struct coeff {
+    // State-transfer matrix, row-major
+    T M[4];
+    // Feed-through and output coefficients
+    T c[3];
+  } k;
+
+  template<typename U>
+  static coeff derive(const sos<U> &c) {
+    U disc = c.a1 * c.a1 - 4 * c.a2;
+    U c1 = c.b1 - c.b0 * c.a1;
+
+    if (disc < 0) {
+      // Complex pair sigma +- j omega
+      U sigma = -c.a1 / 2;
+      U omega = std::sqrt(-disc) / 2;
+      U c2 = (c.b2 - c.b0 * c.a2 + c1 * sigma) / omega;
+      return {{T(sigma), T(-omega), T(omega), T(sigma)}, {T(c.b0), T(c1), T(c2)}};
+    }
+
+    // Real poles p1, p2 in series
+    U p1 = (-c.a1 + std::copysign(std::sqrt(disc), -c.a1)) / 2;
+    U p2 = p1 != 0 ? c.a2 / p1 : 0;
+    U c2 = c.b2 - c.b0 * c.a2 + c1 * p2;
+    return {{T(p1), T(0), T(1), T(p2)}, {T(c.b0), T(c1), T(c2)}};
+  }
+};
+
+/**
+ * Biquad as a trapezoidal state-variable filter
+ *
+ * Zavalishin's topology-preserving transform of the analog state-variable
+ * filter, in the form of A. Simper. The states are the trapezoidal integrator
+ * memories, parameterized by the prewarped frequency g and damping k, which stay
+ * well-conditioned as the cut-off approaches zero. Any biquad whose poles lie
+ * strictly inside the unit circle is realized as a mix of the input, band-pass
+ * and low-pass outputs.
+ *
+ * Coefficients are derived in the precision of the sos, so designing in double
+ * and filtering in float retains the pole locations.
+ *
+ * @tparam T arithmetic type
+ * @tparam S parameter type (const T)
+ */
+template<typename T = float, typename S = const T>
+class BiquadSVF : public Biquad<T, S> {
+ public:
+  /**
+   * Initialize a biquad with normalized (5) coefficients
+   */
+  BiquadSVF(T b0, T b1, T b2, T a1, T a2) : BiquadSVF(sos<T>{b0, b1, b2, a1, a2}) {};
+
+  /**
+   * Initialize a biquad with a normalized second-order section
+   *
+   * @param sos<U> c coefficients
+   */
+  template<typename U>
+  BiquadSVF(const sos<U> &c) : Biquad<T, S>(c), k(derive(c)) {};
+
+  /**
+   * Step the biquad
+   *
+   * @param T x input value
+   * @return T output value
+   */
+  T step(T x) {
+    auto &ic = this->wz;
+
+    T v3 = x - ic[1];
+    T v1 = k.a[0] * ic[0] + k.a[1] * v3;
+    T v2 = ic[1] + k.a[1] * ic[0] + k.a[2] * v3;
+    ic[0] = 2 * v1 - ic[0];
+    ic[1] = 2 * v2 - ic[1];
+
+    return k.m[0] * x + k.m[1] * v1 + k.m[2] * v2;
+  }
+
+  /**
+   * Update the coefficients of the biquad, retaining its state
+   *
+   * @param sos<T> c coefficients
+   */
+  void coefficients(const sos<T> &c) {
+    Biquad<T, S>::coefficients(c);
+    k = derive(c);
+  }
+
+  using Biquad<T, S>::coefficients;
+
+ protected:
+
+  /**
+   * Realization coefficients
+   */
+  struct coeff {
+    // Integrator gains
+    T a[3];
+    // Mix of input, band-pass and low-pass
+    T m[3];
+  } k;
+
+  template<typename U>
+  static coeff derive(const sos<U> &c) {
+    // Invert the bilinear map of the denominator
+    U d0 = 4 / (1 - c.a1 + c.a2);
+    U g = std::sqrt((1 + c.a1 + c.a2) / (1 - c.a1 + c.a2));
+    U gk = (1 - c.a2) * d0 / 2;
+
+    U m0 = d0 * (c.b0 - c.b1 + c.b2) / 4;
+    U m2 = d0 * (c.b0 + c.b1 + c.b2) / (4 * g * g) - m0;
+    U m1 = (d0 * (c.b0 - c.b2) - 2 * m0 * gk) / (2 * g);
+
+    return {{T(1 / d0), T(g / d0), T(g * g / d0)}, {T(m0), T(m1), T(m2)}};
+  }
+};
+
+}
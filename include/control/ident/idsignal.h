@@ -3,7 +3,16 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "control/ident/philox.h"
 
 namespace control::ident {
 
@@ -14,16 +23,26 @@ namespace control::ident {
  *
  * Generates a sequence of -1 and 1
  *
+ * With an engine that yields full 32-bit words, such as the default
+ * philox4x32, every word gives 32 samples, least significant bit first, and
+ * the sequence is the same on every platform. Give each channel of a
+ * multichannel experiment its own stream:
+ *
+ *    PRBS<double> P(philox4x32(seed, channel));
+ *
  * @tparam T
+ * @tparam E random number engine
  */
-template<typename T>
+template<typename T, typename E = philox4x32>
 class PRBS {
  public:
 
   /**
    * Initialize the PRBS
+   *
+   * @param e engine
    */
-  PRBS() : e(), d(0, 1) {};
+  explicit PRBS(E e = E()) : e(std::move(e)), d(0, 1) {};
 
   /**
    * Get an integer, either -1 or 1
@@ -31,12 +50,119 @@ class PRBS {
    * @return T number in {-1,1}
    */
   T get() {
-    return d(e) ? 1 : -1;
+    if constexpr (words) {
+      if (bits == 0) {
+        word = uint32_t(e());
+        bits = 32;
+      }
+      const bool b = word & 1u;
+      word >>= 1;
+      bits--;
+      return b ? 1 : -1;
+    } else {
+      return d(e) ? 1 : -1;
+    }
   }
  protected:
-  std::default_random_engine e;
+  static constexpr bool words = E::min() == 0 && E::max() == 0xffffffffu;
+
+  E e;
   // The distribution still uses ints
   std::uniform_int_distribution<int> d;
+  uint32_t word = 0;
+  int bits = 0;
 };
 
+namespace detail {
+
+// Samples of the bits of every byte, least significant first
+template<typename T>
+const std::array<std::array<T, 8>, 256> &prbs_bytes() {
+  static const auto t = [] {
+    std::array<std::array<T, 8>, 256> t;
+    for (size_t v = 0; v < 256; v++)
+      for (size_t b = 0; b < 8; b++)
+        t[v][b] = (v >> b) & 1u ? T(1) : T(-1);
+    return t;
+  }();
+  return t;
+}
+
+}
+
+/**
+ * Samples of one channel of a multichannel PRBS
+ *
+ * Random access into the sequence of PRBS<T> on stream channel of
+ * philox4x32(seed): sample i is bit i mod 32 of word i / 32.
+ *
+ * @param out n samples in {-1, 1}
+ * @param n number of samples
+ * @param seed seed of the experiment
+ * @param channel channel
+ * @param offset index of the first sample
+ */
+template<typename T>
+void prbs(T *out, size_t n, uint64_t seed, uint64_t channel, uint64_t offset = 0) {
+  philox4x32 e(seed, channel);
+  e.discard(offset / 32);
+
+  const auto &bytes = detail::prbs_bytes<T>();
+  constexpr size_t W = 256;
+  uint32_t w[W];
+  size_t skip = offset % 32;
+  while (n > 0) {
+    const size_t m = std::min(W, (n + skip + 31) / 32);
+    e.generate(w, m);
+    for (size_t i = 0; i < m && n > 0; i++) {
+      const size_t c = std::min<size_t>(32 - skip, n);
+      if (c == 32) {
+        for (size_t j = 0; j < 4; j++)
+          std::copy_n(bytes[(w[i] >> (8 * j)) & 0xff].data(), 8, out + 8 * j);
+      } else {
+        for (size_t b = 0; b < c; b++)
+          out[b] = (w[i] >> (skip + b)) & 1u ? T(1) : T(-1);
+      }
+      out += c;
+      n -= c;
+      skip = 0;
+    }
+  }
+}
+
+/**
+ * Samples of all channels of a multichannel PRBS, on a pool of threads
+ *
+ * Channel c is the sequence of prbs() on channel c. The channels are cut into
+ * chunks that are generated independently, so the result does not depend on
+ * the number of threads.
+ *
+ * @param out channels of n samples each
+ * @param n number of samples
+ * @param seed seed of the experiment
+ * @param threads number of threads, 0 for the hardware concurrency
+ */
+template<typename T>
+void prbs(const std::vector<T *> &out, size_t n, uint64_t seed, unsigned threads = 0) {
+  constexpr size_t chunk = size_t(1) << 16;
+  const size_t per = (n + chunk - 1) / chunk, items = out.size() * per;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = unsigned(std::min<size_t>(threads, std::max<size_t>(items, 1)));
+
+  auto work = [&](size_t t) {
+    for (size_t i = t; i < items; i += threads) {
+      const size_t c = i / per, s = (i % per) * chunk;
+      prbs(out[c] + s, std::min(chunk, n - s), seed, c, s);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < threads; t++)
+    pool.emplace_back(work, t);
+  work(0);
+  for (auto &t : pool)
+    t.join();
+}
+
 }
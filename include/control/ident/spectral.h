@@ -0,0 +1,342 @@
+/**
+ * Spectral analysis: Welch spectra and empirical transfer function estimates
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "control/filter/fft.h"
+
+namespace control::ident {
+
+/**
+ * Averaged one-sided spectra of an input u and an output y
+ *
+ * Densities are per Hz at bin frequencies f; the cross-spectrum is
+ * conj(U) Y, so that Puy / Puu estimates the transfer function from u to y.
+ */
+template<typename T>
+struct spectra {
+  using complex = std::complex<T>;
+
+  std::vector<T> f;
+  std::vector<T> Puu, Pyy;
+  std::vector<complex> Puy;
+  size_t segments = 0;
+
+  /**
+   * Transfer function estimate Puy / Puu, unbiased by noise on y
+   *
+   * @return std::vector<complex> per bin
+   */
+  std::vector<complex> h1() const {
+    std::vector<complex> h(f.size());
+    for (size_t k = 0; k < h.size(); k++)
+      h[k] = Puy[k] / Puu[k];
+    return h;
+  }
+
+  /**
+   * Transfer function estimate Pyy / Pyu, unbiased by noise on u
+   *
+   * @return std::vector<complex> per bin
+   */
+  std::vector<complex> h2() const {
+    std::vector<complex> h(f.size());
+    for (size_t k = 0; k < h.size(); k++)
+      h[k] = Pyy[k] / std::conj(Puy[k]);
+    return h;
+  }
+
+  /**
+   * Magnitude-squared coherence |Puy|^2 / (Puu Pyy)
+   *
+   * 1 where y is linear in u, lower where noise or nonlinearity dominates.
+   *
+   * @return std::vector<T> per bin, in [0, 1]
+   */
+  std::vector<T> coherence() const {
+    std::vector<T> c(f.size());
+    for (size_t k = 0; k < c.size(); k++)
+      c[k] = std::norm(Puy[k]) / (Puu[k] * Pyy[k]);
+    return c;
+  }
+};
+
+namespace detail {
+
+/**
+ * Windowing, transform and scaling of segments of N samples
+ */
+template<typename T, size_t N>
+class segmenter {
+ public:
+  static constexpr size_t bins = N / 2 + 1;
+  using complex = std::complex<T>;
+
+  segmenter() {
+    const double pi = std::acos(-1.);
+    for (size_t n = 0; n < N; n++)
+      w[n] = T(0.5 - 0.5 * std::cos(2 * pi * double(n) / double(N)));
+  }
+
+  // Spectrum of the windowed segment x
+  void transform(const T *x, complex *X) const {
+    std::array<T, N> s;
+    for (size_t n = 0; n < N; n++)
+      s[n] = w[n] * x[n];
+    fft.forward(s.data(), X);
+  }
+
+  // Scale accumulated sums to averaged one-sided densities
+  spectra<T> scale(const T *uu, const T *yy, const complex *uy, size_t segments, T fs) const {
+    T w2 = 0;
+    for (auto v : w)
+      w2 += v * v;
+    spectra<T> s;
+    s.segments = segments;
+    s.f.resize(bins);
+    s.Puu.resize(bins);
+    s.Pyy.resize(bins);
+    s.Puy.resize(bins);
+    for (size_t k = 0; k < bins; k++) {
+      const T c = (k == 0 || k == N / 2 ? 1 : 2) / (fs * w2 * T(std::max<size_t>(segments, 1)));
+      s.f[k] = fs * T(k) / T(N);
+      s.Puu[k] = c * uu[k];
+      s.Pyy[k] = c * yy[k];
+      s.Puy[k] = c * uy[k];
+    }
+    return s;
+  }
+
+ protected:
+  filter::RealFFT<T, N> fft;
+  std::array<T, N> w;
+};
+
+}
+
+/**
+ * Streaming Welch estimate of the spectra of an input and an output
+ *
+ * Samples are collected into segments of N samples, overlapping by N - hop,
+ * each windowed with a periodic Hann window, transformed and accumulated as
+ * they complete, so arbitrarily long records are processed in constant
+ * memory. Segments are not detrended.
+ *
+ *    Welch<double, 1024> W(fs);
+ *    W.process(u, y, n);
+ *    auto s = W.result();      // s.h1(), s.coherence()
+ *
+ * @tparam T arithmetic type
+ * @tparam N segment length, a power of two
+ */
+template<typename T, size_t N>
+class Welch {
+ public:
+  static constexpr size_t bins = N / 2 + 1;
+  using complex = std::complex<T>;
+
+  /**
+   * @param fs sample rate
+   * @param hop samples between segment starts, at most N
+   */
+  explicit Welch(T fs = 1, size_t hop = N / 2) : fs{fs}, hop{std::clamp<size_t>(hop, 1, N)} {
+    reset();
+  }
+
+  /**
+   * Add a sample
+   *
+   * @param u input
+   * @param y output
+   */
+  void push(T u, T y) {
+    bu[fill] = u;
+    by[fill] = y;
+    if (++fill == N)
+      segment();
+  }
+
+  /**
+   * Add a block of samples
+   *
+   * @param u n inputs
+   * @param y n outputs
+   * @param n number of samples
+   */
+  void process(const T *u, const T *y, size_t n) {
+    while (n > 0) {
+      const size_t m = std::min(n, N - fill);
+      std::memcpy(bu.data() + fill, u, m * sizeof(T));
+      std::memcpy(by.data() + fill, y, m * sizeof(T));
+      fill += m;
+      u += m;
+      y += m;
+      n -= m;
+      if (fill == N)
+        segment();
+    }
+  }
+
+  /**
+   * @return spectra<T> averaged over the completed segments
+   */
+  spectra<T> result() const {
+    return seg.scale(uu.data(), yy.data(), uy.data(), count, fs);
+  }
+
+  /**
+   * @return size_t completed segments
+   */
+  size_t segments() const {
+    return count;
+  }
+
+  /**
+   * Clear the accumulated spectra and pending samples
+   */
+  void reset() {
+    uu.fill(0);
+    yy.fill(0);
+    uy.fill(0);
+    fill = 0;
+    count = 0;
+  }
+
+ protected:
+  void segment() {
+    seg.transform(bu.data(), U.data());
+    seg.transform(by.data(), Y.data());
+    for (size_t k = 0; k < bins; k++) {
+      uu[k] += std::norm(U[k]);
+      yy[k] += std::norm(Y[k]);
+      uy[k] += std::conj(U[k]) * Y[k];
+    }
+    count++;
+
+    // Keep the overlap for the next segment
+    std::memmove(bu.data(), bu.data() + hop, (N - hop) * sizeof(T));
+    std::memmove(by.data(), by.data() + hop, (N - hop) * sizeof(T));
+    fill = N - hop;
+  }
+
+  detail::segmenter<T, N> seg;
+  T fs;
+  size_t hop;
+  std::array<T, N> bu, by;
+  std::array<complex, bins> U, Y;
+  std::array<T, bins> uu, yy;
+  std::array<complex, bins> uy;
+  size_t fill = 0, count = 0;
+};
+
+/**
+ * Welch spectra of one input against many output channels, on a pool of threads
+ *
+ * The segments and channels of the records are divided into a grid of
+ * contiguous blocks, one per thread; each block accumulates its own sums,
+ * which are added in a fixed order afterwards, so the result does not depend
+ * on scheduling. The input spectrum of each segment is computed once per
+ * block and shared by its channels. Segments and windowing are as in Welch.
+ *
+ * @tparam N segment length, a power of two
+ * @param u n input samples
+ * @param y output channels of n samples each
+ * @param n number of samples
+ * @param fs sample rate
+ * @param hop samples between segment starts, at most N
+ * @param threads number of threads, 0 for the hardware concurrency
+ * @return std::vector<spectra<T>> per output channel
+ */
+template<size_t N, typename T>
+std::vector<spectra<T>> welch(const T *u, const std::vector<const T *> &y, size_t n, T fs = 1, size_t hop = N / 2,
+                              unsigned threads = 0) {
+  using complex = std::complex<T>;
+  constexpr size_t bins = N / 2 + 1;
+  hop = std::clamp<size_t>(hop, 1, N);
+  const size_t channels = y.size(), segments = n >= N ? (n - N) / hop + 1 : 0;
+  auto seg = std::make_unique<detail::segmenter<T, N>>();
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  // Split channels only when there are too few segments to go around
+  const size_t have = std::max<size_t>(segments, 1);
+  const size_t split = std::clamp<size_t>((threads + have - 1) / have, 1, std::max<size_t>(channels, 1));
+  // Rounding up the group size can leave trailing groups empty; drop them
+  const size_t per_group = (channels + split - 1) / split;
+  const size_t groups = per_group ? (channels + per_group - 1) / per_group : 1;
+  const size_t ranges = std::max<size_t>(1, std::min<size_t>(segments, threads / groups));
+  const size_t per_range = (segments + ranges - 1) / ranges;
+
+  struct block {
+    std::vector<T> uu, yy;
+    std::vector<complex> uy;
+  };
+  std::vector<block> blocks(ranges * groups);
+
+  auto work = [&](size_t r, size_t g) {
+    const size_t s0 = r * per_range, s1 = std::min(segments, s0 + per_range);
+    const size_t c0 = g * per_group, c1 = std::min(channels, c0 + per_group);
+    block &b = blocks[r * groups + g];
+    b.uu.assign(bins, 0);
+    b.yy.assign(bins * (c1 - c0), 0);
+    b.uy.assign(bins * (c1 - c0), 0);
+    std::vector<complex> U(bins), Y(bins);
+    for (size_t s = s0; s < s1; s++) {
+      seg->transform(u + s * hop, U.data());
+      if (g == 0)
+        for (size_t k = 0; k < bins; k++)
+          b.uu[k] += std::norm(U[k]);
+      for (size_t c = c0; c < c1; c++) {
+        seg->transform(y[c] + s * hop, Y.data());
+        T *yy = b.yy.data() + (c - c0) * bins;
+        complex *uy = b.uy.data() + (c - c0) * bins;
+        for (size_t k = 0; k < bins; k++) {
+          yy[k] += std::norm(Y[k]);
+          uy[k] += std::conj(U[k]) * Y[k];
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t r = 0; r < ranges; r++)
+    for (size_t g = 0; g < groups; g++)
+      pool.emplace_back(work, r, g);
+  for (auto &t : pool)
+    t.join();
+
+  std::vector<T> uu(bins, 0), yy(bins);
+  std::vector<complex> uy(bins);
+  for (size_t r = 0; r < ranges; r++)
+    for (size_t k = 0; k < bins; k++)
+      uu[k] += blocks[r * groups].uu[k];
+
+  std::vector<spectra<T>> out;
+  out.reserve(channels);
+  for (size_t c = 0; c < channels; c++) {
+    const size_t g = c / per_group, i = (c - g * per_group) * bins;
+    std::fill(yy.begin(), yy.end(), T(0));
+    std::fill(uy.begin(), uy.end(), complex(0));
+    for (size_t r = 0; r < ranges; r++) {
+      const block &b = blocks[r * groups + g];
+      for (size_t k = 0; k < bins; k++) {
+        yy[k] += b.yy[i + k];
+        uy[k] += b.uy[i + k];
+      }
+    }
+    out.push_back(seg->scale(uu.data(), yy.data(), uy.data(), segments, fs));
+  }
+  return out;
+}
+
+}
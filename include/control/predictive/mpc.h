@@ -0,0 +1,243 @@
+/*
+ * Linear model predictive control
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <Eigen/Dense>
+
+#include "control/system/ss.h"
+
+namespace control::predictive {
+
+/**
+ * Linear MPC
+ *
+ * Tracks a constant output reference over a horizon of Np steps while
+ * respecting box constraints on the input. The prediction follows ss::step:
+ *
+ *    x(i+1) = A x(i) + B u(i)
+ *    y(i+1) = C x(i+1) + D u(i)
+ *
+ * and the cost is
+ *
+ *    J = sum (y(i) - r)' Q (y(i) - r) + sum du(i)' R du(i)
+ *
+ * with du(i) = u(i) - u(i-1). Penalizing input increments rather than inputs
+ * avoids steady-state offsets for plants that need a non-zero input.
+ *
+ * The condensed prediction matrices and the ADMM system matrix are formed once
+ * upon construction. Each step solves the box-constrained QP with ADMM,
+ * warm-started from the shifted solution of the previous step. All storage is
+ * fixed-size; stepping does not allocate.
+ *
+ * @tparam T arithmetic type
+ * @tparam Nx number of states
+ * @tparam Nu number of inputs
+ * @tparam Ny number of outputs
+ * @tparam Np prediction horizon
+ */
+template<typename T, size_t Nx, size_t Nu = 1, size_t Ny = 1, size_t Np = 10>
+class MPC {
+ public:
+  using System = system::ss<T, Nx, Nu, Ny>;
+  using Tx = typename System::Tx;
+  using Tu = typename System::Tu;
+  using Ty = typename System::Ty;
+  using TQ = Eigen::Matrix<T, Ny, Ny>;
+  using TR = Eigen::Matrix<T, Nu, Nu>;
+  using TU = Eigen::Matrix<T, Nu * Np, 1>;
+  using TH = Eigen::Matrix<T, Nu * Np, Nu * Np>;
+  using TFx = Eigen::Matrix<T, Nu * Np, Nx>;
+  using TFr = Eigen::Matrix<T, Nu * Np, Ny>;
+  using TFu = Eigen::Matrix<T, Nu * Np, Nu>;
+
+  /**
+   * Solver statistics of the last step
+   */
+  struct info {
+    // ADMM iterations used
+    size_t iterations;
+    // Whether the residuals dropped below the tolerance within the cap
+    bool converged;
+    // Largest of the primal and dual residuals
+    T residual;
+    // Wall-clock time spent in the solver
+    std::chrono::nanoseconds time;
+  };
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+  /**
+   * Construct the controller and form the condensed QP
+   *
+   * @param P prediction model
+   * @param Q output error weight
+   * @param R input increment weight
+   * @param lb lower bound of the input
+   * @param ub upper bound of the input
+   * @param rho_ ADMM penalty parameter, derived from the spectrum of the QP when zero
+   * @param maxiter_ deterministic cap on ADMM iterations per step
+   * @param tol_ tolerance on the primal and dual residuals
+   */
+  MPC(const System &P, const TQ &Q, const TR &R, const Tu &lb, const Tu &ub,
+      T rho_ = 0, size_t maxiter_ = 50, T tol_ = 1e-4)
+      : rho(rho_), maxiter(maxiter_), tol(tol_) {
+    using TPhi = Eigen::Matrix<T, Ny * Np, Nx>;
+    using TGamma = Eigen::Matrix<T, Ny * Np, Nu * Np>;
+
+    const auto &A = P.getA();
+    const auto &B = P.getB();
+    const auto &C = P.getC();
+    const auto &D = P.getD();
+
+    // Condensed prediction Y = Phi x + Gamma U
+    TPhi Phi;
+    TGamma Gamma = TGamma::Zero();
+    typename System::TA Ai = A;
+    typename System::TB AiB = B;
+    for (size_t i = 0; i < Np; i++) {
+      Phi.template block<Ny, Nx>(i * Ny, 0) = C * Ai;
+      Ai = A * Ai;
+
+      // Impulse response coefficient C A^i B on the i-th sub-diagonal
+      typename System::TD Gi = C * AiB + (i == 0 ? D : System::TD::Zero().eval());
+      AiB = A * AiB;
+      for (size_t j = 0; i + j < Np; j++)
+        Gamma.template block<Ny, Nu>((i + j) * Ny, j * Nu) = Gi;
+    }
+
+    // Block-diagonal weights, QGamma = Qbar Gamma
+    TGamma QGamma;
+    for (size_t i = 0; i < Np; i++)
+      QGamma.template block<Ny, Nu * Np>(i * Ny, 0) = Q * Gamma.template block<Ny, Nu * Np>(i * Ny, 0);
+
+    // Input increments dU = Delta U - E u_prev
+    TH Delta = TH::Identity();
+    for (size_t i = 1; i < Np; i++)
+      Delta.template block<Nu, Nu>(i * Nu, (i - 1) * Nu) = -TR::Identity();
+    TH RDelta;
+    for (size_t i = 0; i < Np; i++)
+      RDelta.template block<Nu, Nu * Np>(i * Nu, 0) = R * Delta.template block<Nu, Nu * Np>(i * Nu, 0);
+
+    TH H = Gamma.transpose() * QGamma + Delta.transpose() * RDelta;
+
+    Fx = QGamma.transpose() * Phi;
+    Fr = TFr::Zero();
+    for (size_t i = 0; i < Np; i++)
+      Fr += QGamma.template block<Ny, Nu * Np>(i * Ny, 0).transpose();
+    Fu = RDelta.template block<Nu, Nu * Np>(0, 0).transpose();
+
+    // Balance the penalty against the curvature of the QP
+    if (rho <= 0) {
+      auto ev = Eigen::SelfAdjointEigenSolver<TH>(H, Eigen::EigenvaluesOnly).eigenvalues();
+      rho = std::sqrt(std::max(ev.minCoeff(), std::numeric_limits<T>::epsilon()) * ev.maxCoeff());
+    }
+
+    // ADMM linear system, factorized once
+    Kinv = (H + rho * TH::Identity()).llt().solve(TH::Identity());
+
+    for (size_t i = 0; i < Np; i++) {
+      lower.template segment<Nu>(i * Nu) = lb;
+      upper.template segment<Nu>(i * Nu) = ub;
+    }
+
+    reset();
+  }
+
+  /**
+   * Compute the input to apply at this time-step
+   *
+   * @param x current state
+   * @param r output reference
+   * @return Tu first input of the optimal sequence
+   */
+  Tu step(const Tx &x, const Ty &r) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Linear term of the QP
+    TU g = Fx * x - Fr * r - Fu * u;
+
+    // Warm start: shift the previous solution one step ahead
+    z.head((Np - 1) * Nu) = z.tail((Np - 1) * Nu).eval();
+    w.head((Np - 1) * Nu) = w.tail((Np - 1) * Nu).eval();
+
+    TU U, Ur, zp;
+    last.converged = false;
+    for (last.iterations = 0; last.iterations < maxiter;) {
+      U.noalias() = Kinv * (rho * (z - w) - g);
+      zp = z;
+
+      // Over-relaxed projection onto the box
+      Ur = alpha * U + (1 - alpha) * zp;
+      z = (Ur + w).cwiseMax(lower).cwiseMin(upper);
+      w += Ur - z;
+      last.iterations++;
+
+      last.residual = std::max((U - z).cwiseAbs().maxCoeff(), rho * (z - zp).cwiseAbs().maxCoeff());
+      if (last.residual < tol) {
+        last.converged = true;
+        break;
+      }
+    }
+
+    u = z.template head<Nu>();
+
+    last.time = std::chrono::steady_clock::now() - start;
+
+    return u;
+  }
+
+  /**
+   * Reset the warm start and the previous input
+   */
+  void reset() {
+    z = TU::Zero().cwiseMax(lower).cwiseMin(upper);
+    w = TU::Zero();
+    u = z.template head<Nu>();
+  }
+
+  /**
+   * @return const TU& optimal input sequence of the last step
+   */
+  const TU &sequence() const { return z; }
+
+  /**
+   * @return const info& solver statistics of the last step
+   */
+  const info &stats() const { return last; }
+
+ protected:
+  // ADMM penalty and over-relaxation
+  T rho;
+  static constexpr T alpha = 1.6;
+
+  const size_t maxiter;
+  const T tol;
+
+  // Linear term g = Fx x - Fr r - Fu u_prev
+  TFx Fx;
+  TFr Fr;
+  TFu Fu;
+
+  // (H + rho I)^-1
+  TH Kinv;
+
+  // Input bounds over the horizon
+  TU lower, upper;
+
+  // ADMM iterates
+  TU z, w;
+
+  // Previously applied input
+  Tu u;
+
+  info last = {0, false, 0, std::chrono::nanoseconds(0)};
+};
+
+}
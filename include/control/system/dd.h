@@ -0,0 +1,267 @@
+/*
+ * Double-double arithmetic
+ */
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+#include <Eigen/Core>
+
+namespace control::system {
+
+/**
+ * Unevaluated sum of two floating-point numbers, hi + lo with |lo| <= ulp(hi) / 2
+ *
+ * Doubles the significand of T (106 bits for double) with error-free
+ * transformations, so long simulations of marginally stable plants keep
+ * accumulating states without drift. As a drop-in scalar it works for ss
+ * (including its Eigen matrices), Biquad and PID:
+ *
+ *    ss<dd<double>, 2> P(A, B, C, D);
+ *    PID<dd<double>> pid(Ts, Kp, Ti);
+ *
+ * Sums take the short path of Joldes et al.: under cancellation their error
+ * is bounded relative to the operands rather than the result, like an
+ * accumulating state or a dot product in T, but at T^2 precision. All
+ * operations are branch-free straight-line code, but Eigen has no packet
+ * type for dd and runs its matrices with scalar loops, at several times the
+ * cost of T. Infinities are only supported as divisors,
+ * as in PID's default time constants; sums and products with them give NaN.
+ * Products use a fused multiply-add when the target has one (-mfma,
+ * -march=native) and Dekker's splitting otherwise. Compile without
+ * -ffast-math, which reassociates away the rounding errors this relies on.
+ *
+ * Algorithms after Joldes, Muller and Popescu, "Tight and rigorous error
+ * bounds for basic building blocks of double-word arithmetic", 2017.
+ *
+ * @tparam T floating-point type
+ */
+template<typename T>
+struct dd {
+  static_assert(std::numeric_limits<T>::is_iec559, "dd requires IEEE floating point");
+
+  T hi, lo;
+
+  constexpr dd(T v = 0) : hi{v}, lo{0} {}
+  constexpr dd(T hi, T lo) : hi{hi}, lo{lo} {}
+
+  /**
+   * @return T nearest T
+   */
+  explicit constexpr operator T() const {
+    return hi + lo;
+  }
+
+  friend constexpr dd operator-(const dd &a) {
+    return {-a.hi, -a.lo};
+  }
+
+  friend dd operator+(const dd &a, const dd &b) {
+    T s, e;
+    two_sum(a.hi, b.hi, s, e);
+    e += a.lo + b.lo;
+    fast_two_sum(s, e, s, e);
+    return {s, e};
+  }
+
+  friend dd operator+(const dd &a, T b) {
+    T s, e;
+    two_sum(a.hi, b, s, e);
+    e += a.lo;
+    fast_two_sum(s, e, s, e);
+    return {s, e};
+  }
+
+  friend dd operator+(T a, const dd &b) {
+    return b + a;
+  }
+
+  friend dd operator-(const dd &a, const dd &b) {
+    return a + -b;
+  }
+
+  friend dd operator-(const dd &a, T b) {
+    return a + -b;
+  }
+
+  friend dd operator-(T a, const dd &b) {
+    return -b + a;
+  }
+
+  friend dd operator*(const dd &a, const dd &b) {
+    T p, e;
+    two_prod(a.hi, b.hi, p, e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    fast_two_sum(p, e, p, e);
+    return {p, e};
+  }
+
+  friend dd operator*(const dd &a, T b) {
+    T p, e;
+    two_prod(a.hi, b, p, e);
+    e += a.lo * b;
+    fast_two_sum(p, e, p, e);
+    return {p, e};
+  }
+
+  friend dd operator*(T a, const dd &b) {
+    return b * a;
+  }
+
+  friend dd operator/(const dd &a, const dd &b) {
+    const T q = a.hi / b.hi;
+    const dd r = a - b * q;
+    T s, e;
+    fast_two_sum(q, r.hi / b.hi, s, e);
+    return std::isfinite(b.hi) ? dd{s, e} : dd{q};
+  }
+
+  friend dd operator/(const dd &a, T b) {
+    const T q = a.hi / b;
+    T p, e;
+    two_prod(q, b, p, e);
+    fast_two_sum(q, (a.hi - p - e + a.lo) / b, p, e);
+    return std::isfinite(b) ? dd{p, e} : dd{q};
+  }
+
+  friend dd operator/(T a, const dd &b) {
+    return dd(a) / b;
+  }
+
+  dd &operator+=(const dd &b) { return *this = *this + b; }
+  dd &operator-=(const dd &b) { return *this = *this - b; }
+  dd &operator*=(const dd &b) { return *this = *this * b; }
+  dd &operator/=(const dd &b) { return *this = *this / b; }
+
+  friend constexpr bool operator==(const dd &a, const dd &b) { return a.hi == b.hi && a.lo == b.lo; }
+  friend constexpr bool operator!=(const dd &a, const dd &b) { return !(a == b); }
+  friend constexpr bool operator<(const dd &a, const dd &b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+  friend constexpr bool operator>(const dd &a, const dd &b) { return b < a; }
+  friend constexpr bool operator<=(const dd &a, const dd &b) { return !(b < a); }
+  friend constexpr bool operator>=(const dd &a, const dd &b) { return !(a < b); }
+
+  friend dd abs(const dd &a) { return a.hi < 0 ? -a : a; }
+  friend dd fabs(const dd &a) { return abs(a); }
+  friend bool isfinite(const dd &a) { return std::isfinite(a.hi); }
+  friend bool isinf(const dd &a) { return std::isinf(a.hi); }
+  friend bool isnan(const dd &a) { return std::isnan(a.hi); }
+
+  /**
+   * One Newton step from the square root of hi
+   */
+  friend dd sqrt(const dd &a) {
+    if (!(a.hi > 0))
+      return dd(std::sqrt(a.hi));
+    const T s = std::sqrt(a.hi);
+    T p, e;
+    two_prod(s, s, p, e);
+    const T c = (a.hi - p - e + a.lo) / (2 * s);
+    fast_two_sum(s, c, p, e);
+    return {p, e};
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const dd &a) {
+    return os << a.hi << (a.lo < 0 ? " - " : " + ") << std::abs(a.lo);
+  }
+
+ private:
+  // s + e = a + b exactly
+  static void two_sum(T a, T b, T &s, T &e) {
+    s = a + b;
+    const T bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+  }
+
+  // s + e = a + b exactly, given |a| >= |b|
+  static void fast_two_sum(T a, T b, T &s, T &e) {
+    s = a + b;
+    e = b - (s - a);
+  }
+
+  // p + e = a b exactly
+  static void two_prod(T a, T b, T &p, T &e) {
+    p = a * b;
+#if defined(__FMA__) || defined(__aarch64__)
+    e = std::fma(a, b, -p);
+#else
+    constexpr T split = T((1ull << ((std::numeric_limits<T>::digits + 1) / 2)) + 1);
+    const T ca = split * a, cb = split * b;
+    const T ah = ca - (ca - a), al = a - ah;
+    const T bh = cb - (cb - b), bl = b - bh;
+    e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+  }
+};
+
+}
+
+namespace std {
+
+template<typename T>
+class numeric_limits<control::system::dd<T>> {
+  using D = control::system::dd<T>;
+  using L = numeric_limits<T>;
+ public:
+  static constexpr bool is_specialized = true;
+  static constexpr bool is_signed = true;
+  static constexpr bool is_integer = false;
+  static constexpr bool is_exact = false;
+  static constexpr bool has_infinity = L::has_infinity;
+  static constexpr bool has_quiet_NaN = L::has_quiet_NaN;
+  static constexpr bool has_signaling_NaN = L::has_signaling_NaN;
+  static constexpr bool is_iec559 = false;
+  static constexpr bool is_bounded = true;
+  static constexpr bool is_modulo = false;
+  static constexpr int radix = 2;
+  static constexpr int digits = 2 * L::digits;
+  static constexpr int digits10 = int(digits * 0.30102999566398120);
+  static constexpr int max_digits10 = digits10 + 2;
+  static constexpr int min_exponent = L::min_exponent + L::digits;
+  static constexpr int min_exponent10 = L::min_exponent10 + L::digits10;
+  static constexpr int max_exponent = L::max_exponent;
+  static constexpr int max_exponent10 = L::max_exponent10;
+  static constexpr float_round_style round_style = round_to_nearest;
+
+  static constexpr D min() { return D(L::min() / L::epsilon() * 2); }
+  static constexpr D max() { return D(L::max()); }
+  static constexpr D lowest() { return -max(); }
+  static constexpr D epsilon() { return D(L::epsilon() * L::epsilon() / 2); }
+  static constexpr D round_error() { return D(T(0.5)); }
+  static constexpr D infinity() { return D(L::infinity()); }
+  static constexpr D quiet_NaN() { return D(L::quiet_NaN()); }
+  static constexpr D signaling_NaN() { return D(L::signaling_NaN()); }
+  static constexpr D denorm_min() { return min(); }
+};
+
+}
+
+namespace Eigen {
+
+template<typename T>
+struct NumTraits<control::system::dd<T>> : GenericNumTraits<control::system::dd<T>> {
+  using Real = control::system::dd<T>;
+  using NonInteger = control::system::dd<T>;
+  using Nested = control::system::dd<T>;
+  using Literal = control::system::dd<T>;
+
+  enum {
+    IsComplex = 0,
+    IsInteger = 0,
+    IsSigned = 1,
+    RequireInitialization = 1,
+    ReadCost = 2,
+    AddCost = 10,
+    MulCost = 10
+  };
+
+  static inline Real epsilon() { return std::numeric_limits<Real>::epsilon(); }
+  static inline Real dummy_precision() { return Real(T(1e3) * std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon()); }
+  static inline Real highest() { return std::numeric_limits<Real>::max(); }
+  static inline Real lowest() { return std::numeric_limits<Real>::lowest(); }
+  static inline int digits10() { return std::numeric_limits<Real>::digits10; }
+};
+
+}
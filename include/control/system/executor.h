@@ -0,0 +1,262 @@
+/*
+ * Static rate-monotonic executor for multi-rate control loops
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+#include "control/system/instrument.h"
+
+namespace control::system {
+
+/**
+ * Executor of tasks at integer-related rates
+ *
+ * A frame is one tick of the base rate. Every task runs each divisor-th frame,
+ * offset by its phase, and all tasks due in a frame run back to back in
+ * rate-monotonic order: higher rates (smaller divisors) first, tasks of equal
+ * rate in the order they were added. The schedule is a fixed table, so the
+ * order within a frame never changes and the start of the fastest task only
+ * varies with the release jitter of the frame. Phases spread slow tasks over
+ * frames to flatten the worst-case frame.
+ *
+ * Tasks are callables stored inline in fixed-size slots (typically lambdas
+ * capturing components and signals by reference); nothing is allocated after
+ * construction. Every task and every frame is timed with ticks() and counted
+ * against its budget and the frame deadline in a Probe.
+ *
+ *    Executor<4> ex(deadline);
+ *    ex.every(1, [&] { i = current.step(iref - imeas); });
+ *    ex.every(10, velocity, verr, iref);
+ *    ex.every(100, [&] { position.step(u); }, 0, 5);
+ *
+ * @tparam N capacity in tasks
+ * @tparam S bytes of storage per task callable
+ */
+template<size_t N, size_t S = 8 * sizeof(void *)>
+class Executor {
+ public:
+  /**
+   * @param deadline ticks a frame may take, 0 for none
+   */
+  explicit Executor(uint64_t deadline = 0) : frames(deadline) {}
+
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  /**
+   * Add a task
+   *
+   * @param divisor run every divisor frames
+   * @param f callable without arguments, trivially copyable and at most S bytes
+   * @param budget ticks the task may take, 0 for none
+   * @param phase frame offset, below divisor
+   * @return size_t task index
+   */
+  template<typename F>
+  size_t every(uint32_t divisor, F f, uint64_t budget = 0, uint32_t phase = 0) {
+    static_assert(std::is_trivially_copyable_v<F> && std::is_trivially_destructible_v<F>,
+                  "Tasks are stored by value without destruction; capture by reference");
+    static_assert(sizeof(F) <= S && alignof(F) <= alignof(std::max_align_t), "Task does not fit its slot");
+    if (n == N)
+      throw std::length_error("executor is full");
+    if (divisor == 0 || phase >= divisor)
+      throw std::invalid_argument("executor: phase must be below a non-zero divisor");
+
+    task &t = tasks[n];
+    new(t.storage) F(f);
+    t.call = [](void *p) { (*static_cast<F *>(p))(); };
+    t.divisor = divisor;
+    t.phase = phase;
+    t.countdown = phase;
+    t.probe.deadline = budget;
+
+    // Insert into rate-monotonic order, after tasks of equal rate
+    size_t i = n;
+    while (i > 0 && tasks[order[i - 1]].divisor > divisor) {
+      order[i] = order[i - 1];
+      i--;
+    }
+    order[i] = n;
+    return n++;
+  }
+
+  /**
+   * Add a component task: y = c.step(x)
+   *
+   * Works with SISO components (PID, biquads, cascades), state-spaces and
+   * anything else with a step method. x and y are read and written in place.
+   *
+   * @param divisor run every divisor frames
+   * @param c component
+   * @param x input signal
+   * @param y output signal
+   * @param budget ticks the task may take, 0 for none
+   * @param phase frame offset, below divisor
+   * @return size_t task index
+   */
+  template<typename C, typename X, typename Y>
+  size_t every(uint32_t divisor, C &c, const X &x, Y &y, uint64_t budget = 0, uint32_t phase = 0) {
+    C *cp = &c;
+    const X *xp = &x;
+    Y *yp = &y;
+    return every(divisor, [cp, xp, yp] { *yp = cp->step(*xp); }, budget, phase);
+  }
+
+  /**
+   * Run one frame: every task due, in rate-monotonic order
+   *
+   * @return bool whether the frame met its deadline
+   */
+  bool tick() {
+    const uint64_t t0 = ticks();
+    uint64_t t = t0;
+    for (size_t i = 0; i < n; i++) {
+      task &k = tasks[order[i]];
+      if (k.countdown == 0) {
+        k.call(k.storage);
+        const uint64_t t1 = ticks();
+        k.probe.record(t1 - t);
+        t = t1;
+        k.countdown = k.divisor;
+      }
+      k.countdown--;
+    }
+    count++;
+    frames.record(t - t0);
+    return !frames.deadline || t - t0 <= frames.deadline;
+  }
+
+  /**
+   * Run frames released every period ticks, spinning until each release
+   *
+   * The lateness of every frame start is recorded as its jitter. A frame that
+   * overruns its period delays the next one; no frame is skipped, so the
+   * tasks see every sample.
+   *
+   * @param period ticks between frame releases
+   * @param frames_ number of frames
+   * @return uint64_t frames that overran their period
+   */
+  uint64_t run(uint64_t period, uint64_t frames_) {
+    uint64_t release = ticks(), overruns = 0;
+    for (uint64_t i = 0; i < frames_; i++) {
+      uint64_t now;
+      while ((now = ticks()) < release) {}
+      jitter.record(now - release);
+      tick();
+      release += period;
+      if (ticks() > release)
+        overruns++;
+    }
+    return overruns;
+  }
+
+  /**
+   * @return size_t number of tasks
+   */
+  size_t size() const {
+    return n;
+  }
+
+  /**
+   * @return uint64_t frames run
+   */
+  uint64_t frame() const {
+    return count;
+  }
+
+  /**
+   * Length of the schedule: the least common multiple of the divisors
+   *
+   * @return uint64_t frames
+   */
+  uint64_t hyperperiod() const {
+    uint64_t h = 1;
+    for (size_t i = 0; i < n; i++)
+      h = std::lcm(h, uint64_t(tasks[i].divisor));
+    return h;
+  }
+
+  /**
+   * Largest sum of task budgets due in one frame over the schedule
+   *
+   * Compare with the frame deadline to check the schedule before running it.
+   *
+   * @return uint64_t ticks
+   */
+  uint64_t worst_case() const {
+    uint64_t worst = 0;
+    const uint64_t h = hyperperiod();
+    for (uint64_t f = 0; f < h; f++) {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < n; i++)
+        if (f % tasks[i].divisor == tasks[i].phase)
+          sum += tasks[i].probe.deadline;
+      worst = std::max(worst, sum);
+    }
+    return worst;
+  }
+
+  /**
+   * Statistics of a task: ticks per run and budget misses
+   *
+   * @param i task index
+   * @return stats
+   */
+  stats task_stats(size_t i) const {
+    return tasks[i].probe.snapshot();
+  }
+
+  /**
+   * @return stats ticks per frame and deadline misses
+   */
+  stats frame_stats() const {
+    return frames.snapshot();
+  }
+
+  /**
+   * @return stats ticks from release to frame start, recorded by run()
+   */
+  stats jitter_stats() const {
+    return jitter.snapshot();
+  }
+
+  /**
+   * Restart the schedule at frame 0 and clear the statistics
+   */
+  void reset() {
+    for (size_t i = 0; i < n; i++) {
+      tasks[i].countdown = tasks[i].phase;
+      tasks[i].probe.reset();
+    }
+    frames.reset();
+    jitter.reset();
+    count = 0;
+  }
+
+ protected:
+  struct task {
+    alignas(std::max_align_t) unsigned char storage[S];
+    void (*call)(void *) = nullptr;
+    uint32_t divisor = 1, phase = 0, countdown = 0;
+    Probe probe;
+  };
+
+  std::array<task, N> tasks;
+  std::array<size_t, N> order{};
+  size_t n = 0;
+  uint64_t count = 0;
+  Probe frames, jitter;
+};
+
+}
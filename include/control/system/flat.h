@@ -0,0 +1,492 @@
+/*
+ * Flat binary configuration images
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "control/classic/pid.h"
+#include "control/filter/bank.h"
+#include "control/filter/biquad.h"
+#include "control/filter/ghk.h"
+#include "control/system/mapped.h"
+#include "control/system/ss.h"
+
+namespace control::system {
+
+/**
+ * Kinds of records in a flat image
+ */
+enum class record : uint32_t {
+  // K channels of N biquad sections
+  biquads = 1,
+  // PID biquad and output limit
+  pid = 2,
+  // State-space matrices
+  ss = 3,
+  // g-h-k coefficients
+  ghk = 4,
+};
+
+namespace detail {
+
+struct flat_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t type;
+  uint64_t records;
+  uint64_t size;
+  uint8_t reserved[32];
+};
+
+struct flat_entry {
+  uint32_t kind;
+  uint32_t flags;
+  uint32_t dims[3];
+  uint32_t reserved;
+  uint64_t offset;
+};
+
+static_assert(sizeof(flat_header) == 64 && sizeof(flat_entry) == 32, "Flat layout must be packed");
+
+constexpr char flat_magic[9] = "CTRLFLT1";
+constexpr uint32_t flat_version = 1;
+constexpr uint32_t flat_state = 1;
+
+constexpr size_t align64(size_t n) {
+  return (n + 63) / 64 * 64;
+}
+
+template<typename T>
+constexpr uint32_t flat_type() {
+  return uint32_t(sizeof(T)) | (std::is_floating_point_v<T> ? 0x100u : 0u);
+}
+
+// Products and sums of untrusted dimensions, saturating at SIZE_MAX
+constexpr size_t flat_mul(size_t a, size_t b) {
+  return b != 0 && a > SIZE_MAX / b ? SIZE_MAX : a * b;
+}
+
+constexpr size_t flat_add(size_t a, size_t b) {
+  return a > SIZE_MAX - b ? SIZE_MAX : a + b;
+}
+
+// Number of scalars of the configuration and the state of a record
+inline std::pair<size_t, size_t> flat_sizes(const flat_entry &e) {
+  const size_t a = e.dims[0], b = e.dims[1], c = e.dims[2];
+  switch (record(e.kind)) {
+    case record::biquads: return {flat_mul(5, flat_mul(a, b)), flat_mul(2, flat_mul(a, b))};
+    case record::pid: return {6, 3};
+    case record::ss:
+      return {flat_add(flat_add(flat_mul(a, a), flat_mul(a, b)), flat_add(flat_mul(c, a), flat_mul(c, b))), a + c};
+    case record::ghk: return {3, 3};
+  }
+  return {0, 0};
+}
+
+}
+
+/**
+ * Writer of flat images
+ *
+ * Collects configurations, optionally with their runtime state, and lays them
+ * out as an image that FlatImage reads in place:
+ *
+ *    header      64 bytes: magic "CTRLFLT1", version, scalar type, number of
+ *                records and total size
+ *    directory   32 bytes per record: kind, flags, three dimensions, offset
+ *    payloads    per record, 64-byte aligned: configuration scalars, then
+ *                state scalars when flagged
+ *
+ * Payloads per kind, in scalars of type T:
+ *
+ *    biquads     K channels, N sections: b0, b1, b2, a1, a2 each as N runs of
+ *                K (BiquadBank layout); state w0, w1 likewise
+ *    pid         b0, b1, b2, a1, a2 of its biquad, Limit; state w0, w1, clipping
+ *    ss          Nx, Nu, Ny: A, B, C, D column-major; state x, y
+ *    ghk         g, h, k; state x, dx, ddx
+ *
+ * Integers and scalars are stored in native byte order.
+ *
+ * @tparam T arithmetic type
+ */
+template<typename T>
+class FlatWriter {
+ public:
+  /**
+   * Add a bank of cascades
+   *
+   * @param b bank
+   * @param state whether to include the state
+   * @return size_t record index
+   */
+  size_t add(const filter::BiquadBank<T> &b, bool state = false) {
+    const size_t n = 5 * b.channels() * b.sections();
+    std::vector<T> d(b.coefficients(), b.coefficients() + n);
+    if (state)
+      d.insert(d.end(), b.state(), b.state() + 2 * b.channels() * b.sections());
+    return push(record::biquads, state, {uint32_t(b.channels()), uint32_t(b.sections()), 0}, std::move(d));
+  }
+
+  /**
+   * Add a cascade, as a bank of one channel
+   *
+   * @param c cascade
+   * @param state whether to include the state
+   * @return size_t record index
+   */
+  template<typename S, size_t N>
+  size_t add(const filter::BiquadCascade<filter::Biquad<T, S>, N> &c, bool state = false) {
+    filter::BiquadBank<T> b(1, N);
+    b.channel(0, c);
+    return add(b, state);
+  }
+
+  /**
+   * Add a PID controller (or P, PI, PD)
+   *
+   * @param c controller
+   * @param state whether to include the state and clipping status
+   * @return size_t record index
+   */
+  size_t add(const classic::PID<T> &c, bool state = false) {
+    auto s = c.coefficients();
+    std::vector<T> d{s.b0, s.b1, s.b2, s.a1, s.a2, c.Limit};
+    if (state) {
+      auto w = c.state();
+      d.insert(d.end(), {w[0], w[1], T(c.clipping ? 1 : 0)});
+    }
+    return push(record::pid, state, {1, 0, 0}, std::move(d));
+  }
+
+  /**
+   * Add a state-space
+   *
+   * @param P system
+   * @param state whether to include the state and output
+   * @return size_t record index
+   */
+  template<size_t Nx, size_t Nu, size_t Ny>
+  size_t add(const ss<T, Nx, Nu, Ny> &P, bool state = false) {
+    std::vector<T> d;
+    auto put = [&d](const auto &m) {
+      d.insert(d.end(), m.data(), m.data() + m.size());
+    };
+    put(P.getA());
+    put(P.getB());
+    put(P.getC());
+    put(P.getD());
+    if (state) {
+      put(P.x);
+      put(P.y);
+    }
+    return push(record::ss, state, {uint32_t(Nx), uint32_t(Nu), uint32_t(Ny)}, std::move(d));
+  }
+
+  /**
+   * Add g-h-k coefficients
+   *
+   * @param c coefficients
+   * @param s state to include, if any
+   * @return size_t record index
+   */
+  size_t add(const control::ghk::coeff<T> &c, const control::ghk::state<T> *s = nullptr) {
+    std::vector<T> d{c.g, c.h, c.k};
+    if (s)
+      d.insert(d.end(), {s->x, s->dx, s->ddx});
+    return push(record::ghk, s != nullptr, {1, 0, 0}, std::move(d));
+  }
+
+  /**
+   * Lay out the image
+   *
+   * @return std::vector<unsigned char>
+   */
+  std::vector<unsigned char> bytes() const {
+    size_t size = detail::align64(sizeof(detail::flat_header) + items.size() * sizeof(detail::flat_entry));
+    std::vector<detail::flat_entry> dir;
+    for (auto &i : items) {
+      auto e = i.first;
+      e.offset = size;
+      dir.push_back(e);
+      size += detail::align64(i.second.size() * sizeof(T));
+    }
+
+    std::vector<unsigned char> b(size, 0);
+    detail::flat_header h{};
+    std::memcpy(h.magic, detail::flat_magic, 8);
+    h.version = detail::flat_version;
+    h.type = detail::flat_type<T>();
+    h.records = items.size();
+    h.size = size;
+    std::memcpy(b.data(), &h, sizeof(h));
+    if (!dir.empty())
+      std::memcpy(b.data() + sizeof(h), dir.data(), dir.size() * sizeof(detail::flat_entry));
+    for (size_t i = 0; i < items.size(); i++)
+      if (!items[i].second.empty())
+        std::memcpy(b.data() + dir[i].offset, items[i].second.data(), items[i].second.size() * sizeof(T));
+    return b;
+  }
+
+  /**
+   * Write the image to a file, replacing it
+   *
+   * @param path
+   */
+  void save(const std::string &path) const {
+    auto b = bytes();
+    MappedFile f(path, b.size());
+    std::memcpy(f.data(), b.data(), b.size());
+    f.sync();
+  }
+
+ protected:
+  std::vector<std::pair<detail::flat_entry, std::vector<T>>> items;
+
+  size_t push(record kind, bool state, std::array<uint32_t, 3> dims, std::vector<T> d) {
+    detail::flat_entry e{};
+    e.kind = uint32_t(kind);
+    e.flags = state ? detail::flat_state : 0;
+    std::copy(dims.begin(), dims.end(), e.dims);
+    items.emplace_back(e, std::move(d));
+    return items.size() - 1;
+  }
+};
+
+/**
+ * Flat image, read in place
+ *
+ * Validates the header and the directory once; loading a record then copies
+ * its scalars straight into the target object without any parsing. Malformed
+ * images and records of another kind or size than requested throw
+ * std::runtime_error.
+ *
+ * @tparam T arithmetic type
+ */
+template<typename T>
+class FlatImage {
+ public:
+  /**
+   * View an image in memory, which must outlive the FlatImage
+   *
+   * @param data image, aligned to T
+   * @param size bytes
+   */
+  FlatImage(const void *data, size_t size) : base(static_cast<const unsigned char *>(data)), len(size) {
+    validate();
+  }
+
+  /**
+   * Map an image file
+   *
+   * @param path
+   * @return FlatImage
+   */
+  static FlatImage open(const std::string &path) {
+    auto f = std::make_shared<MappedFile>(path);
+    FlatImage i(f->data(), f->size());
+    i.file = std::move(f);
+    return i;
+  }
+
+  /**
+   * @return size_t number of records
+   */
+  size_t size() const {
+    return n;
+  }
+
+  /**
+   * @param i record index
+   * @return record kind
+   */
+  record kind(size_t i) const {
+    return record(entry(i).kind);
+  }
+
+  /**
+   * @param i record index
+   * @return bool whether the record includes runtime state
+   */
+  bool has_state(size_t i) const {
+    return entry(i).flags & detail::flat_state;
+  }
+
+  /**
+   * Load a biquads record into a bank, with its state if present
+   *
+   * @param i record index
+   * @return filter::BiquadBank<T>
+   */
+  filter::BiquadBank<T> bank(size_t i) const {
+    auto e = expect(i, record::biquads);
+    filter::BiquadBank<T> b(e.dims[0], e.dims[1]);
+    const size_t c = 5 * b.channels() * b.sections();
+    std::memcpy(b.coefficients(), payload(e), c * sizeof(T));
+    if (e.flags & detail::flat_state)
+      std::memcpy(b.state(), payload(e) + c, 2 * b.channels() * b.sections() * sizeof(T));
+    return b;
+  }
+
+  /**
+   * Load a biquads record of one channel into a cascade, with its state if present
+   *
+   * @tparam N number of sections
+   * @tparam S storage type of the biquads
+   * @param i record index
+   * @return filter::BiquadCascade<filter::Biquad<T, S>, N>
+   */
+  template<size_t N, typename S = const T>
+  filter::BiquadCascade<filter::Biquad<T, S>, N> cascade(size_t i) const {
+    auto e = expect(i, record::biquads);
+    if (e.dims[0] != 1 || e.dims[1] != N)
+      throw std::runtime_error("flat image: record " + std::to_string(i) + " is not a cascade of that size");
+    return cascade<N, S>(e, std::make_index_sequence<N>());
+  }
+
+  /**
+   * Load a PID record, with its state and clipping status if present
+   *
+   * @param i record index
+   * @return classic::PID<T>
+   */
+  classic::PID<T> pid(size_t i) const {
+    auto e = expect(i, record::pid);
+    const T *p = payload(e);
+    classic::PID<T> c(filter::sos<T>{p[0], p[1], p[2], p[3], p[4]}, p[5]);
+    if (e.flags & detail::flat_state) {
+      c.state({p[6], p[7]});
+      c.clipping = p[8] != T(0);
+    }
+    return c;
+  }
+
+  /**
+   * Load a state-space record, with its state and output if present
+   *
+   * @param i record index
+   * @return ss<T, Nx, Nu, Ny>
+   */
+  template<size_t Nx, size_t Nu = 1, size_t Ny = 1>
+  ss<T, Nx, Nu, Ny> statespace(size_t i) const {
+    using P = ss<T, Nx, Nu, Ny>;
+    auto e = expect(i, record::ss);
+    if (e.dims[0] != Nx || e.dims[1] != Nu || e.dims[2] != Ny)
+      throw std::runtime_error("flat image: record " + std::to_string(i) + " is not a state-space of that size");
+
+    const T *p = payload(e);
+    auto take = [&p](auto m) {
+      using M = decltype(m);
+      m = Eigen::Map<const M>(p);
+      p += m.size();
+      return m;
+    };
+    auto A = take(typename P::TA());
+    auto B = take(typename P::TB());
+    auto C = take(typename P::TC());
+    auto D = take(typename P::TD());
+    P s(A, B, C, D);
+    if (e.flags & detail::flat_state) {
+      s.x = take(typename P::Tx());
+      s.y = take(typename P::Ty());
+    }
+    return s;
+  }
+
+  /**
+   * Load a g-h-k record
+   *
+   * @param i record index
+   * @param s state to fill when present, may be null
+   * @return ghk::coeff<T>
+   */
+  control::ghk::coeff<T> ghk(size_t i, control::ghk::state<T> *s = nullptr) const {
+    auto e = expect(i, record::ghk);
+    const T *p = payload(e);
+    if (s && (e.flags & detail::flat_state))
+      *s = {p[3], p[4], p[5]};
+    return {p[0], p[1], p[2]};
+  }
+
+ protected:
+  const unsigned char *base;
+  size_t len;
+  size_t n = 0;
+
+  // Keeps a mapped file alive
+  std::shared_ptr<MappedFile> file;
+
+  [[noreturn]] static void fail(const std::string &what) {
+    throw std::runtime_error("flat image: " + what);
+  }
+
+  void validate() {
+    detail::flat_header h;
+    if (!base || len < sizeof(h))
+      fail("truncated header");
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, detail::flat_magic, 8) != 0)
+      fail("bad magic");
+    if (h.version == 0 || h.version > detail::flat_version)
+      fail("unsupported version " + std::to_string(h.version));
+    if (h.type != detail::flat_type<T>())
+      fail("scalar type mismatch");
+    if (h.size > len || h.size < sizeof(h) || h.records > (h.size - sizeof(h)) / sizeof(detail::flat_entry))
+      fail("truncated");
+    n = h.records;
+
+    for (size_t i = 0; i < n; i++) {
+      auto e = entry(i);
+      if (e.kind < uint32_t(record::biquads) || e.kind > uint32_t(record::ghk))
+        fail("record " + std::to_string(i) + " of unknown kind");
+      auto sz = detail::flat_sizes(e);
+      size_t scalars = detail::flat_add(sz.first, (e.flags & detail::flat_state) ? sz.second : 0);
+      if (e.offset % alignof(T) || e.offset > h.size || scalars > (h.size - e.offset) / sizeof(T))
+        fail("record " + std::to_string(i) + " out of bounds");
+    }
+  }
+
+  detail::flat_entry entry(size_t i) const {
+    if (i >= n)
+      fail("no record " + std::to_string(i));
+    detail::flat_entry e;
+    std::memcpy(&e, base + sizeof(detail::flat_header) + i * sizeof(e), sizeof(e));
+    return e;
+  }
+
+  detail::flat_entry expect(size_t i, record kind) const {
+    auto e = entry(i);
+    if (record(e.kind) != kind)
+      fail("record " + std::to_string(i) + " is of another kind");
+    return e;
+  }
+
+  const T *payload(const detail::flat_entry &e) const {
+    return reinterpret_cast<const T *>(base + e.offset);
+  }
+
+  template<size_t N, typename S, size_t... I>
+  filter::BiquadCascade<filter::Biquad<T, S>, N> cascade(const detail::flat_entry &e, std::index_sequence<I...>) const {
+    const T *p = payload(e);
+    const bool state = e.flags & detail::flat_state;
+    auto section = [&](size_t k) {
+      filter::Biquad<T, S> b(filter::sos<T>{p[k], p[N + k], p[2 * N + k], p[3 * N + k], p[4 * N + k]});
+      if (state)
+        b.state({p[5 * N + k], p[6 * N + k]});
+      return b;
+    };
+    return filter::BiquadCascade<filter::Biquad<T, S>, N>(section(I)...);
+  }
+};
+
+}
@@ -0,0 +1,355 @@
+/*
+ * Hot-path instrumentation
+ *
+ * Opt-in: define CONTROL_INSTRUMENT before including, or for the whole build,
+ * to record timing and signal statistics. Without it, Instrumented<C> holds a
+ * NullProbe, forwards to the component and records nothing. The macro only
+ * picks the default probe type, so translation units that disagree on it use
+ * different specializations rather than different definitions of one.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace control::system {
+
+/**
+ * Cheapest monotonic tick counter: the time-stamp counter on x86, the virtual
+ * counter on AArch64 and steady_clock nanoseconds elsewhere
+ *
+ * @return uint64_t ticks
+ */
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t t;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+  return t;
+#else
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * Ticks per second, measured once against steady_clock
+ *
+ * @return double
+ */
+inline double tick_rate() {
+  static const double rate = [] {
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t c1 = ticks();
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+    return double(c1 - c0) / dt.count();
+  }();
+  return rate;
+}
+
+/**
+ * Snapshot of the statistics of one component
+ *
+ * Bucket i of the histogram counts steps that took [2^i, 2^(i+1)) ticks;
+ * bucket 0 also holds steps of 0 ticks.
+ */
+struct stats {
+  static constexpr size_t buckets = 48;
+
+  uint64_t steps = 0;
+  uint64_t total = 0;
+  uint64_t min = 0;
+  uint64_t max = 0;
+  uint64_t misses = 0;
+  uint64_t nonfinite = 0;
+  uint64_t saturated = 0;
+  uint64_t saturations = 0;
+  std::array<uint64_t, buckets> histogram{};
+
+  /**
+   * @return double mean ticks per step
+   */
+  double mean() const {
+    return steps ? double(total) / double(steps) : 0.;
+  }
+
+  /**
+   * Upper bound of the quantile q from the histogram
+   *
+   * @param q quantile in [0, 1]
+   * @return uint64_t ticks
+   */
+  uint64_t quantile(double q) const {
+    uint64_t n = 0, target = uint64_t(std::ceil(q * double(steps)));
+    for (size_t i = 0; i < buckets; i++)
+      if ((n += histogram[i]) >= target && n > 0)
+        return (uint64_t(2) << i) - 1;
+    return max;
+  }
+};
+
+/**
+ * Lock-free statistics of one component
+ *
+ * Written by the stepping thread only, readable from any thread: every counter
+ * is a relaxed atomic updated with a plain load and store, so recording costs
+ * no read-modify-write and snapshot() never blocks the writer. Counters in a
+ * snapshot are individually exact but may be up to one step apart.
+ */
+class Probe {
+ public:
+  /**
+   * @param deadline_ ticks above which a step counts as a deadline miss, 0 for none
+   */
+  explicit Probe(uint64_t deadline_ = 0) : deadline(deadline_) {}
+
+  /**
+   * Record one step
+   *
+   * @param dt ticks the step took
+   * @param finite whether the output was finite
+   * @param clipping whether the output was saturated
+   */
+  void record(uint64_t dt, bool finite = true, bool clipping = false) {
+    bump(steps);
+    add(total, dt);
+    if (steps.load(std::memory_order_relaxed) == 1 || dt < min.load(std::memory_order_relaxed))
+      min.store(dt, std::memory_order_relaxed);
+    if (dt > max.load(std::memory_order_relaxed))
+      max.store(dt, std::memory_order_relaxed);
+    bump(histogram[bucket(dt)]);
+    if (deadline && dt > deadline)
+      bump(misses);
+    if (!finite)
+      bump(nonfinite);
+    if (clipping) {
+      bump(saturated);
+      if (!clipped)
+        bump(saturations);
+    }
+    clipped = clipping;
+  }
+
+  /**
+   * Copy the counters, from any thread
+   *
+   * @return stats
+   */
+  stats snapshot() const {
+    stats s;
+    s.steps = steps.load(std::memory_order_relaxed);
+    s.total = total.load(std::memory_order_relaxed);
+    s.min = min.load(std::memory_order_relaxed);
+    s.max = max.load(std::memory_order_relaxed);
+    s.misses = misses.load(std::memory_order_relaxed);
+    s.nonfinite = nonfinite.load(std::memory_order_relaxed);
+    s.saturated = saturated.load(std::memory_order_relaxed);
+    s.saturations = saturations.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < stats::buckets; i++)
+      s.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+    return s;
+  }
+
+  /**
+   * Clear the counters, from the writing thread
+   */
+  void reset() {
+    for (auto c : {&steps, &total, &min, &max, &misses, &nonfinite, &saturated, &saturations})
+      c->store(0, std::memory_order_relaxed);
+    for (auto &h : histogram)
+      h.store(0, std::memory_order_relaxed);
+    clipped = false;
+  }
+
+  // Deadline in ticks, 0 for none
+  uint64_t deadline;
+
+  static constexpr bool enabled = true;
+
+ protected:
+  using counter = std::atomic<uint64_t>;
+
+  counter steps{0}, total{0}, min{0}, max{0}, misses{0}, nonfinite{0}, saturated{0}, saturations{0};
+  std::array<counter, stats::buckets> histogram{};
+  bool clipped = false;
+
+  static void bump(counter &c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  static void add(counter &c, uint64_t v) {
+    c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+  }
+
+  static size_t bucket(uint64_t dt) {
+    size_t i = 0;
+    while (dt >>= 1)
+      i++;
+    return i < stats::buckets ? i : stats::buckets - 1;
+  }
+};
+
+/**
+ * Probe that records nothing, an empty type
+ */
+class NullProbe {
+ public:
+  explicit NullProbe(uint64_t = 0) {}
+
+  void record(uint64_t, bool = true, bool = false) {}
+
+  stats snapshot() const {
+    return {};
+  }
+
+  void reset() {}
+
+  // No deadline is checked
+  static constexpr uint64_t deadline = 0;
+
+  static constexpr bool enabled = false;
+};
+
+/**
+ * Probe of Instrumented<C> unless given: Probe with CONTROL_INSTRUMENT, NullProbe otherwise
+ */
+#ifdef CONTROL_INSTRUMENT
+using DefaultProbe = Probe;
+#else
+using DefaultProbe = NullProbe;
+#endif
+
+/**
+ * Whether instrumentation is compiled in by default
+ */
+constexpr bool instrumented = DefaultProbe::enabled;
+
+namespace detail {
+
+// Probe of Instrumented, held as a base so that an empty one takes no space
+template<typename P, bool = std::is_empty_v<P>>
+class probe_holder {
+ protected:
+  explicit probe_holder(uint64_t deadline) : p(deadline) {}
+
+  P &probe() { return p; }
+  const P &probe() const { return p; }
+
+ private:
+  P p;
+};
+
+template<typename P>
+class probe_holder<P, true> : private P {
+ protected:
+  explicit probe_holder(uint64_t deadline) : P(deadline) {}
+
+  P &probe() { return *this; }
+  const P &probe() const { return *this; }
+};
+
+}
+
+/**
+ * Instrumented component
+ *
+ * Wraps any component with a step method (PID, BiquadCascade, ss, ...) and
+ * records the ticks per step, non-finite outputs and, for controllers, the
+ * steps spent clipping and the number of times clipping started. The component
+ * itself stays reachable through component() or ->. The probe is an empty
+ * base with a NullProbe, so the wrapper is the size of the component and
+ * step() a plain forwarding call.
+ *
+ * @tparam C component
+ * @tparam P Probe or NullProbe
+ */
+template<typename C, typename P = DefaultProbe>
+class Instrumented : protected detail::probe_holder<P> {
+ public:
+  /**
+   * @param c_ component
+   * @param deadline ticks above which a step counts as a deadline miss, 0 for none
+   */
+  explicit Instrumented(C c_, uint64_t deadline = 0) : detail::probe_holder<P>(deadline), c(std::move(c_)) {}
+
+  /**
+   * Step the component
+   */
+  template<typename... A>
+  auto step(A &&... a) {
+    if constexpr (P::enabled) {
+      uint64_t t0 = ticks();
+      auto y = c.step(std::forward<A>(a)...);
+      uint64_t dt = ticks() - t0;
+      this->probe().record(dt, finite(y), clipping());
+      return y;
+    } else {
+      return c.step(std::forward<A>(a)...);
+    }
+  }
+
+  /**
+   * Statistics so far, safe to call from another thread
+   *
+   * @return stats, empty when instrumentation is disabled
+   */
+  stats snapshot() const {
+    return this->probe().snapshot();
+  }
+
+  /**
+   * @return P& the probe, e.g. to clear it or set its deadline
+   */
+  P &counters() {
+    return this->probe();
+  }
+
+  C &component() {
+    return c;
+  }
+
+  C *operator->() {
+    return &c;
+  }
+
+ protected:
+  C c;
+
+  template<typename U, typename = void>
+  struct has_clipping : std::false_type {};
+
+  template<typename U>
+  struct has_clipping<U, std::void_t<decltype(std::declval<U &>().clipping)>> : std::true_type {};
+
+  bool clipping() const {
+    if constexpr (has_clipping<C>::value)
+      return c.clipping;
+    else
+      return false;
+  }
+
+  template<typename Y>
+  static bool finite(const Y &y) {
+    if constexpr (std::is_arithmetic_v<Y>)
+      return std::isfinite(y);
+    else
+      return y.allFinite();
+  }
+};
+
+}
@@ -0,0 +1,353 @@
+/*
+ * Extended and unscented Kalman filters
+ */
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/AutoDiff>
+
+#include "control/system/nonlinear.h"
+
+namespace control::system {
+
+/**
+ * How ekf linearizes the system
+ *
+ * numeric: central differences, for any callables
+ * autodiff: forward-mode automatic differentiation; f and h must be generic
+ *           over the scalar type (e.g. generic lambdas over Eigen expressions)
+ */
+enum class jacobian { numeric, autodiff };
+
+/**
+ * Extended Kalman filter
+ *
+ * Estimates the state of a nlss from its inputs and noisy outputs, with
+ * process noise covariance Q and measurement noise covariance R. step follows
+ * nlss::step: the measurement z is the output after the state update with u.
+ *
+ *    ekf<decltype(P)> K(P, Q, R);
+ *    y = P.step(u);           // plant
+ *    auto x = K.step(u, y);   // estimate
+ *
+ * All storage is fixed-size; neither predict nor correct allocates.
+ *
+ * @tparam S nlss
+ * @tparam J Jacobian method
+ */
+template<typename S, jacobian J = jacobian::numeric>
+class ekf {
+ public:
+  using T = typename S::Scalar;
+  static constexpr size_t Nx = S::states, Nu = S::inputs, Ny = S::outputs;
+
+  using Tx = Eigen::Matrix<T, Nx, 1>;
+  using Tu = Eigen::Matrix<T, Nu, 1>;
+  using Ty = Eigen::Matrix<T, Ny, 1>;
+  using TP = Eigen::Matrix<T, Nx, Nx>;
+  using TR = Eigen::Matrix<T, Ny, Ny>;
+  using TH = Eigen::Matrix<T, Ny, Nx>;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+  /**
+   * @param sys system model
+   * @param Q process noise covariance
+   * @param R measurement noise covariance
+   * @param x0 initial estimate
+   * @param P0 initial estimate covariance
+   */
+  ekf(S sys, TP Q, TR R, Tx x0 = Tx::Zero(), TP P0 = TP::Identity())
+      : x{x0}, P{P0}, Q{Q}, R{R}, sys{std::move(sys)} {}
+
+  /**
+   * @var Tx state estimate
+   */
+  Tx x;
+
+  /**
+   * @var TP covariance of the state estimate
+   */
+  TP P;
+
+  /**
+   * @var TP process noise covariance
+   */
+  TP Q;
+
+  /**
+   * @var TR measurement noise covariance
+   */
+  TR R;
+
+  /**
+   * Propagate the estimate through the transition
+   *
+   * @param u input
+   */
+  void predict(const Tu &u) {
+    const TP F = transition_jacobian(x, u);
+    x = sys.transition(x, u);
+    P = F * P * F.transpose() + Q;
+  }
+
+  /**
+   * Correct the estimate with a measurement
+   *
+   * Uses the Joseph form, which keeps P symmetric and positive definite.
+   *
+   * @param z measured output
+   */
+  void correct(const Ty &z) {
+    const TH H = output_jacobian(x);
+    const TR Sy = H * P * H.transpose() + R;
+    const Eigen::Matrix<T, Nx, Ny> K = Sy.llt().solve(H * P).transpose();
+    x += K * (z - Ty(sys.output(x)));
+    const TP IKH = TP::Identity() - K * H;
+    P = IKH * P * IKH.transpose() + K * R * K.transpose();
+  }
+
+  /**
+   * Predict with u, then correct with z
+   *
+   * @param u input
+   * @param z measured output after the input
+   * @return Tx state estimate
+   */
+  Tx step(const Tu &u, const Ty &z) {
+    predict(u);
+    correct(z);
+    return x;
+  }
+
+  /**
+   * @return TP df/dx at x, u
+   */
+  TP transition_jacobian(const Tx &x0, const Tu &u) const {
+    TP F;
+    if constexpr (J == jacobian::autodiff) {
+      const Eigen::Matrix<AD<Nx>, Nx, 1> r = sys.transition(active(x0), u.template cast<AD<Nx>>().eval());
+      for (size_t i = 0; i < Nx; i++)
+        F.row(i) = r(i).derivatives().transpose();
+    } else {
+      for (size_t j = 0; j < Nx; j++) {
+        Tx a = x0, b = x0;
+        const T d = delta(x0(j));
+        a(j) += d;
+        b(j) -= d;
+        F.col(j) = (Tx(sys.transition(a, u)) - Tx(sys.transition(b, u))) / (a(j) - b(j));
+      }
+    }
+    return F;
+  }
+
+  /**
+   * @return TH dh/dx at x
+   */
+  TH output_jacobian(const Tx &x0) const {
+    TH H;
+    if constexpr (J == jacobian::autodiff) {
+      const Eigen::Matrix<AD<Nx>, Ny, 1> r = sys.output(active(x0));
+      for (size_t i = 0; i < Ny; i++)
+        H.row(i) = r(i).derivatives().transpose();
+    } else {
+      for (size_t j = 0; j < Nx; j++) {
+        Tx a = x0, b = x0;
+        const T d = delta(x0(j));
+        a(j) += d;
+        b(j) -= d;
+        H.col(j) = (Ty(sys.output(a)) - Ty(sys.output(b))) / (a(j) - b(j));
+      }
+    }
+    return H;
+  }
+
+  /**
+   * @return const S& system model
+   */
+  const S &system() const { return sys; }
+
+ protected:
+  template<size_t N>
+  using AD = Eigen::AutoDiffScalar<Eigen::Matrix<T, N, 1>>;
+
+  // x as independent variables
+  static Eigen::Matrix<AD<Nx>, Nx, 1> active(const Tx &x0) {
+    Eigen::Matrix<AD<Nx>, Nx, 1> a;
+    for (size_t i = 0; i < Nx; i++)
+      a(i) = AD<Nx>(x0(i), Nx, i);
+    return a;
+  }
+
+  // Central difference step, balancing truncation and rounding error
+  static T delta(T v) {
+    using std::abs, std::cbrt, std::max;
+    return cbrt(std::numeric_limits<T>::epsilon()) * max(T(1), abs(v));
+  }
+
+  S sys;
+};
+
+/**
+ * Unscented Kalman filter
+ *
+ * Propagates the 2 Nx + 1 scaled sigma points (van der Merwe) of the estimate
+ * through the system instead of linearizing it. With Batched, the sigma points
+ * go through f and h as one Nx x (2 Nx + 1) matrix with a state per column,
+ * so the transition runs as a few matrix operations instead of 2 Nx + 1
+ * evaluations; f and h then must accept matrices, as Eigen expressions over
+ * rows do. Without it, each sigma point is evaluated on its own.
+ *
+ * All storage is fixed-size; neither predict nor correct allocates. A
+ * covariance that is no longer positive definite throws std::domain_error.
+ *
+ * @tparam S nlss
+ * @tparam Batched evaluate all sigma points at once
+ */
+template<typename S, bool Batched = true>
+class ukf {
+ public:
+  using T = typename S::Scalar;
+  static constexpr size_t Nx = S::states, Nu = S::inputs, Ny = S::outputs;
+  static constexpr size_t Ns = 2 * Nx + 1;
+
+  using Tx = Eigen::Matrix<T, Nx, 1>;
+  using Tu = Eigen::Matrix<T, Nu, 1>;
+  using Ty = Eigen::Matrix<T, Ny, 1>;
+  using TP = Eigen::Matrix<T, Nx, Nx>;
+  using TR = Eigen::Matrix<T, Ny, Ny>;
+  using TX = Eigen::Matrix<T, Nx, Ns>;
+  using TY = Eigen::Matrix<T, Ny, Ns>;
+  using TW = Eigen::Matrix<T, Ns, 1>;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+  /**
+   * @param sys system model
+   * @param Q process noise covariance
+   * @param R measurement noise covariance
+   * @param x0 initial estimate
+   * @param P0 initial estimate covariance
+   * @param alpha spread of the sigma points
+   * @param beta prior knowledge of the distribution, 2 for Gaussian
+   * @param kappa secondary scaling
+   */
+  ukf(S sys, TP Q, TR R, Tx x0 = Tx::Zero(), TP P0 = TP::Identity(), T alpha = 1e-3, T beta = 2, T kappa = 0)
+      : x{x0}, P{P0}, Q{Q}, R{R}, sys{std::move(sys)} {
+    const T lambda = alpha * alpha * (Nx + kappa) - Nx;
+    gamma = std::sqrt(Nx + lambda);
+    Wm.setConstant(1 / (2 * (Nx + lambda)));
+    Wc = Wm;
+    Wm(0) = lambda / (Nx + lambda);
+    Wc(0) = Wm(0) + 1 - alpha * alpha + beta;
+  }
+
+  /**
+   * @var Tx state estimate
+   */
+  Tx x;
+
+  /**
+   * @var TP covariance of the state estimate
+   */
+  TP P;
+
+  /**
+   * @var TP process noise covariance
+   */
+  TP Q;
+
+  /**
+   * @var TR measurement noise covariance
+   */
+  TR R;
+
+  /**
+   * Propagate the sigma points through the transition
+   *
+   * @param u input
+   */
+  void predict(const Tu &u) {
+    sigma();
+    if constexpr (Batched) {
+      X = sys.transition(X, u.template replicate<1, Ns>());
+    } else {
+      for (size_t i = 0; i < Ns; i++)
+        X.col(i) = Tx(sys.transition(Tx(X.col(i)), u));
+    }
+    x = X * Wm;
+    X.colwise() -= x;
+    P = X * Wc.asDiagonal() * X.transpose() + Q;
+  }
+
+  /**
+   * Correct the estimate with a measurement
+   *
+   * @param z measured output
+   */
+  void correct(const Ty &z) {
+    sigma();
+    if constexpr (Batched) {
+      Y = sys.output(X);
+    } else {
+      for (size_t i = 0; i < Ns; i++)
+        Y.col(i) = Ty(sys.output(Tx(X.col(i))));
+    }
+    const Ty yhat = Y * Wm;
+    X.colwise() -= x;
+    Y.colwise() -= yhat;
+    const TR Pyy = Y * Wc.asDiagonal() * Y.transpose() + R;
+    const Eigen::Matrix<T, Nx, Ny> Pxy = X * Wc.asDiagonal() * Y.transpose();
+    const Eigen::Matrix<T, Nx, Ny> K = Pyy.llt().solve(Pxy.transpose()).transpose();
+    x += K * (z - yhat);
+    P -= K * Pyy * K.transpose();
+    P = (P + P.transpose()) / 2;
+  }
+
+  /**
+   * Predict with u, then correct with z
+   *
+   * @param u input
+   * @param z measured output after the input
+   * @return Tx state estimate
+   */
+  Tx step(const Tu &u, const Ty &z) {
+    predict(u);
+    correct(z);
+    return x;
+  }
+
+  /**
+   * @return const TX& sigma points of the last predict or correct
+   */
+  const TX &sigma_points() const { return X; }
+
+  /**
+   * @return const S& system model
+   */
+  const S &system() const { return sys; }
+
+ protected:
+  // x and x +- gamma sqrt(P)
+  void sigma() {
+    const Eigen::LLT<TP> llt(P);
+    if (llt.info() != Eigen::Success)
+      throw std::domain_error("ukf: covariance is not positive definite");
+    const TP L = gamma * llt.matrixL().toDenseMatrix();
+    X.col(0) = x;
+    X.template middleCols<Nx>(1) = L.colwise() + x;
+    X.template rightCols<Nx>() = (-L).colwise() + x;
+  }
+
+  S sys;
+  T gamma;
+  TW Wm, Wc;
+  TX X;
+  TY Y;
+};
+
+}
@@ -0,0 +1,134 @@
+/*
+ * Memory-mapped files
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace control::system {
+
+/**
+ * Memory-mapped file
+ *
+ * Maps a whole file read-only, or creates (truncates) a file of a given size
+ * and maps it writable. Failures throw std::system_error with the errno of the
+ * failing call. POSIX only.
+ */
+class MappedFile {
+ public:
+  /**
+   * Map an existing file read-only
+   *
+   * @param path
+   */
+  explicit MappedFile(const std::string &path) {
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      fail("open " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) < 0)
+      fail("stat " + path);
+    len = size_t(st.st_size);
+    map(PROT_READ, path);
+  }
+
+  /**
+   * Create a file of len bytes, or truncate an existing one, and map it writable
+   *
+   * @param path
+   * @param len_ size in bytes
+   */
+  MappedFile(const std::string &path, size_t len_) : len(len_), rw(true) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      fail("open " + path);
+    if (::ftruncate(fd, off_t(len)) < 0)
+      fail("truncate " + path);
+    map(PROT_READ | PROT_WRITE, path);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&o) noexcept : fd(o.fd), addr(o.addr), len(o.len), rw(o.rw) {
+    o.fd = -1;
+    o.addr = nullptr;
+  }
+
+  ~MappedFile() {
+    if (addr)
+      ::munmap(addr, len);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  /**
+   * Hint that the mapping will be read front to back
+   */
+  void sequential() const {
+    if (addr)
+      ::madvise(addr, len, MADV_SEQUENTIAL);
+  }
+
+  /**
+   * Write dirty pages back to the file
+   */
+  void sync() const {
+    if (addr && rw && ::msync(addr, len, MS_SYNC) < 0)
+      throw std::system_error(errno, std::generic_category(), "msync");
+  }
+
+  const void *data() const {
+    return addr;
+  }
+
+  /**
+   * @return void* the mapping, which faults on writes unless writable()
+   */
+  void *data() {
+    return addr;
+  }
+
+  size_t size() const {
+    return len;
+  }
+
+  bool writable() const {
+    return rw;
+  }
+
+ protected:
+  int fd = -1;
+  void *addr = nullptr;
+  size_t len = 0;
+  bool rw = false;
+
+  void map(int prot, const std::string &path) {
+    // Empty files cannot be mapped; they have no data either
+    if (len == 0)
+      return;
+    void *p = ::mmap(nullptr, len, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+      fail("mmap " + path);
+    addr = p;
+  }
+
+  [[noreturn]] void fail(const std::string &what) {
+    int e = errno;
+    if (fd >= 0)
+      ::close(fd);
+    fd = -1;
+    throw std::system_error(e, std::generic_category(), what);
+  }
+};
+
+}
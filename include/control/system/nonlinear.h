@@ -0,0 +1,130 @@
+/*
+ * Nonlinear state-space
+ */
+
+#pragma once
+
+#include <utility>
+
+#include <Eigen/Dense>
+
+namespace control::system {
+
+/**
+ * Nonlinear discrete state-space
+ *
+ *    x = f(x, u)
+ *    y = h(x)
+ *
+ * f and h are callables on Eigen vectors. Written as generic lambdas over
+ * Eigen expressions, they evaluate as well on other scalar types (automatic
+ * differentiation for ekf) and on matrices with one state per column (batched
+ * sigma points for ukf):
+ *
+ *    auto f = [Ts](const auto &x, const auto &u) {
+ *      auto r = x.eval();
+ *      r.row(0) += Ts * x.row(1);
+ *      r.row(1) += Ts * (u.row(0) - 9.81 * x.row(0).array().sin().matrix());
+ *      return r;
+ *    };
+ *    auto h = [](const auto &x) { return x.row(0).eval(); };
+ *    auto P = nonlinear<double, 2>(f, h);
+ *
+ * Like ss, step returns the output after the state update.
+ *
+ * @tparam T storage-type
+ * @tparam Nx number of states
+ * @tparam Nu number of inputs
+ * @tparam Ny number of outputs
+ * @tparam F transition x = f(x, u)
+ * @tparam H output y = h(x)
+ */
+template<typename T, size_t Nx, size_t Nu, size_t Ny, typename F, typename H>
+class nlss {
+ public:
+  using Scalar = T;
+  static constexpr size_t states = Nx, inputs = Nu, outputs = Ny;
+
+  using Tx = Eigen::Matrix<T, Nx, 1>;
+  using Tu = Eigen::Matrix<T, Nu, 1>;
+  using Ty = Eigen::Matrix<T, Ny, 1>;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+  /**
+   * Construct a new nonlinear SS and initialize the output and state to zero
+   *
+   * @param F f transition
+   * @param H h output
+   */
+  nlss(F f, H h) : f{std::move(f)}, h{std::move(h)} {
+    x = Tx::Zero();
+    y = Ty::Zero();
+  }
+
+  /**
+   * @var Tx current state of the system
+   */
+  Tx x;
+
+  /**
+   * @var Ty current output of the system
+   */
+  Ty y;
+
+  /**
+   * Step the system
+   *
+   * @param Tu u input
+   * @return Ty output
+   */
+  Ty step(const Tu &u) {
+    x = f(x, u);
+    y = h(x);
+    return y;
+  }
+
+  /**
+   * Evaluate the transition without changing the system
+   *
+   * @param x states, a vector or one state per column
+   * @param u inputs, one per column of x
+   * @return next states
+   */
+  template<typename X, typename U>
+  auto transition(const X &x, const U &u) const {
+    return f(x, u);
+  }
+
+  /**
+   * Evaluate the output without changing the system
+   *
+   * @param x states, a vector or one state per column
+   * @return outputs
+   */
+  template<typename X>
+  auto output(const X &x) const {
+    return h(x);
+  }
+
+ private:
+  F f;
+  H h;
+};
+
+/**
+ * Make a nonlinear state-space from its callables
+ *
+ * @tparam T storage-type
+ * @tparam Nx number of states
+ * @tparam Nu number of inputs
+ * @tparam Ny number of outputs
+ * @param f transition x = f(x, u)
+ * @param h output y = h(x)
+ * @return nlss
+ */
+template<typename T, size_t Nx, size_t Nu = 1, size_t Ny = 1, typename F, typename H>
+nlss<T, Nx, Nu, Ny, F, H> nonlinear(F f, H h) {
+  return {std::move(f), std::move(h)};
+}
+
+}
@@ -0,0 +1,480 @@
+/*
+ * Integrators for continuous-time plants
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <Eigen/Dense>
+
+namespace control::system::ode {
+
+/**
+ * Integrators advance the state x of dx/dt = f(t, x) from t to t1:
+ *
+ *    I.integrate(f, t, x, t1);
+ *
+ * x is a fixed-size Eigen vector, like ss::Tx, or a fixed-size matrix with
+ * one instance of the plant per column. Batched like that, f sees all
+ * instances at once and runs as matrix operations; f written as Eigen
+ * expressions over rows serves both. Adaptive integrators then share one step
+ * size, controlled by the worst instance.
+ *
+ * integrate() always ends exactly on t1 and never steps across it, so an
+ * input held by a discrete controller may change there.
+ */
+
+namespace detail {
+
+// RMS of the error relative to the tolerances
+template<typename X>
+typename X::Scalar norm(const X &e, const X &x0, const X &x1, typename X::Scalar rtol, typename X::Scalar atol) {
+  return std::sqrt((e.array() / (atol + rtol * x0.cwiseAbs().cwiseMax(x1.cwiseAbs()).array())).square().mean());
+}
+
+// Step size after a rejection; throws once it has collapsed, e.g. on a non-finite f
+template<typename T>
+T shrink(T s, T fac, T t, T t1, const char *what) {
+  const T h = s * (std::isfinite(fac) ? std::min(fac, T(1)) : T(0.2));
+  if (!(h >= 16 * std::numeric_limits<T>::epsilon() * std::max(std::abs(t), std::abs(t1))))
+    throw std::domain_error(std::string(what) + ": step size collapsed, f may be non-finite");
+  return h;
+}
+
+// Starting step after Hairer, Norsett and Wanner
+template<typename X>
+typename X::Scalar initial(const X &x, const X &dx, typename X::Scalar rtol, typename X::Scalar atol) {
+  using T = typename X::Scalar;
+  const T d0 = norm(x, x, x, rtol, atol), d1 = norm(dx, x, x, rtol, atol);
+  return d0 < T(1e-5) || d1 < T(1e-5) ? T(1e-6) : T(0.01) * d0 / d1;
+}
+
+}
+
+/**
+ * Classic fourth-order Runge-Kutta with fixed step
+ *
+ * Splits every interval into equal steps no longer than h.
+ *
+ * @tparam X state
+ */
+template<typename X>
+class rk4 {
+ public:
+  using T = typename X::Scalar;
+  using state = X;
+
+  /**
+   * @param h longest step
+   */
+  explicit rk4(T h) : h{h} {}
+
+  /**
+   * Integrate from t to t1
+   *
+   * @param f dx/dt = f(t, x)
+   * @param t time, set to t1
+   * @param x state
+   * @param t1 end time
+   */
+  template<typename F>
+  void integrate(F &&f, T &t, X &x, T t1) {
+    const auto n = std::max<int64_t>(1, int64_t(std::ceil((t1 - t) / h * (1 - 8 * std::numeric_limits<T>::epsilon()))));
+    const T s = (t1 - t) / n, t0 = t;
+    for (int64_t i = 0; i < n; i++) {
+      const T ti = t0 + i * s;
+      k1 = f(ti, x);
+      k2 = f(ti + s / 2, X(x + s / 2 * k1));
+      k3 = f(ti + s / 2, X(x + s / 2 * k2));
+      k4 = f(ti + s, X(x + s * k3));
+      x += s / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+    }
+    evaluations += 4 * n;
+    t = t1;
+  }
+
+  /**
+   * @var T longest step
+   */
+  T h;
+
+  /**
+   * @var uint64_t evaluations of f
+   */
+  uint64_t evaluations = 0;
+
+ protected:
+  X k1 = X::Zero(), k2 = X::Zero(), k3 = X::Zero(), k4 = X::Zero();
+};
+
+/**
+ * Dormand-Prince 5(4) with adaptive step and dense output
+ *
+ * After each step, the state anywhere in the step is interpolated to fifth
+ * order without evaluating f again, so a plant taking long steps can be
+ * sampled at many controller instants; see sample(). Throws
+ * std::domain_error when rejected steps collapse, as they do once f returns
+ * NaN.
+ *
+ * @tparam X state
+ */
+template<typename X>
+class dopri5 {
+ public:
+  using T = typename X::Scalar;
+  using state = X;
+
+  /**
+   * @param rtol relative tolerance
+   * @param atol absolute tolerance
+   * @param hmax longest step, 0 for none
+   */
+  explicit dopri5(T rtol = 1e-6, T atol = 1e-9, T hmax = 0) : rtol{rtol}, atol{atol}, hmax{hmax} {}
+
+  /**
+   * Integrate from t to t1
+   *
+   * @param f dx/dt = f(t, x)
+   * @param t time, set to t1
+   * @param x state
+   * @param t1 end time
+   */
+  template<typename F>
+  void integrate(F &&f, T &t, X &x, T t1) {
+    k1 = f(t, x);
+    evaluations++;
+    while (t < t1)
+      step(f, t, x, t1);
+  }
+
+  /**
+   * Integrate from t to t1, observing the state every dt
+   *
+   * @param f dx/dt = f(t, x)
+   * @param t time, set to t1
+   * @param x state
+   * @param t1 end time
+   * @param dt interval between observations
+   * @param out called as out(ti, xi) at t + dt, t + 2 dt, ... up to t1
+   */
+  template<typename F, typename G>
+  void sample(F &&f, T &t, X &x, T t1, T dt, G &&out) {
+    const T t0 = t;
+    const auto n = int64_t(std::floor((t1 - t0) / dt * (1 + 8 * std::numeric_limits<T>::epsilon())));
+    int64_t i = 1;
+    k1 = f(t, x);
+    evaluations++;
+    while (t < t1) {
+      step(f, t, x, t1);
+      for (; i <= n && std::min(t0 + i * dt, t1) <= t; i++)
+        out(std::min(t0 + i * dt, t1), interpolate(std::min(t0 + i * dt, t1)));
+    }
+  }
+
+  /**
+   * State within the last step
+   *
+   * @param s time in the last step
+   * @return X interpolated state
+   */
+  X interpolate(T s) const {
+    const T th = (s - t0) / hs, th1 = 1 - th;
+    return r1 + th * (r2 + th1 * (r3 + th * (r4 + th1 * r5)));
+  }
+
+  /**
+   * @var T relative tolerance
+   */
+  T rtol;
+
+  /**
+   * @var T absolute tolerance
+   */
+  T atol;
+
+  /**
+   * @var T longest step, 0 for none
+   */
+  T hmax;
+
+  /**
+   * @var T next step size, 0 to estimate it
+   */
+  T h = 0;
+
+  /**
+   * @var uint64_t steps and evaluations of f
+   */
+  uint64_t accepted = 0, rejected = 0, evaluations = 0;
+
+ protected:
+  // One accepted step, k1 holds f(t, x)
+  template<typename F>
+  void step(F &&f, T &t, X &x, T t1) {
+    static constexpr T a21 = T(1) / 5;
+    static constexpr T a31 = T(3) / 40, a32 = T(9) / 40;
+    static constexpr T a41 = T(44) / 45, a42 = T(-56) / 15, a43 = T(32) / 9;
+    static constexpr T a51 = T(19372) / 6561, a52 = T(-25360) / 2187, a53 = T(64448) / 6561, a54 = T(-212) / 729;
+    static constexpr T a61 = T(9017) / 3168, a62 = T(-355) / 33, a63 = T(46732) / 5247, a64 = T(49) / 176,
+                       a65 = T(-5103) / 18656;
+    static constexpr T a71 = T(35) / 384, a73 = T(500) / 1113, a74 = T(125) / 192, a75 = T(-2187) / 6784,
+                       a76 = T(11) / 84;
+    static constexpr T e1 = T(71) / 57600, e3 = T(-71) / 16695, e4 = T(71) / 1920, e5 = T(-17253) / 339200,
+                       e6 = T(22) / 525, e7 = T(-1) / 40;
+    static constexpr T d1 = T(-12715105075.) / 11282082432, d3 = T(87487479700.) / 32700410799,
+                       d4 = T(-10690763975.) / 1880347072, d5 = T(701980252875.) / 199316789632,
+                       d6 = T(-1453857185.) / 822651844, d7 = T(69997945.) / 29380423;
+
+    if (h <= 0)
+      h = detail::initial(x, k1, rtol, atol);
+    for (;;) {
+      if (hmax > 0)
+        h = std::min(h, hmax);
+      const bool last = t + h >= t1;
+      const T s = last ? t1 - t : h;
+
+      k2 = f(t + s / 5, X(x + s * a21 * k1));
+      k3 = f(t + s * 3 / 10, X(x + s * (a31 * k1 + a32 * k2)));
+      k4 = f(t + s * 4 / 5, X(x + s * (a41 * k1 + a42 * k2 + a43 * k3)));
+      k5 = f(t + s * 8 / 9, X(x + s * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4)));
+      k6 = f(t + s, X(x + s * (a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5)));
+      x1 = x + s * (a71 * k1 + a73 * k3 + a74 * k4 + a75 * k5 + a76 * k6);
+      k7 = f(t + s, x1);
+      evaluations += 6;
+
+      const X e = s * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7);
+      const T err = detail::norm(e, x, x1, rtol, atol);
+      const T fac = std::clamp(T(0.9) * std::pow(std::max(err, T(1e-10)), T(-0.2)), T(0.2), T(10));
+      if (!(err <= 1)) {
+        rejected++;
+        h = detail::shrink(s, fac, t, t1, "dopri5");
+        continue;
+      }
+
+      // Dense output coefficients
+      r1 = x;
+      r2 = x1 - x;
+      r3 = s * k1 - r2;
+      r4 = r2 - s * k7 - r3;
+      r5 = s * (d1 * k1 + d3 * k3 + d4 * k4 + d5 * k5 + d6 * k6 + d7 * k7);
+      t0 = t;
+      hs = s;
+
+      accepted++;
+      if (!last || s >= h)
+        h = s * fac;
+      t = last ? t1 : t + s;
+      x = x1;
+      k1 = k7;
+      return;
+    }
+  }
+
+  X k1 = X::Zero(), k2 = X::Zero(), k3 = X::Zero(), k4 = X::Zero(), k5 = X::Zero(), k6 = X::Zero(),
+    k7 = X::Zero(), x1 = X::Zero();
+  X r1 = X::Zero(), r2 = X::Zero(), r3 = X::Zero(), r4 = X::Zero(), r5 = X::Zero();
+  T t0 = 0, hs = 1;
+};
+
+/**
+ * Linearly implicit Rosenbrock method ROS2 with adaptive step, for stiff plants
+ *
+ * Second-order and L-stable (Verwer et al. 1999): fast modes that would make
+ * explicit methods take tiny steps are damped at any step size. Every step
+ * solves two linear systems with I - gamma h J, where the Jacobian J and the
+ * time derivative of f are estimated by forward differences. For batched
+ * states, J of every instance comes from the same Nx evaluations of f, one
+ * per perturbed row. The step size follows the embedded first-order solution;
+ * like dopri5, a collapsing step size throws std::domain_error.
+ *
+ * @tparam X state
+ */
+template<typename X>
+class ros2 {
+ public:
+  using T = typename X::Scalar;
+  using state = X;
+  static constexpr int Nx = X::RowsAtCompileTime, K = X::ColsAtCompileTime;
+  using TJ = Eigen::Matrix<T, Nx, Nx>;
+
+  /**
+   * @param rtol relative tolerance
+   * @param atol absolute tolerance
+   * @param hmax longest step, 0 for none
+   */
+  explicit ros2(T rtol = 1e-4, T atol = 1e-7, T hmax = 0) : rtol{rtol}, atol{atol}, hmax{hmax} {}
+
+  /**
+   * Integrate from t to t1
+   *
+   * @param f dx/dt = f(t, x)
+   * @param t time, set to t1
+   * @param x state
+   * @param t1 end time
+   */
+  template<typename F>
+  void integrate(F &&f, T &t, X &x, T t1) {
+    static const T gamma = 1 + 1 / std::sqrt(T(2));
+
+    std::array<TJ, K> J;
+    std::array<Eigen::PartialPivLU<TJ>, K> lu;
+    while (t < t1) {
+      f0 = f(t, x);
+      jacobian(f, t, x, J);
+      if (h <= 0)
+        h = detail::initial(x, f0, rtol, atol);
+      for (;;) {
+        if (hmax > 0)
+          h = std::min(h, hmax);
+        const bool last = t + h >= t1;
+        const T s = last ? t1 - t : h;
+
+        for (int k = 0; k < K; k++)
+          lu[k].compute(TJ::Identity() - gamma * s * J[k]);
+        solve(lu, X(f0 + gamma * s * ft), k1);
+        f1 = f(t + s, X(x + s * k1));
+        evaluations++;
+        solve(lu, X(f1 - 2 * k1 - gamma * s * ft), k2);
+        x1 = x + s * (T(1.5) * k1 + T(0.5) * k2);
+        e = s / 2 * (k1 + k2);
+
+        const T err = detail::norm(e, x, x1, rtol, atol);
+        const T fac = std::clamp(T(0.8) * std::pow(std::max(err, T(1e-10)), T(-0.5)), T(0.2), T(5));
+        if (!(err <= 1)) {
+          rejected++;
+          h = detail::shrink(s, fac, t, t1, "ros2");
+          continue;
+        }
+        accepted++;
+        if (!last || s >= h)
+          h = s * fac;
+        t = last ? t1 : t + s;
+        x = x1;
+        break;
+      }
+    }
+  }
+
+  /**
+   * @var T relative tolerance
+   */
+  T rtol;
+
+  /**
+   * @var T absolute tolerance
+   */
+  T atol;
+
+  /**
+   * @var T longest step, 0 for none
+   */
+  T hmax;
+
+  /**
+   * @var T next step size, 0 to estimate it
+   */
+  T h = 0;
+
+  /**
+   * @var uint64_t steps and evaluations of f
+   */
+  uint64_t accepted = 0, rejected = 0, evaluations = 0;
+
+ protected:
+  // Forward differences of every instance, perturbing one row at a time, and in time
+  template<typename F>
+  void jacobian(F &&f, T t, const X &x, std::array<TJ, K> &J) {
+    const T eps = std::sqrt(std::numeric_limits<T>::epsilon());
+    for (int j = 0; j < Nx; j++) {
+      X xp = x;
+      xp.row(j).array() += eps * xp.row(j).array().abs().max(T(1));
+      const X d = f(t, xp) - f0;
+      for (int k = 0; k < K; k++)
+        J[k].col(j) = d.col(k) / (xp(j, k) - x(j, k));
+    }
+    const T dt = eps * std::max(T(1), std::abs(t));
+    ft = (f(t + dt, x) - f0) / dt;
+    evaluations += 2 + Nx;
+  }
+
+  static void solve(const std::array<Eigen::PartialPivLU<TJ>, K> &lu, const X &b, X &y) {
+    for (int k = 0; k < K; k++)
+      y.col(k) = lu[k].solve(b.col(k));
+  }
+
+  X f0 = X::Zero(), ft = X::Zero(), f1 = X::Zero(), k1 = X::Zero(), k2 = X::Zero(), x1 = X::Zero(), e = X::Zero();
+};
+
+/**
+ * Continuous-time plant sampled behind a zero-order hold
+ *
+ * Runs dx/dt = f(t, x, u) next to discrete controllers: each step holds u
+ * for one sample time Ts and integrates to the next instant.
+ *
+ *    zoh P(dopri5<Eigen::Vector2d>(), [](double t, const auto &x, double u) { ... }, Ts);
+ *    for (...) {
+ *      double u = pid.step(r - y);
+ *      y = P.step(u)(0);
+ *    }
+ *
+ * @tparam I integrator
+ * @tparam F dx/dt = f(t, x, u)
+ */
+template<typename I, typename F>
+class zoh {
+ public:
+  using X = typename I::state;
+  using T = typename I::T;
+
+  /**
+   * @param integrator
+   * @param f dx/dt = f(t, x, u)
+   * @param Ts sample time
+   * @param x0 initial state
+   */
+  zoh(I integrator, F f, T Ts, X x0 = X::Zero()) : x{x0}, integrator{std::move(integrator)}, f{std::move(f)}, Ts{Ts} {}
+
+  /**
+   * @var X current state of the plant
+   */
+  X x;
+
+  /**
+   * @var T current time
+   */
+  T t = 0;
+
+  /**
+   * @var I integrator
+   */
+  I integrator;
+
+  /**
+   * Hold u for one sample time
+   *
+   * @param u input
+   * @return const X& state at the next instant
+   */
+  template<typename U>
+  const X &step(const U &u) {
+    const T t1 = ++k * Ts;
+    integrator.integrate([this, &u](T ti, const X &xi) { return f(ti, xi, u); }, t, x, t1);
+    return x;
+  }
+
+ protected:
+  F f;
+  T Ts;
+  uint64_t k = 0;
+};
+
+}
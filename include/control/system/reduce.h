@@ -0,0 +1,383 @@
+/*
+ * Model order reduction by balanced truncation
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseLU>
+
+#include "control/system/ss.h"
+
+namespace control::system {
+
+/**
+ * Reduced model
+ *
+ * @tparam T arithmetic type
+ * @tparam Nr reduced order
+ * @tparam Nu number of inputs
+ * @tparam Ny number of outputs
+ */
+template<typename T, size_t Nr, size_t Nu, size_t Ny>
+struct reduction {
+  ss<T, Nr, Nu, Ny> model;
+
+  // Bound on the H-infinity norm of the error: twice the sum of the truncated Hankel singular values
+  T bound;
+
+  // Hankel singular values, descending
+  std::vector<T> hsv;
+};
+
+namespace reduce {
+
+template<typename T>
+using MatrixX = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+template<typename T>
+using VectorX = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+template<typename T>
+using SparseX = Eigen::SparseMatrix<T>;
+
+/**
+ * Solve the Stein (discrete Lyapunov) equation P = A P A' + Q
+ *
+ * Squared Smith iteration: P accumulates A^k Q A'^k while A is squared, so the
+ * number of iterations grows with the logarithm of the slowest time constant.
+ * Throws std::domain_error when A is not stable.
+ *
+ * @param A dense state matrix, spectral radius below one
+ * @param Q symmetric right-hand side
+ * @param tol relative size of the last increment
+ * @return MatrixX<T> P
+ */
+template<typename T>
+MatrixX<T> stein(MatrixX<T> A, MatrixX<T> Q, T tol = 16 * std::numeric_limits<T>::epsilon()) {
+  for (int k = 0; k < 64; k++) {
+    MatrixX<T> dQ = A * Q * A.transpose();
+    Q += dQ;
+    if (!Q.allFinite())
+      break;
+    if (dQ.template lpNorm<Eigen::Infinity>() <= tol * Q.template lpNorm<Eigen::Infinity>())
+      return Q;
+    A = A * A;
+  }
+  throw std::domain_error("stein: no convergence, the system is not stable");
+}
+
+/**
+ * Factor Z of a positive semi-definite P = Z Z', dropping negligible directions
+ *
+ * @param P
+ * @return MatrixX<T> Z
+ */
+template<typename T>
+MatrixX<T> factor(const MatrixX<T> &P) {
+  Eigen::SelfAdjointEigenSolver<MatrixX<T>> es(P);
+  const auto &l = es.eigenvalues();
+  const T floor = l.cwiseAbs().maxCoeff() * T(P.rows()) * std::numeric_limits<T>::epsilon();
+  Eigen::Index r = 0;
+  while (r < l.size() && l(l.size() - 1 - r) > floor)
+    r++;
+  VectorX<T> s = l.tail(r).cwiseSqrt();
+  return es.eigenvectors().rightCols(r) * s.asDiagonal();
+}
+
+namespace detail {
+
+// Ritz values of op after k Arnoldi steps from v
+template<typename T, typename Op>
+std::vector<std::complex<T>> ritz(Op op, VectorX<T> v, Eigen::Index k) {
+  const Eigen::Index n = v.size();
+  k = std::min(k, n);
+  MatrixX<T> V(n, k + 1), H = MatrixX<T>::Zero(k + 1, k);
+  V.col(0) = v.normalized();
+  Eigen::Index m = k;
+  for (Eigen::Index j = 0; j < k; j++) {
+    VectorX<T> w = op(V.col(j));
+    for (int pass = 0; pass < 2; pass++) {
+      VectorX<T> h = V.leftCols(j + 1).transpose() * w;
+      w -= V.leftCols(j + 1) * h;
+      H.col(j).head(j + 1) += h;
+    }
+    H(j + 1, j) = w.norm();
+    if (H(j + 1, j) <= std::numeric_limits<T>::epsilon() * H.col(j).norm()) {
+      m = j + 1;
+      break;
+    }
+    V.col(j + 1) = w / H(j + 1, j);
+  }
+  Eigen::EigenSolver<MatrixX<T>> es(H.topLeftCorner(m, m), false);
+  return {es.eigenvalues().data(), es.eigenvalues().data() + m};
+}
+
+}
+
+/**
+ * ADI shifts for the Stein equation of a sparse A
+ *
+ * The equation maps to a continuous Lyapunov equation with Ac = (A + I)^-1 (A - I).
+ * Ritz values of Ac and of its inverse, from a few Arnoldi steps, are the
+ * candidates of Penzl's heuristic, which picks shifts that minimize the ADI
+ * ratio over the candidates. Complex shifts are returned as adjacent conjugate
+ * pairs.
+ *
+ * @param A sparse state matrix
+ * @param l number of shifts
+ * @return std::vector<std::complex<T>> shifts with negative real parts
+ */
+template<typename T>
+std::vector<std::complex<T>> shifts(const SparseX<T> &A, size_t l = 16) {
+  using C = std::complex<T>;
+  const Eigen::Index n = A.rows();
+  SparseX<T> I(n, n);
+  I.setIdentity();
+  SparseX<T> Ap = A + I, Am = A - I;
+  Eigen::SparseLU<SparseX<T>> lp(Ap), lm(Am);
+  if (lp.info() != Eigen::Success || lm.info() != Eigen::Success)
+    throw std::domain_error("shifts: A has eigenvalues at 1 or -1");
+
+  VectorX<T> v = VectorX<T>::Ones(n);
+  auto big = detail::ritz<T>([&](const VectorX<T> &x) { return VectorX<T>(lp.solve(Am * x)); }, v, 24);
+  auto small = detail::ritz<T>([&](const VectorX<T> &x) { return VectorX<T>(lm.solve(Ap * x)); }, v, 12);
+
+  std::vector<C> R;
+  for (auto z : big)
+    if (z.real() < 0)
+      R.push_back(z);
+  for (auto z : small)
+    if (z.real() < 0)
+      R.push_back(T(1) / z);
+  if (R.empty())
+    throw std::domain_error("shifts: the system is not stable");
+
+  auto ratio = [](const std::vector<C> &S, C x) {
+    T r = 1;
+    for (auto p : S)
+      r *= std::abs((p - x) / (p + x));
+    return r;
+  };
+  // Real shifts, or the upper shift of a pair followed by its conjugate
+  auto add = [](std::vector<C> &S, C p) {
+    if (std::abs(p.imag()) <= std::sqrt(std::numeric_limits<T>::epsilon()) * std::abs(p)) {
+      S.push_back(p.real());
+    } else {
+      S.push_back(C(p.real(), std::abs(p.imag())));
+      S.push_back(C(p.real(), -std::abs(p.imag())));
+    }
+  };
+
+  // Best single shift, then repeatedly the candidate that is worst off
+  std::vector<C> S;
+  C best = R[0];
+  T m = std::numeric_limits<T>::infinity();
+  for (auto p : R) {
+    T worst = 0;
+    for (auto x : R)
+      worst = std::max(worst, ratio({p}, x));
+    if (worst < m) {
+      m = worst;
+      best = p;
+    }
+  }
+  add(S, best);
+  while (S.size() < l) {
+    C x = R[0];
+    T worst = -1;
+    for (auto y : R) {
+      T r = ratio(S, y);
+      if (r > worst) {
+        worst = r;
+        x = y;
+      }
+    }
+    if (worst <= 0)
+      break;
+    add(S, x);
+  }
+  return S;
+}
+
+/**
+ * Low-rank factor Z of the solution of P = A P A' + B B' for a sparse A
+ *
+ * Low-rank ADI on the equivalent continuous Lyapunov equation, cycling over
+ * the shifts with one sparse LU per shift. Stops when the latest block is
+ * below tol relative to Z, then compresses Z to its numerical rank.
+ *
+ * @param A sparse state matrix, spectral radius below one
+ * @param B input matrix
+ * @param p shifts, as from shifts()
+ * @param tol relative size of the last block
+ * @param columns maximum number of columns of Z before compression
+ * @return MatrixX<T> Z with P ~ Z Z'
+ */
+template<typename T>
+MatrixX<T> stein(const SparseX<T> &A, const MatrixX<T> &B, const std::vector<std::complex<T>> &p,
+                 T tol = T(1e-10), Eigen::Index columns = 4000) {
+  using C = std::complex<T>;
+  using MC = MatrixX<C>;
+  const Eigen::Index n = A.rows(), m = B.cols();
+  SparseX<T> I(n, n);
+  I.setIdentity();
+  SparseX<T> Ap = A + I;
+  SparseX<C> Ac = A.template cast<C>(), Ic = I.template cast<C>();
+
+  Eigen::SparseLU<SparseX<T>> lp(Ap);
+  MC Bc = (std::sqrt(T(2)) * MatrixX<T>(lp.solve(B))).template cast<C>();
+
+  // (Ac + p I)^-1 X = (A + I) ((1 + p) A + (p - 1) I)^-1 X
+  std::vector<std::unique_ptr<Eigen::SparseLU<SparseX<C>>>> lu(p.size());
+  SparseX<C> Apc = Ap.template cast<C>();
+  auto solve = [&](size_t j, const MC &X) {
+    if (!lu[j]) {
+      SparseX<C> M = (C(1) + p[j]) * Ac + (p[j] - C(1)) * Ic;
+      lu[j] = std::make_unique<Eigen::SparseLU<SparseX<C>>>(M);
+    }
+    return MC(Apc * MC(lu[j]->solve(X)));
+  };
+
+  MC Z(n, std::min<Eigen::Index>(columns, 32 * m));
+  Eigen::Index k = 0;
+  MC V = std::sqrt(-2 * p[0].real()) * solve(0, Bc);
+  T z2 = 0;
+  for (size_t i = 0;; i++) {
+    if (k + m > Z.cols())
+      Z.conservativeResize(n, std::min(columns, 2 * Z.cols()));
+    Z.middleCols(k, m) = V;
+    k += m;
+    T v2 = V.squaredNorm();
+    z2 += v2;
+    if (!std::isfinite(z2))
+      throw std::domain_error("stein: no convergence, the system is not stable");
+
+    // Only stop after both shifts of a conjugate pair
+    const C pi = p[i % p.size()];
+    if (pi.imag() <= 0 && v2 <= tol * tol * z2)
+      break;
+    if (k + m > columns)
+      throw std::domain_error("stein: no convergence within the column limit");
+
+    const size_t j = (i + 1) % p.size();
+    V = std::sqrt(p[j].real() / pi.real()) * (V - (p[j] + std::conj(pi)) * solve(j, V));
+  }
+
+  // Real factor: Z Z^H = Re Z Re Z' + Im Z Im Z' for conjugate-closed shifts
+  const bool real = std::all_of(p.begin(), p.end(), [](C q) { return q.imag() == 0; });
+  MatrixX<T> R(n, real ? k : 2 * k);
+  if (real)
+    R = Z.leftCols(k).real();
+  else
+    R << Z.leftCols(k).real(), Z.leftCols(k).imag();
+
+  // Compress to the numerical rank
+  Eigen::HouseholderQR<MatrixX<T>> qr(R);
+  k = std::min(n, R.cols());
+  MatrixX<T> Rk = qr.matrixQR().topRows(k).template triangularView<Eigen::Upper>();
+  Eigen::BDCSVD<MatrixX<T>> svd(Rk, Eigen::ComputeThinU);
+  const auto &s = svd.singularValues();
+  Eigen::Index r = 0;
+  while (r < s.size() && s(r) > s(0) * T(k) * std::numeric_limits<T>::epsilon())
+    r++;
+  MatrixX<T> Q = qr.householderQ() * MatrixX<T>::Identity(n, k);
+  return Q * (svd.matrixU().leftCols(r) * s.head(r).asDiagonal());
+}
+
+/**
+ * Square-root balanced truncation from factors of the Gramians P = Zp Zp' and Q = Zq Zq'
+ *
+ * @return reduction<T, Nr, Nu, Ny>
+ */
+template<size_t Nr, size_t Nu, size_t Ny, typename T, typename MA>
+reduction<T, Nr, Nu, Ny> truncate(const MA &A, const MatrixX<T> &B, const MatrixX<T> &C, const MatrixX<T> &D,
+                                  const MatrixX<T> &Zp, const MatrixX<T> &Zq) {
+  using P = ss<T, Nr, Nu, Ny>;
+  MatrixX<T> M = Zq.transpose() * Zp;
+  Eigen::BDCSVD<MatrixX<T>> svd(M, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  const auto &s = svd.singularValues();
+  if (s.size() < Eigen::Index(Nr) || !(s(Nr - 1) > 0))
+    throw std::domain_error("truncate: fewer controllable and observable states than the reduced order");
+
+  VectorX<T> is = s.head(Nr).cwiseSqrt().cwiseInverse();
+  MatrixX<T> V = Zp * (svd.matrixV().leftCols(Nr) * is.asDiagonal());
+  MatrixX<T> W = Zq * (svd.matrixU().leftCols(Nr) * is.asDiagonal());
+
+  typename P::TA Ar = W.transpose() * MatrixX<T>(A * V);
+  typename P::TB Br = W.transpose() * B;
+  typename P::TC Cr = C * V;
+  typename P::TD Dr = D;
+
+  std::vector<T> hsv(s.data(), s.data() + s.size());
+  T bound = 2 * s.tail(s.size() - Eigen::Index(Nr)).sum();
+  return {P(Ar, Br, Cr, Dr), bound, hsv};
+}
+
+}
+
+/**
+ * Balanced truncation of a dense model
+ *
+ * Gramians from the squared Smith iteration, balanced by the square-root
+ * method. Suited to models of up to about a thousand states.
+ *
+ * @tparam Nr reduced order
+ * @param A, B, C, D state-space matrices of a stable model
+ * @return reduction<T, Nr, Nu, Ny>
+ */
+template<size_t Nr, size_t Nu = 1, size_t Ny = 1, typename T>
+reduction<T, Nr, Nu, Ny> truncate(const reduce::MatrixX<T> &A, const reduce::MatrixX<T> &B,
+                                  const reduce::MatrixX<T> &C, const reduce::MatrixX<T> &D) {
+  auto Zp = reduce::factor<T>(reduce::stein<T>(A, B * B.transpose()));
+  auto Zq = reduce::factor<T>(reduce::stein<T>(A.transpose(), C.transpose() * C));
+  return reduce::truncate<Nr, Nu, Ny>(A, B, C, D, Zp, Zq);
+}
+
+/**
+ * Balanced truncation of a state-space
+ *
+ * @tparam Nr reduced order
+ * @param P stable state-space
+ * @return reduction<T, Nr, Nu, Ny>
+ */
+template<size_t Nr, typename T, size_t Nx, size_t Nu, size_t Ny>
+reduction<T, Nr, Nu, Ny> truncate(const ss<T, Nx, Nu, Ny> &P) {
+  static_assert(Nr <= Nx, "Reduced order exceeds the order");
+  return truncate<Nr, Nu, Ny, T>(P.getA(), P.getB(), P.getC(), P.getD());
+}
+
+/**
+ * Balanced truncation of a large model with a sparse state matrix
+ *
+ * Low-rank factors of the Gramians from ADI, balanced by the square-root
+ * method; cost grows with the number of states times the rank of the factors.
+ * The Hankel singular values, and so the bound, cover the directions the
+ * factors resolve to tol.
+ *
+ * @tparam Nr reduced order
+ * @param A sparse state matrix of a stable model
+ * @param B, C, D dense input, output and feed-through matrices
+ * @param tol relative accuracy of the Gramian factors
+ * @return reduction<T, Nr, Nu, Ny>
+ */
+template<size_t Nr, size_t Nu = 1, size_t Ny = 1, typename T>
+reduction<T, Nr, Nu, Ny> truncate(const reduce::SparseX<T> &A, const reduce::MatrixX<T> &B,
+                                  const reduce::MatrixX<T> &C, const reduce::MatrixX<T> &D, T tol = T(1e-10)) {
+  auto p = reduce::shifts(A);
+  reduce::SparseX<T> At = A.transpose();
+  auto Zp = reduce::stein<T>(A, B, p, tol);
+  auto Zq = reduce::stein<T>(At, reduce::MatrixX<T>(C.transpose()), p, tol);
+  return reduce::truncate<Nr, Nu, Ny>(A, B, C, D, Zp, Zq);
+}
+
+}
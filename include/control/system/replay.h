@@ -0,0 +1,235 @@
+/*
+ * Replay of recorded signals through candidate configurations
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "control/system/mapped.h"
+#include "control/system/type.h"
+
+namespace control::system {
+
+/**
+ * Columnar sample file
+ *
+ * A 64-byte header followed by the columns one after another, each starting on
+ * a 64-byte boundary, so a column is a contiguous array of samples that block
+ * processing reads in place:
+ *
+ *    bytes 0-7     magic "CTRLCOL1"
+ *    bytes 8-11    element type: sizeof(T), plus 0x100 for floating point
+ *    bytes 16-23   number of columns
+ *    bytes 24-31   number of rows
+ *
+ * Integers are stored in native byte order. Opening a file with the wrong
+ * magic, element type or size throws std::runtime_error.
+ *
+ * @tparam T sample type
+ */
+template<typename T>
+class ColumnFile {
+  static_assert(std::is_arithmetic_v<T>, "Columns hold arithmetic samples");
+ public:
+  static constexpr size_t header = 64;
+
+  /**
+   * Map an existing file read-only
+   *
+   * @param path
+   * @return ColumnFile
+   */
+  static ColumnFile open(const std::string &path) {
+    ColumnFile f{MappedFile(path)};
+    auto p = static_cast<const char *>(f.file.data());
+    if (f.file.size() < header || std::memcmp(p, magic, 8) != 0)
+      throw std::runtime_error(path + ": not a column file");
+
+    uint32_t t;
+    std::memcpy(&t, p + 8, 4);
+    std::memcpy(&f.cols, p + 16, 8);
+    std::memcpy(&f.n, p + 24, 8);
+    if (t != type())
+      throw std::runtime_error(path + ": element type mismatch");
+    // Sizes come from the file, so bound them by division rather than multiply
+    if (f.n > (SIZE_MAX - 63) / sizeof(T) || f.cols > (f.file.size() - header) / std::max<size_t>(f.stride(), 1))
+      throw std::runtime_error(path + ": truncated");
+    return f;
+  }
+
+  /**
+   * Create a file of zero samples and map it writable
+   *
+   * @param path
+   * @param cols number of columns
+   * @param rows number of rows
+   * @return ColumnFile
+   */
+  static ColumnFile create(const std::string &path, size_t cols, size_t rows) {
+    ColumnFile f{MappedFile(path, header + cols * stride(rows))};
+    f.cols = cols;
+    f.n = rows;
+
+    auto p = static_cast<char *>(f.file.data());
+    uint32_t t = type();
+    uint64_t c = cols, r = rows;
+    std::memcpy(p, magic, 8);
+    std::memcpy(p + 8, &t, 4);
+    std::memcpy(p + 16, &c, 8);
+    std::memcpy(p + 24, &r, 8);
+    return f;
+  }
+
+  /**
+   * @param c column index
+   * @return const T* rows() samples
+   */
+  const T *column(size_t c) const {
+    return reinterpret_cast<const T *>(static_cast<const char *>(file.data()) + header + c * stride());
+  }
+
+  /**
+   * @param c column index
+   * @return T* rows() samples, writable only for a created file
+   */
+  T *column(size_t c) {
+    return reinterpret_cast<T *>(static_cast<char *>(file.data()) + header + c * stride());
+  }
+
+  size_t columns() const {
+    return cols;
+  }
+
+  size_t rows() const {
+    return n;
+  }
+
+  bool writable() const {
+    return file.writable();
+  }
+
+  /**
+   * @return MappedFile& the underlying mapping, e.g. to sync() it
+   */
+  MappedFile &mapping() {
+    return file;
+  }
+
+ protected:
+  static constexpr char magic[9] = "CTRLCOL1";
+
+  MappedFile file;
+  uint64_t cols = 0;
+  uint64_t n = 0;
+
+  explicit ColumnFile(MappedFile f) : file(std::move(f)) {}
+
+  static constexpr uint32_t type() {
+    return uint32_t(sizeof(T)) | (std::is_floating_point_v<T> ? 0x100u : 0u);
+  }
+
+  static size_t stride(size_t rows) {
+    return (rows * sizeof(T) + 63) / 64 * 64;
+  }
+
+  size_t stride() const {
+    return stride(n);
+  }
+};
+
+namespace detail {
+
+/**
+ * Divide count items in contiguous ranges over threads and run work(first, last)
+ * for each range on its own thread
+ */
+template<typename W>
+void divide(size_t count, unsigned threads, W &work) {
+  if (count == 0)
+    return;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t per = (count + threads - 1) / threads;
+
+  std::vector<std::thread> pool;
+  for (size_t k = 0; k < count; k += per)
+    pool.emplace_back(work, k, std::min(count, k + per));
+  for (auto &t : pool)
+    t.join();
+}
+
+}
+
+/**
+ * Replay an input through candidate components in parallel
+ *
+ * The candidates are divided over the threads. Each thread walks the input
+ * once, in blocks that stay in its cache while all of its candidates process
+ * them, and hands every produced block to the sink as sink(k, y, m) for
+ * candidate k, from the thread that owns k. The input is read in place, so it
+ * can be a column of a mapped file. Components are anything process() accepts.
+ *
+ * @param x n input samples
+ * @param n number of samples
+ * @param cs candidates, modified in place
+ * @param sink called with the outputs of each candidate, block by block
+ * @param block samples per block
+ * @param threads number of threads, 0 for the hardware concurrency
+ */
+template<typename T, typename C, typename F>
+void replay(const T *x, size_t n, std::vector<C> &cs, F &&sink, size_t block = 4096, unsigned threads = 0) {
+  auto work = [&](size_t first, size_t last) {
+    std::vector<T> y(block);
+    for (size_t i = 0; i < n; i += block) {
+      size_t b = std::min(block, n - i);
+      for (size_t k = first; k < last; k++)
+        sink(k, y.data(), process(cs[k], x + i, b, y.data()));
+    }
+  };
+
+  detail::divide(cs.size(), threads, work);
+}
+
+/**
+ * Replay an input through candidate components into the columns of a file
+ *
+ * Like replay() with a sink, but the outputs of candidate k are processed
+ * directly into column k of out, without an intermediate buffer.
+ *
+ * @param x n input samples
+ * @param n number of samples
+ * @param cs candidates
+ * @param out writable file with a column per candidate and n rows
+ * @param block samples per block
+ * @param threads number of threads, 0 for the hardware concurrency
+ * @return std::vector<size_t> number of outputs per candidate, n unless decimating
+ */
+template<typename T, typename C>
+std::vector<size_t> replay(const T *x, size_t n, std::vector<C> &cs, ColumnFile<T> &out,
+                           size_t block = 4096, unsigned threads = 0) {
+  if (!out.writable() || out.columns() < cs.size() || out.rows() < n)
+    throw std::invalid_argument("replay: output file is read-only or too small");
+
+  std::vector<size_t> produced(cs.size(), 0);
+  auto work = [&](size_t first, size_t last) {
+    for (size_t i = 0; i < n; i += block) {
+      size_t b = std::min(block, n - i);
+      for (size_t k = first; k < last; k++)
+        produced[k] += process(cs[k], x + i, b, out.column(k) + produced[k]);
+    }
+  };
+
+  detail::divide(cs.size(), threads, work);
+
+  return produced;
+}
+
+}
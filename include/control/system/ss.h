@@ -6,6 +6,8 @@
 
 #include <Eigen/Dense>
 
+#include "control/system/denormal.h"
+
 namespace control::system {
 
 /**
@@ -73,6 +75,35 @@ class ss {
     y = C * x + D * u;
     return y;
   }
+
+  /**
+   * Snap decaying states to zero before they become subnormal
+   *
+   * Call at least once per block of samples while the input may fall silent.
+   */
+  void snap() {
+    x = x.unaryExpr([](T v) { return system::snap(v); });
+  }
+
+  /**
+   * @return const TA& state-transfer matrix
+   */
+  const TA& getA() const { return A; }
+
+  /**
+   * @return const TB& input matrix
+   */
+  const TB& getB() const { return B; }
+
+  /**
+   * @return const TC& output matrix
+   */
+  const TC& getC() const { return C; }
+
+  /**
+   * @return const TD& feed-through matrix
+   */
+  const TD& getD() const { return D; }
 };
 
 }
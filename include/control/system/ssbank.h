@@ -0,0 +1,180 @@
+/*
+ * Banks of state-spaces
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include <Eigen/Dense>
+
+#include "control/system/denormal.h"
+#include "control/system/ss.h"
+
+namespace control::system {
+
+/**
+ * Bank of K streams through the same state-space
+ *
+ * The states of all streams form one Nx x K row-major matrix, a stream per
+ * column, so every tick is the product [A B] [X; U] over all streams rather
+ * than K matrix-vector products. Inputs and outputs are frame-interleaved:
+ * frame t holds the Nu x K inputs row by row, u[(t Nu + i) K + k].
+ *
+ * Each tick runs in tiles of one cache line of streams: a tile of states is
+ * loaded once into registers and every coefficient of A, B, C and D is
+ * broadcast over it, so Nx loads feed Nx^2 multiply-adds and the bank stays
+ * compute-bound even when the states of all streams only fit in L3. Memory is
+ * allocated on construction only.
+ *
+ *    ssbank<float, 4> bank(P, 256);
+ *    bank.process(u, n, y);
+ *
+ * @tparam T arithmetic type
+ * @tparam Nx number of states
+ * @tparam Nu number of inputs
+ * @tparam Ny number of outputs
+ */
+template<typename T, size_t Nx, size_t Nu = 1, size_t Ny = 1>
+class ssbank {
+ public:
+  using plant = ss<T, Nx, Nu, Ny>;
+  using TX = Eigen::Matrix<T, Nx, Eigen::Dynamic, Eigen::RowMajor>;
+  using TU = Eigen::Matrix<T, Nu, Eigen::Dynamic, Eigen::RowMajor>;
+  using TY = Eigen::Matrix<T, Ny, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /**
+   * Streams per tile: one cache line of each state row
+   */
+  static constexpr Eigen::Index tile = std::max<Eigen::Index>(1, 64 / sizeof(T));
+
+  /**
+   * Construct a bank with every stream in the state of P
+   *
+   * @param P state-space
+   * @param K_ number of streams
+   */
+  ssbank(const plant &P, size_t K_)
+      : x{P.x.replicate(1, Eigen::Index(K_))}, y{P.y.replicate(1, Eigen::Index(K_))},
+        A{P.getA()}, B{P.getB()}, C{P.getC()}, D{P.getD()}, K(Eigen::Index(K_)) {}
+
+  /**
+   * @var TX states, stream k in column k
+   */
+  TX x;
+
+  /**
+   * @var TY outputs of the last frame
+   */
+  TY y;
+
+  /**
+   * Step all streams one frame
+   *
+   * @param u Nu x K inputs
+   * @return const TY& Ny x K outputs
+   */
+  const TY &step(const TU &u) {
+    for (Eigen::Index k = 0; k < K; k += tile)
+      tick(u.data(), y.data(), k);
+    return y;
+  }
+
+  /**
+   * Process frames of all streams
+   *
+   * @param u n frames of Nu x K inputs
+   * @param n number of frames
+   * @param out n frames of Ny x K outputs, may alias u if Nu == Ny
+   */
+  void process(const T *u, size_t n, T *out) {
+    if (n == 0)
+      return;
+    const Eigen::Index N = Eigen::Index(n), su = Nu * K, sy = Ny * K;
+    for (Eigen::Index t = 0; t < N; t++)
+      for (Eigen::Index k = 0; k < K; k += tile)
+        tick(u + t * su, out + t * sy, k);
+    std::copy_n(out + (N - 1) * sy, sy, y.data());
+  }
+
+  /**
+   * Reset the state of all streams
+   */
+  void reset() {
+    x.setZero();
+    y.setZero();
+  }
+
+  /**
+   * Snap decaying states of all streams to zero
+   *
+   * @see ss::snap()
+   */
+  void snap() {
+    x = x.unaryExpr([](T v) { return system::snap(v); });
+  }
+
+  size_t streams() const {
+    return size_t(K);
+  }
+
+ protected:
+  using XT = Eigen::Array<T, Nx, tile, Eigen::RowMajor>;
+  using UT = Eigen::Array<T, Nu, tile, Eigen::RowMajor>;
+  using YT = Eigen::Array<T, Ny, tile, Eigen::RowMajor>;
+  using R = Eigen::Array<T, 1, tile>;
+  using S = Eigen::OuterStride<>;
+
+  const typename plant::TA A;
+  const typename plant::TB B;
+  const typename plant::TC C;
+  const typename plant::TD D;
+  Eigen::Index K;
+
+  // One frame of the tile of streams from k, a partial tile at the end
+  void tick(const T *u, T *out, Eigen::Index k) {
+    const Eigen::Index m = std::min(tile, K - k);
+    XT xt;
+    UT ut;
+    if (m == tile) {
+      xt = Eigen::Map<const XT, 0, S>(x.data() + k, S(K));
+      ut = Eigen::Map<const UT, 0, S>(u + k, S(K));
+    } else {
+      xt.setZero();
+      ut.setZero();
+      xt.leftCols(m) = x.middleCols(k, m).array();
+      ut.leftCols(m) = Eigen::Map<const TU, 0, S>(u + k, Nu, m, S(K)).array();
+    }
+
+    // Accumulate each row in registers
+    XT xn;
+    for (size_t i = 0; i < Nx; i++) {
+      R r = B(i, 0) * ut.row(0);
+      for (size_t j = 1; j < Nu; j++)
+        r += B(i, j) * ut.row(j);
+      for (size_t j = 0; j < Nx; j++)
+        r += A(i, j) * xt.row(j);
+      xn.row(i) = r;
+    }
+    YT yt;
+    for (size_t i = 0; i < Ny; i++) {
+      R r = D(i, 0) * ut.row(0);
+      for (size_t j = 1; j < Nu; j++)
+        r += D(i, j) * ut.row(j);
+      for (size_t j = 0; j < Nx; j++)
+        r += C(i, j) * xn.row(j);
+      yt.row(i) = r;
+    }
+
+    if (m == tile) {
+      Eigen::Map<XT, 0, S>(x.data() + k, S(K)) = xn;
+      Eigen::Map<YT, 0, S>(out + k, S(K)) = yt;
+    } else {
+      x.middleCols(k, m) = xn.leftCols(m).matrix();
+      Eigen::Map<TY, 0, S>(out + k, Ny, m, S(K)) = yt.leftCols(m).matrix();
+    }
+  }
+};
+
+}
@@ -0,0 +1,229 @@
+/*
+ * Stability margins of populations of filters and state-spaces
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "control/filter/bank.h"
+#include "control/filter/biquad.h"
+#include "control/system/ss.h"
+
+namespace control::system {
+
+namespace detail {
+
+// Run f(begin, end) on contiguous ranges of [0, n) on a pool of threads
+template<typename F>
+void ranges(size_t n, unsigned threads, F f) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t parts = std::clamp<size_t>(threads, 1, std::max<size_t>(n / 1024, 1));
+  const size_t per = (n + parts - 1) / parts;
+  std::vector<std::thread> pool;
+  for (size_t p = 1; p < parts; p++)
+    pool.emplace_back(f, p * per, std::min(n, (p + 1) * per));
+  f(size_t(0), std::min(n, per));
+  for (auto &t : pool)
+    t.join();
+}
+
+}
+
+/**
+ * Pole radius of a second-order section
+ *
+ * The largest magnitude of the roots of z^2 + a1 z + a2, in closed form:
+ * sqrt(a2) for a complex pair, (|a1| + sqrt(a1^2 - 4 a2)) / 2 for real roots.
+ *
+ * @param s section
+ * @return T pole radius
+ */
+template<typename T>
+T radius(const filter::sos<T> &s) {
+  const T d = s.a1 * s.a1 - 4 * s.a2;
+  return d < 0 ? std::sqrt(s.a2) : (std::abs(s.a1) + std::sqrt(d)) / 2;
+}
+
+/**
+ * Stability margin of a second-order section: 1 minus its pole radius
+ *
+ * Positive when stable, zero when marginally stable, as an integrator.
+ *
+ * @param s section
+ * @return T margin
+ */
+template<typename T>
+T margin(const filter::sos<T> &s) {
+  return 1 - radius(s);
+}
+
+/**
+ * Whether both poles of a second-order section lie strictly inside the unit circle
+ *
+ * The Jury criterion with strict inequalities, |a2| < 1 and |a1| < 1 + a2.
+ * Unlike Biquad::stable(), which accepts the closed disc, marginally stable
+ * sections such as integrators are rejected, as by the state-space overloads.
+ *
+ * @param s section
+ * @return bool
+ */
+template<typename T>
+bool asymptotically_stable(const filter::sos<T> &s) {
+  using std::abs;
+  return abs(s.a2) < 1 && abs(s.a1) < 1 + s.a2;
+}
+
+/**
+ * Stability margins of many second-order sections, from arrays of their denominators
+ *
+ * One square root per section, on ranges split over a pool of threads.
+ *
+ * @param a1 n coefficients a1
+ * @param a2 n coefficients a2
+ * @param n number of sections
+ * @param m n margins, 1 - pole radius
+ * @param threads number of threads, 0 for the hardware concurrency
+ */
+template<typename T>
+void margins(const T *a1, const T *a2, size_t n, T *m, unsigned threads = 0) {
+  detail::ranges(n, threads, [=](size_t b, size_t e) {
+    // One square root per section: of a2 for a complex pair, of the
+    // discriminant for real roots
+    for (size_t i = b; i < e; i++) {
+      const T d = a1[i] * a1[i] - 4 * a2[i];
+      const T r = std::sqrt(d < 0 ? a2[i] : d);
+      m[i] = 1 - (d < 0 ? r : (std::abs(a1[i]) + r) / 2);
+    }
+  });
+}
+
+/**
+ * Stability margins of many second-order sections
+ *
+ * @param s sections, for instance the coefficients() of biquads or PIDs
+ * @param threads number of threads, 0 for the hardware concurrency
+ * @return std::vector<T> margins, 1 - pole radius
+ */
+template<typename T>
+std::vector<T> margins(const std::vector<filter::sos<T>> &s, unsigned threads = 0) {
+  std::vector<T> a1(s.size()), a2(s.size()), m(s.size());
+  for (size_t i = 0; i < s.size(); i++) {
+    a1[i] = s[i].a1;
+    a2[i] = s[i].a2;
+  }
+  margins(a1.data(), a2.data(), s.size(), m.data(), threads);
+  return m;
+}
+
+/**
+ * Stability margins of the channels of a bank, straight from its coefficients
+ *
+ * @param b bank of K cascades
+ * @param threads number of threads, 0 for the hardware concurrency
+ * @return std::vector<T> K margins, the smallest over the sections of each channel
+ */
+template<typename T>
+std::vector<T> margins(const filter::BiquadBank<T> &b, unsigned threads = 0) {
+  const size_t K = b.channels(), N = b.sections();
+  std::vector<T> all(K * N), m(K, T(1));
+  margins(b.coefficients() + 3 * N * K, b.coefficients() + 4 * N * K, K * N, all.data(), threads);
+  for (size_t n = 0; n < N; n++)
+    for (size_t k = 0; k < K; k++)
+      m[k] = std::min(m[k], all[n * K + k]);
+  return m;
+}
+
+/**
+ * Spectral radius: the largest magnitude of the eigenvalues of a square matrix
+ *
+ * @param A matrix
+ * @return real scalar
+ */
+template<typename D>
+typename D::RealScalar radius(const Eigen::MatrixBase<D> &A) {
+  using M = Eigen::Matrix<typename D::Scalar, D::RowsAtCompileTime, D::ColsAtCompileTime>;
+  if (A.rows() == 0)
+    return 0;
+  return Eigen::EigenSolver<M>(A, false).eigenvalues().cwiseAbs().maxCoeff();
+}
+
+/**
+ * Whether all eigenvalues of a square matrix lie strictly inside the unit circle
+ *
+ * Exits early on bounds over the powers A^(2^j) for j up to 4, by repeated
+ * squaring: an induced norm below one proves stability, since the spectral
+ * radius is at most every induced norm, and an eigenvalue mean |trace / n| of
+ * at least one disproves it. Only matrices with a radius close to one have
+ * their eigenvalues computed.
+ *
+ * Marginally stable systems, with poles on the unit circle, are rejected;
+ * Biquad::stable() accepts them. To tell marginal cases apart, compare
+ * margins() against a tolerance instead.
+ *
+ * @param A matrix
+ * @return bool whether the discrete system with state matrix A is asymptotically stable
+ */
+template<typename D>
+bool asymptotically_stable(const Eigen::MatrixBase<D> &A) {
+  using M = Eigen::Matrix<typename D::Scalar, D::RowsAtCompileTime, D::ColsAtCompileTime>;
+  using R = typename D::RealScalar;
+  const R n = R(A.rows());
+  M P = A;
+  for (int j = 0; j <= 4; j++) {
+    if (P.cwiseAbs().rowwise().sum().maxCoeff() < 1 || P.cwiseAbs().colwise().sum().maxCoeff() < 1)
+      return true;
+    if (std::abs(P.trace()) >= n)
+      return false;
+    if (j < 4)
+      P = P * P;
+  }
+  return radius(A) < 1;
+}
+
+/**
+ * Stability margin of a state-space: 1 minus the spectral radius of A
+ *
+ * @param P state-space
+ * @return T margin
+ */
+template<typename T, size_t Nx, size_t Nu, size_t Ny>
+T margin(const ss<T, Nx, Nu, Ny> &P) {
+  return 1 - radius(P.getA());
+}
+
+/**
+ * @param P state-space
+ * @return bool whether all poles lie strictly inside the unit circle
+ * @see asymptotically_stable(const Eigen::MatrixBase<D> &)
+ */
+template<typename T, size_t Nx, size_t Nu, size_t Ny>
+bool asymptotically_stable(const ss<T, Nx, Nu, Ny> &P) {
+  return asymptotically_stable(P.getA());
+}
+
+/**
+ * Stability margins of many state-spaces, on a pool of threads
+ *
+ * @param P state-spaces
+ * @param threads number of threads, 0 for the hardware concurrency
+ * @return std::vector<T> margins, 1 - spectral radius
+ */
+template<typename T, size_t Nx, size_t Nu, size_t Ny>
+std::vector<T> margins(const std::vector<ss<T, Nx, Nu, Ny>> &P, unsigned threads = 0) {
+  std::vector<T> m(P.size());
+  detail::ranges(P.size(), threads, [&](size_t b, size_t e) {
+    for (size_t i = b; i < e; i++)
+      m[i] = margin(P[i]);
+  });
+  return m;
+}
+
+}
@@ -0,0 +1,223 @@
+/*
+ * Streaming between threads
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+#include "control/system/type.h"
+
+namespace control::system {
+
+/**
+ * Wait-free single-producer single-consumer ring buffer
+ *
+ * One thread pushes, one other thread pops; neither ever waits on the other.
+ * The read and write positions sit on separate cache lines and each side keeps
+ * a cached copy of the other side's position, so the shared lines are only
+ * touched when the cached copy runs out. Elements can be single samples or
+ * whole frames, e.g. std::array<float, 64>.
+ *
+ * @tparam T element type
+ * @tparam N capacity, a power of two
+ */
+template<typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "Ring capacity must be a power of two");
+  static constexpr size_t mask = N - 1;
+  static constexpr size_t line = 64;
+ public:
+  /**
+   * Push one element (producer)
+   *
+   * @param x element
+   * @return bool false when full
+   */
+  bool push(const T &x) {
+    return push(&x, 1) == 1;
+  }
+
+  /**
+   * Push up to n elements (producer)
+   *
+   * @param x elements
+   * @param n number of elements
+   * @return size_t number of elements pushed
+   */
+  size_t push(const T *x, size_t n) {
+    const size_t w = head.load(std::memory_order_relaxed);
+    if (N - (w - tail_cache) < n)
+      tail_cache = tail.load(std::memory_order_acquire);
+    const size_t m = std::min(n, N - (w - tail_cache));
+    for (size_t i = 0; i < m; i++)
+      buf[(w + i) & mask] = x[i];
+    head.store(w + m, std::memory_order_release);
+    return m;
+  }
+
+  /**
+   * Pop one element (consumer)
+   *
+   * @param x element
+   * @return bool false when empty
+   */
+  bool pop(T &x) {
+    return pop(&x, 1) == 1;
+  }
+
+  /**
+   * Pop up to n elements (consumer)
+   *
+   * @param x room for n elements
+   * @param n number of elements
+   * @return size_t number of elements popped
+   */
+  size_t pop(T *x, size_t n) {
+    const size_t r = tail.load(std::memory_order_relaxed);
+    if (head_cache - r < n)
+      head_cache = head.load(std::memory_order_acquire);
+    const size_t m = std::min(n, head_cache - r);
+    for (size_t i = 0; i < m; i++)
+      x[i] = buf[(r + i) & mask];
+    tail.store(r + m, std::memory_order_release);
+    return m;
+  }
+
+  /**
+   * Number of elements, exact only when called from either side while the
+   * other side is idle
+   *
+   * @return size_t
+   */
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @return size_t capacity N
+   */
+  static constexpr size_t capacity() {
+    return N;
+  }
+
+ protected:
+  // Producer
+  alignas(line) std::atomic<size_t> head{0};
+  size_t tail_cache = 0;
+
+  // Consumer
+  alignas(line) std::atomic<size_t> tail{0};
+  size_t head_cache = 0;
+
+  alignas(line) std::array<T, N> buf;
+};
+
+/**
+ * What a writer does when the ring is full
+ */
+enum class overflow {
+  // Wait for room, propagating back-pressure to the writer
+  block,
+  // Drop what does not fit; the writer never waits
+  drop
+};
+
+/**
+ * Write n elements to a ring according to an overflow policy
+ *
+ * @tparam O policy
+ * @param r ring
+ * @param x elements
+ * @param n number of elements
+ * @return size_t number of elements written, n unless dropped
+ */
+template<overflow O, typename T, size_t N>
+size_t write(SpscRing<T, N> &r, const T *x, size_t n) {
+  size_t m = r.push(x, n);
+  if constexpr (O == overflow::block)
+    while (m < n) {
+      std::this_thread::yield();
+      m += r.push(x + m, n - m);
+    }
+  return m;
+}
+
+/**
+ * Processing stage between two rings
+ *
+ * Moves samples from an input ring through a component into an output ring in
+ * batches of B. The component is anything with T step(T), or with a block
+ * process(const T *x, size_t n, T *y) that produces n outputs, or at most n
+ * and returns the count (decimators). The stage does not own its rings, so
+ * stages chain through a shared ring and several stages can be run by the same
+ * thread. run() never blocks on input; with overflow::block it waits for room
+ * downstream, with overflow::drop it drops and counts instead.
+ *
+ * @tparam T arithmetic type
+ * @tparam C component
+ * @tparam NI input ring capacity
+ * @tparam NO output ring capacity
+ * @tparam O overflow policy
+ * @tparam B batch size
+ */
+template<typename T, typename C, size_t NI, size_t NO, overflow O = overflow::drop, size_t B = 64>
+class Stage {
+ public:
+  /**
+   * Connect a component between two rings
+   *
+   * @param c component
+   * @param in input ring
+   * @param out output ring
+   */
+  Stage(C c, SpscRing<T, NI> &in, SpscRing<T, NO> &out) : c(std::move(c)), in(in), out(out) {}
+
+  /**
+   * Process what is available, at most max samples
+   *
+   * @param max bound on the number of input samples
+   * @return size_t number of input samples processed
+   */
+  size_t run(size_t max = NI) {
+    size_t total = 0;
+    while (total < max) {
+      size_t n = in.pop(x.data(), std::min(B, max - total));
+      if (n == 0)
+        break;
+      size_t m = process(c, x.data(), n, y.data());
+      dropped += m - write<O>(out, y.data(), m);
+      total += n;
+    }
+    return total;
+  }
+
+  /**
+   * @return C& the wrapped component
+   */
+  C &component() {
+    return c;
+  }
+
+  /**
+   * @return size_t number of outputs dropped since construction
+   */
+  size_t drops() const {
+    return dropped;
+  }
+
+ protected:
+  C c;
+  SpscRing<T, NI> &in;
+  SpscRing<T, NO> &out;
+
+  std::array<T, B> x, y;
+  size_t dropped = 0;
+};
+
+}
@@ -0,0 +1,518 @@
+/*
+ * Discrete transfer functions
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "control/filter/biquad.h"
+#include "control/filter/design.h"
+#include "control/system/ss.h"
+
+namespace control::system {
+
+namespace detail {
+
+template<typename T>
+using poly = std::vector<T>;
+
+template<typename T>
+using MatrixX = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+template<typename T>
+using VectorX = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+/**
+ * Product of polynomials, a vectorized multiply-add per coefficient of a
+ */
+template<typename T>
+poly<T> polymul(const poly<T> &a, const poly<T> &b) {
+  if (a.empty() || b.empty())
+    return {};
+  poly<T> c(a.size() + b.size() - 1, T(0));
+  Eigen::Map<const VectorX<T>> bv(b.data(), Eigen::Index(b.size()));
+  Eigen::Map<VectorX<T>> cv(c.data(), Eigen::Index(c.size()));
+  for (size_t i = 0; i < a.size(); i++)
+    cv.segment(Eigen::Index(i), bv.size()) += a[i] * bv;
+  return c;
+}
+
+/**
+ * Sum of polynomials in descending powers, aligned at the constant term
+ */
+template<typename T>
+poly<T> polyadd(const poly<T> &a, const poly<T> &b, T sign = 1) {
+  poly<T> c(std::max(a.size(), b.size()), T(0));
+  for (size_t i = 0; i < a.size(); i++)
+    c[c.size() - a.size() + i] += a[i];
+  for (size_t i = 0; i < b.size(); i++)
+    c[c.size() - b.size() + i] += sign * b[i];
+  return c;
+}
+
+/**
+ * Drop leading coefficients that vanish relative to tol times the largest one
+ */
+template<typename T>
+void trim(poly<T> &p, T tol = 0) {
+  T m = 0;
+  for (auto c : p)
+    m = std::max(m, std::abs(c));
+  size_t i = 0;
+  while (i + 1 < p.size() && std::abs(p[i]) <= tol * m)
+    i++;
+  p.erase(p.begin(), p.begin() + i);
+}
+
+/**
+ * Balance a matrix by a diagonal similarity of powers of two
+ *
+ * Scales rows and columns until their off-diagonal norms are comparable, which
+ * bounds the error of the eigenvalues (Parlett and Reinsch). A becomes
+ * D^-1 A D without rounding.
+ *
+ * @return VectorX<T> diagonal of D
+ */
+template<typename T>
+VectorX<T> balance(MatrixX<T> &A) {
+  const T radix = 2, sqrdx = radix * radix;
+  const Eigen::Index n = A.rows();
+  VectorX<T> d = VectorX<T>::Ones(n);
+  bool done = false;
+  while (!done) {
+    done = true;
+    for (Eigen::Index i = 0; i < n; i++) {
+      T c = A.col(i).cwiseAbs().sum() - std::abs(A(i, i));
+      T r = A.row(i).cwiseAbs().sum() - std::abs(A(i, i));
+      if (c == 0 || r == 0)
+        continue;
+      T g = r / radix, f = 1, s = c + r;
+      while (c < g) {
+        f *= radix;
+        c *= sqrdx;
+      }
+      g = r * radix;
+      while (c > g) {
+        f /= radix;
+        c /= sqrdx;
+      }
+      if ((c + r) / f < T(0.95) * s) {
+        done = false;
+        d(i) *= f;
+        A.row(i) /= f;
+        A.col(i) *= f;
+      }
+    }
+  }
+  return d;
+}
+
+}
+
+/**
+ * Roots of a polynomial in descending powers
+ *
+ * Eigenvalues of the balanced companion matrix, polished by Newton steps.
+ * Roots with negligible imaginary parts are returned as real.
+ *
+ * @param p coefficients
+ * @return std::vector<std::complex<T>>
+ */
+template<typename T>
+std::vector<std::complex<T>> roots(detail::poly<T> p) {
+  using C = std::complex<T>;
+  detail::trim(p);
+  std::vector<C> r;
+
+  // Roots at zero
+  while (p.size() > 1 && p.back() == T(0)) {
+    p.pop_back();
+    r.emplace_back(0);
+  }
+  const size_t n = p.size() - 1;
+  if (n == 0)
+    return r;
+
+  detail::MatrixX<T> A = detail::MatrixX<T>::Zero(n, n);
+  for (size_t j = 0; j < n; j++)
+    A(0, j) = -p[j + 1] / p[0];
+  for (size_t i = 1; i < n; i++)
+    A(i, i - 1) = 1;
+  detail::balance(A);
+  Eigen::EigenSolver<detail::MatrixX<T>> es(A, false);
+
+  auto eval = [&p](C z) {
+    C v = 0, dv = 0;
+    for (auto c : p) {
+      dv = dv * z + v;
+      v = v * z + c;
+    }
+    return std::make_pair(v, dv);
+  };
+
+  for (Eigen::Index i = 0; i < es.eigenvalues().size(); i++) {
+    C z = es.eigenvalues()(i);
+    for (int k = 0; k < 3; k++) {
+      auto [v, dv] = eval(z);
+      if (dv == C(0))
+        break;
+      C z1 = z - v / dv;
+      if (!(std::abs(eval(z1).first) < std::abs(v)))
+        break;
+      z = z1;
+    }
+    if (std::abs(z.imag()) <= 100 * std::numeric_limits<T>::epsilon() * std::abs(z))
+      z = z.real();
+    r.push_back(z);
+  }
+  return r;
+}
+
+/**
+ * Monic polynomial in descending powers from its roots
+ *
+ * @param r roots, complex ones in conjugate pairs
+ * @return std::vector<T>
+ */
+template<typename T>
+detail::poly<T> poly(const std::vector<std::complex<T>> &r) {
+  std::vector<std::complex<T>> c{1};
+  for (auto z : r) {
+    c.push_back(0);
+    for (size_t i = c.size() - 1; i > 0; i--)
+      c[i] -= z * c[i - 1];
+  }
+  detail::poly<T> p(c.size());
+  for (size_t i = 0; i < c.size(); i++)
+    p[i] = c[i].real();
+  return p;
+}
+
+/**
+ * Discrete SISO transfer function
+ *
+ *             b0 z^m + b1 z^(m-1) + ... + bm
+ *    H(z) = ----------------------------------
+ *             z^n + a1 z^(n-1) + ... + an
+ *
+ * Coefficients are in descending powers of z; the denominator is kept monic.
+ * Transfer functions combine in series (*), parallel (+, -) and feedback,
+ * and are executed as a cascade of biquads or a balanced state-space, never
+ * as a high-order direct form.
+ *
+ * @tparam T arithmetic type
+ */
+template<typename T>
+class tf {
+ public:
+  using poly = detail::poly<T>;
+  using complex = std::complex<T>;
+
+  /**
+   * Static gain
+   *
+   * @param k
+   */
+  tf(T k = 1) : n{k}, d{1} {}
+
+  /**
+   * @param num numerator, descending powers of z
+   * @param den denominator, descending powers of z
+   */
+  tf(poly num, poly den) : n(std::move(num)), d(std::move(den)) {
+    detail::trim(d);
+    if (d.empty() || d[0] == T(0))
+      throw std::invalid_argument("tf: zero denominator");
+    detail::trim(n);
+    if (n.empty())
+      n = {0};
+
+    // Cancel common roots at the origin, e.g. of first-order sections
+    while (n.size() > 1 && d.size() > 1 && n.back() == T(0) && d.back() == T(0)) {
+      n.pop_back();
+      d.pop_back();
+    }
+    for (auto &c : n)
+      c /= d[0];
+    for (size_t i = d.size(); i-- > 0;)
+      d[i] /= d[0];
+  }
+
+  /**
+   * Transfer function of a second-order section
+   *
+   * @param s
+   */
+  explicit tf(const filter::sos<T> &s) : tf(poly{s.b0, s.b1, s.b2}, poly{1, s.a1, s.a2}) {}
+
+  /**
+   * Transfer function of a SISO state-space as stepped by ss::step()
+   *
+   * step() returns y = C x+ + D u after the state update, so the model runs
+   * z C (zI - A)^-1 B + D. Uses det(zI - A + BC) - det(zI - A) = C adj(zI - A) B,
+   * with both characteristic polynomials from eigenvalues. Inverse of
+   * statespace().
+   *
+   * @param P
+   */
+  template<size_t Nx>
+  explicit tf(const ss<T, Nx, 1, 1> &P) {
+    const T D = P.getD()(0);
+    auto a = system::poly(eig(P.getA()));
+    auto c = system::poly(eig(P.getA() - P.getB() * P.getC()));
+    T m = 0;
+    for (auto v : a)
+      m = std::max(m, std::abs(v));
+    for (auto v : c)
+      m = std::max(m, std::abs(v));
+
+    poly b = detail::polyadd(c, a, T(-1));
+    b.push_back(0);
+    b = detail::polyadd(b, a, D);
+    T tol = T(16 * (Nx + 1)) * std::numeric_limits<T>::epsilon() * m;
+    size_t i = 0;
+    while (i + 1 < b.size() && std::abs(b[i]) <= tol)
+      i++;
+    n.assign(b.begin() + i, b.end());
+    d = a;
+
+    // The advance cancels poles at the origin
+    while (n.size() > 1 && d.size() > 1 && n.back() == T(0) && d.back() == T(0)) {
+      n.pop_back();
+      d.pop_back();
+    }
+  }
+
+  /**
+   * Delay of k samples, z^-k
+   *
+   * @param k
+   * @return tf
+   */
+  static tf delay(size_t k) {
+    poly den(k + 1, T(0));
+    den[0] = 1;
+    return tf({1}, den);
+  }
+
+  const poly &num() const {
+    return n;
+  }
+
+  const poly &den() const {
+    return d;
+  }
+
+  /**
+   * @return size_t degree of the denominator
+   */
+  size_t order() const {
+    return d.size() - 1;
+  }
+
+  /**
+   * @return bool whether the numerator degree does not exceed the order, i.e. causal
+   */
+  bool proper() const {
+    return n.size() <= d.size();
+  }
+
+  /**
+   * Evaluate at z
+   *
+   * @param z
+   * @return complex H(z)
+   */
+  complex operator()(complex z) const {
+    return horner(n, z) / horner(d, z);
+  }
+
+  /**
+   * @return T H(1)
+   */
+  T dcgain() const {
+    return (*this)(1).real();
+  }
+
+  std::vector<complex> zeros() const {
+    return roots(n);
+  }
+
+  std::vector<complex> poles() const {
+    return roots(d);
+  }
+
+  /**
+   * @return bool whether all poles lie strictly inside the unit circle
+   */
+  bool stable() const {
+    for (auto p : poles())
+      if (std::abs(p) >= 1)
+        return false;
+    return true;
+  }
+
+  friend tf operator*(const tf &a, const tf &b) {
+    return tf(detail::polymul(a.n, b.n), detail::polymul(a.d, b.d));
+  }
+
+  friend tf operator/(const tf &a, const tf &b) {
+    return tf(detail::polymul(a.n, b.d), detail::polymul(a.d, b.n));
+  }
+
+  friend tf operator+(const tf &a, const tf &b) {
+    return tf(detail::polyadd(detail::polymul(a.n, b.d), detail::polymul(b.n, a.d)), detail::polymul(a.d, b.d));
+  }
+
+  friend tf operator-(const tf &a, const tf &b) {
+    return tf(detail::polyadd(detail::polymul(a.n, b.d), detail::polymul(b.n, a.d), T(-1)), detail::polymul(a.d, b.d));
+  }
+
+  tf operator-() const {
+    tf r = *this;
+    for (auto &c : r.n)
+      c = -c;
+    return r;
+  }
+
+  /**
+   * Closed loop with H in the feedback path: G / (1 + G H) for negative feedback
+   *
+   * @param H feedback path
+   * @param sign -1 for negative, 1 for positive feedback
+   * @return tf
+   */
+  tf feedback(const tf &H = tf(1), int sign = -1) const {
+    auto num = detail::polymul(n, H.d);
+    auto den = detail::polyadd(detail::polymul(d, H.d), detail::polymul(n, H.n), T(-sign));
+    return tf(num, den);
+  }
+
+  /**
+   * Factor into second-order sections
+   *
+   * Poles and zeros from robust root finding are paired with the nearest ones,
+   * sections ordered by increasing pole radius, as in design::zpk2sos. Zeros at
+   * infinity become delays. A static gain yields one section.
+   *
+   * @return std::vector<filter::sos<T>> (order + 1) / 2 sections
+   */
+  std::vector<filter::sos<T>> sections() const {
+    if (!proper())
+      throw std::domain_error("tf: improper transfer function has no sections");
+    if (order() == 0)
+      return {filter::sos<T>{n[0], 0, 0, 0, 0}};
+
+    auto z = zeros(), p = poles();
+    std::vector<filter::sos<T>> s((p.size() + 1) / 2);
+    std::unique_ptr<bool[]> zused(new bool[z.size() + 1]), pused(new bool[p.size()]);
+    filter::design::detail::zpk2sos(z.data(), z.size(), p.data(), p.size(), n[0], zused.get(), pused.get(), s.data());
+    return s;
+  }
+
+  /**
+   * Factor into a cascade of M biquads, padded with pass-through sections
+   *
+   * @tparam M number of sections, at least (order + 1) / 2
+   * @return filter::BiquadCascade<filter::Biquad<T>, M>
+   */
+  template<size_t M>
+  filter::BiquadCascade<filter::Biquad<T>, M> cascade() const {
+    auto s = sections();
+    if (s.size() > M)
+      throw std::length_error("tf: order exceeds the cascade");
+    std::array<filter::sos<T>, M> a;
+    a.fill({1, 0, 0, 0, 0});
+    std::copy(s.begin(), s.end(), a.begin());
+    return filter::design::cascade(a);
+  }
+
+  /**
+   * @return size_t number of states of statespace(), one more than the order with a pole at the origin
+   */
+  size_t states() const {
+    return order() + (d.back() == T(0) ? 1 : 0);
+  }
+
+  /**
+   * Balanced controllable canonical realization
+   *
+   * The companion matrix is balanced by a diagonal similarity of powers of two,
+   * so states of high-order realizations have comparable magnitudes. Like any
+   * ss, step() returns C x + D u after the state update, so the realization
+   * is of (H - D) / z, and stepping it runs H itself. D = H(0) unless H has a
+   * pole at the origin, which then takes one more state.
+   *
+   * @tparam Nx number of states, states()
+   * @return ss<T, Nx>
+   */
+  template<size_t Nx>
+  ss<T, Nx> statespace() const {
+    using P = ss<T, Nx>;
+    if (states() != Nx)
+      throw std::length_error("tf: order differs from the state-space");
+    if (!proper())
+      throw std::domain_error("tf: improper transfer function has no realization");
+
+    // Numerator padded to the order, both times z with a pole at the origin
+    poly a = d, b(order() + 1 - n.size(), T(0));
+    b.insert(b.end(), n.begin(), n.end());
+    if (Nx > order()) {
+      a.push_back(0);
+      b.push_back(0);
+    }
+    const T h0 = a[Nx] != T(0) ? b[Nx] / a[Nx] : b[0];
+
+    detail::MatrixX<T> A = detail::MatrixX<T>::Zero(Nx, Nx);
+    for (size_t j = 0; j < Nx; j++)
+      A(0, j) = -a[j + 1];
+    for (size_t i = 1; i < Nx; i++)
+      A(i, i - 1) = 1;
+    auto s = detail::balance(A);
+
+    typename P::TA Ab = A;
+    typename P::TB B = P::TB::Zero();
+    typename P::TC C;
+    typename P::TD D;
+    B(0) = 1 / s(0);
+    for (size_t j = 0; j < Nx; j++)
+      C(j) = (b[j] - h0 * a[j]) * s(Eigen::Index(j));
+    D(0) = h0;
+    return P(Ab, B, C, D);
+  }
+
+ protected:
+  poly n, d;
+
+  static complex horner(const poly &p, complex z) {
+    complex v = 0;
+    for (auto c : p)
+      v = v * z + c;
+    return v;
+  }
+
+  template<typename M>
+  static std::vector<complex> eig(const M &A) {
+    if (A.rows() == 0)
+      return {};
+    detail::MatrixX<T> X = A;
+    detail::balance(X);
+    Eigen::EigenSolver<detail::MatrixX<T>> es(X, false);
+    std::vector<complex> r(es.eigenvalues().data(), es.eigenvalues().data() + X.rows());
+    for (auto &z : r)
+      if (std::abs(z.imag()) <= 100 * std::numeric_limits<T>::epsilon() * std::abs(z))
+        z = z.real();
+    return r;
+  }
+};
+
+}
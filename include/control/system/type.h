@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
 namespace control::system {
 
 /**
@@ -24,4 +28,56 @@ class SISO {
   virtual T step(T) = 0;
 };
 
+namespace detail {
+
+template<typename C, typename T, typename = void>
+struct has_process : std::false_type {};
+
+template<typename C, typename T>
+struct has_process<C, T, std::void_t<decltype(std::declval<C &>().process(
+    std::declval<const T *>(), size_t(), std::declval<T *>()))>> : std::true_type {};
+
+template<typename C, typename T, typename = void>
+struct has_step : std::false_type {};
+
+template<typename C, typename T>
+struct has_step<C, T, std::void_t<decltype(T(std::declval<C &>().step(std::declval<T>())))>>
+    : std::is_arithmetic<std::decay_t<decltype(std::declval<C &>().step(std::declval<T>()))>> {};
+
+}
+
+/**
+ * Run a block of samples through a component
+ *
+ * Uses the component's block process(x, n, y) when it has one, either
+ * producing n outputs or returning how many it produced (decimators), and
+ * otherwise steps it per sample. Single-input single-output state-spaces are
+ * stepped with 1x1 input vectors.
+ *
+ * @param c component
+ * @param x n inputs
+ * @param n number of inputs
+ * @param y room for n outputs
+ * @return size_t number of outputs
+ */
+template<typename C, typename T>
+size_t process(C &c, const T *x, size_t n, T *y) {
+  if constexpr (detail::has_process<C, T>::value) {
+    if constexpr (std::is_void_v<decltype(c.process(x, n, y))>) {
+      c.process(x, n, y);
+      return n;
+    } else {
+      return c.process(x, n, y);
+    }
+  } else if constexpr (detail::has_step<C, T>::value) {
+    for (size_t i = 0; i < n; i++)
+      y[i] = c.step(x[i]);
+    return n;
+  } else {
+    for (size_t i = 0; i < n; i++)
+      y[i] = c.step(C::Tu::Constant(x[i]))(0);
+    return n;
+  }
+}
+
 }
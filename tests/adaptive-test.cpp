@@ -0,0 +1,147 @@
+#include "control/filter/adaptive.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace control::filter;
+
+template<size_t N>
+std::array<double, N> plant() {
+  std::array<double, N> h;
+  for (size_t k = 0; k < N; k++)
+    h[k] = std::exp(-4. * k / N) * std::cos(0.7 * k);
+  return h;
+}
+
+// Identify a FIR plant from a coloured reference; the error and the tap error
+// after n samples
+template<typename F, size_t N>
+std::pair<double, double> identify(F &f, size_t n, double colour) {
+  const auto h = plant<N>();
+  std::minstd_rand e(3);
+  std::normal_distribution<double> g(0, 1);
+
+  Fir<double, N> P(h);
+  double x = 0, err = 0;
+  for (size_t i = 0; i < n; i++) {
+    x = colour * x + g(e);
+    const double r = f.step(x, P.step(x));
+    if (i >= n - 1000)
+      err += r * r / 1000;
+  }
+
+  const auto w = f.taps();
+  double dw = 0;
+  for (size_t k = 0; k < N; k++)
+    dw = std::max(dw, std::abs(w[k] - h[k]));
+  return {std::sqrt(err), dw};
+}
+
+TEST(AdaptiveTest, Identify) {
+  {
+    Lms<double, 32> f(0.005);
+    auto [e, dw] = identify<decltype(f), 32>(f, 20000, 0);
+    EXPECT_LT(e, 1e-4);
+    EXPECT_LT(dw, 1e-4);
+  }
+  {
+    Nlms<double, 32> f(0.5);
+    auto [e, dw] = identify<decltype(f), 32>(f, 20000, 0.9);
+    EXPECT_LT(e, 1e-4);
+    EXPECT_LT(dw, 1e-4);
+  }
+  {
+    FdLms<double, 32> f(0.5);
+    auto [e, dw] = identify<decltype(f), 32>(f, 20000, 0.9);
+    EXPECT_LT(e, 1e-4);
+    EXPECT_LT(dw, 1e-4);
+  }
+  {
+    // Converges in a few times N samples
+    Rls<double, 16> f(1., 1e4);
+    auto [e, dw] = identify<decltype(f), 16>(f, 1100, 0.9);
+    EXPECT_LT(e, 1e-6);
+    EXPECT_LT(dw, 1e-6);
+  }
+}
+
+TEST(AdaptiveTest, FdLmsNormalizes) {
+  // On a strongly coloured reference the per-bin normalization converges
+  // where Nlms is still far off
+  Nlms<double, 64> n(0.5);
+  FdLms<double, 64> f(0.5, 0.9, 0.01);
+  const double en = identify<decltype(n), 64>(n, 8192, 0.99).first;
+  const double ef = identify<decltype(f), 64>(f, 8192, 0.99).first;
+  EXPECT_LT(ef, en / 10);
+
+  // Identical after a reset
+  f.reset();
+  EXPECT_EQ(ef, (identify<decltype(f), 64>(f, 8192, 0.99).first));
+}
+
+TEST(AdaptiveTest, Cancel) {
+  // Cancel a vibration through an unknown path from a reference at the source
+  const auto h = plant<64>();
+  Fir<float, 64> path([&] {
+    std::array<float, 64> p;
+    for (size_t k = 0; k < 64; k++)
+      p[k] = float(h[k]);
+    return p;
+  }());
+  FdLms<float, 64> f(0.2f, 0.9f, 1.f);
+
+  std::minstd_rand e(5);
+  std::normal_distribution<float> g(0, 0.01f);
+  const size_t n = 40000;
+  std::vector<float> x(n), d(n), r(n);
+  for (size_t i = 0; i < n; i++) {
+    x[i] = std::sin(0.2f * i) + 0.3f * std::sin(0.61f * i);
+    d[i] = path.step(x[i]) + g(e);
+  }
+  f.process(x.data(), d.data(), n, r.data());
+
+  double pd = 0, pr = 0;
+  for (size_t i = n - 4000; i < n; i++) {
+    pd += d[i] * d[i];
+    pr += r[i] * r[i];
+  }
+  // Down to the uncorrelated noise
+  EXPECT_LT(std::sqrt(pr / 4000), 0.02);
+  EXPECT_GT(pd / pr, 1000);
+}
+
+TEST(AdaptiveTest, Notch) {
+  // A tone drifting from 0.1 to 0.12 of the Nyquist frequency, with noise
+  AdaptiveNotch<double> f(0.08, 0.01, 0.005);
+  std::minstd_rand e(7);
+  std::normal_distribution<double> g(0, 0.01);
+
+  const double pi = std::acos(-1.);
+  const size_t n = 40000;
+  double phase = 0, w = 0, pr = 0, px = 0;
+  for (size_t i = 0; i < n; i++) {
+    w = 0.1 + 0.02 * double(i) / n;
+    phase += pi * w;
+    const double x = std::sin(phase) + g(e);
+    const double y = f.step(x);
+    if (i >= n - 4000) {
+      px += x * x;
+      pr += y * y;
+    }
+  }
+  EXPECT_NEAR(f.frequency(), w, 1e-3);
+  EXPECT_GT(px / pr, 100);
+
+  // The biquad is the notch at the tracked frequency
+  Biquad<double, double> b = f.filter();
+  auto [p1, p2] = b.poles();
+  EXPECT_NEAR(std::arg(p1), std::abs(pi * f.frequency()), 1e-2);
+  EXPECT_TRUE(f.filter().stable());
+}
+
+}
@@ -0,0 +1,117 @@
+#include "control/system/dd.h"
+#include "control/system/ss.h"
+#include "control/classic/pid.h"
+#include "control/filter/biquad.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using namespace control::system;
+using D = dd<double>;
+
+// |a - b| as a double
+double err(const D &a, const D &b) {
+  return std::abs(double(a - b));
+}
+
+TEST(DdTest, ArithmeticTest) {
+  const double eps = std::numeric_limits<D>::epsilon().hi;
+  EXPECT_LT(eps, 1e-31);
+  EXPECT_EQ(std::numeric_limits<D>::digits, 106);
+
+  // Below the resolution of double, kept in lo
+  D a = D(1) + 1e-20;
+  EXPECT_EQ(a.hi, 1.);
+  EXPECT_EQ(a.lo, 1e-20);
+  EXPECT_EQ(double((a - 1.) * 1e20), 1.);
+
+  D third = D(1) / D(3);
+  EXPECT_LT(err(third * 3., D(1)), 4 * eps);
+  EXPECT_LT(err(D(1) / 3. * 3, D(1)), 4 * eps);
+  D r = sqrt(D(2));
+  EXPECT_LT(err(r * r, D(2)), 8 * eps);
+  EXPECT_EQ(sqrt(D(0)), D(0));
+
+  // (1 + 2^-60)^2 = 1 + 2^-59 + 2^-120
+  D s = D(1) + std::ldexp(1., -60);
+  D sq = s * s;
+  EXPECT_EQ(sq.hi, 1.);
+  EXPECT_EQ(sq.lo, std::ldexp(1., -59) + std::ldexp(1., -120));
+
+  EXPECT_TRUE(D(1) < D(1, 1e-30));
+  EXPECT_TRUE(D(-2) < D(1));
+  EXPECT_EQ(abs(D(-2, 1e-20)), D(2, -1e-20));
+  EXPECT_EQ(D(5) / std::numeric_limits<D>::infinity(), D(0));
+  EXPECT_TRUE(isinf(std::numeric_limits<D>::infinity()));
+}
+
+TEST(DdTest, EigenTest) {
+  Eigen::Matrix<D, 3, 3> M;
+  M << 4, 1, 0, 1, 3, 1, 0, 1, 2;
+  Eigen::Matrix<D, 3, 1> b(1, 2, 3);
+  Eigen::Matrix<D, 3, 1> x = M.partialPivLu().solve(b);
+  EXPECT_LT(double((M * x - b).norm()), 1e-30);
+  EXPECT_LT(double((M.inverse() * M - Eigen::Matrix<D, 3, 3>::Identity()).norm()), 1e-30);
+  EXPECT_EQ(double(Eigen::Matrix<D, 2, 2>::Zero().sum()), 0.);
+}
+
+/**
+ * The double integrator of a constant input accumulates without drift
+ */
+TEST(DdTest, IntegratorTest) {
+  const long n = 1000000;
+  auto run = [n](auto zero) {
+    using T = decltype(zero);
+    using P = ss<T, 2>;
+    typename P::TA A;
+    typename P::TB B;
+    typename P::TC C;
+    typename P::TD Dm;
+    A << T(1), T(1), T(0), T(1);
+    B << T(0.5), T(1);
+    C << T(1), T(0);
+    Dm << T(0);
+    P p(A, B, C, Dm);
+    for (long i = 0; i < n; i++)
+      p.step(P::Tu::Constant(T(0.1)));
+    return p.y(0);
+  };
+
+  // n^2 u / 2 is exact in double-double for u = 0.1 rounded to double
+  const D exact = D(0.1) * double(n) * double(n) / 2.;
+  const D y = run(D(0));
+  EXPECT_EQ(y, exact);
+  EXPECT_GT(std::abs(run(0.) - double(exact)), 1e-8);
+}
+
+TEST(DdTest, PidTest) {
+  const long n = 1000000;
+  control::classic::PI<D> pi(0.001, 2., 0.5);
+  control::classic::PI<double> pd(0.001, 2., 0.5);
+  D u = 0;
+  double ud = 0;
+  for (long i = 0; i < n; i++) {
+    u = pi.step(D(0.1));
+    ud = pd.step(0.1);
+  }
+  // Kp e (1 + Ts (n - 1/2) / Ti), up to rounding of the coefficients
+  const D exact = D(2.) * 0.1 * (D(1) + D(0.001) * (double(n) - 0.5) / 0.5);
+  EXPECT_LT(err(u, exact), 1e-20 * double(exact));
+  EXPECT_GT(std::abs(ud - double(exact)), 1e3 * err(u, exact));
+}
+
+TEST(DdTest, BiquadTest) {
+  control::filter::Biquad<D> b(control::filter::sos<double>{0.25, 0.5, 0.25, -0.5, 0.25});
+  EXPECT_TRUE(b.stable());
+  EXPECT_FALSE(control::filter::Biquad<D>(control::filter::sos<double>{1, 0, 0, -2.5, 1.5}).stable());
+  for (int i = 0; i < 100; i++)
+    b.step(D(1));
+  EXPECT_LT(err(b.step(D(1)), D(4) / 3), 1e-28);
+}
+
+}  // namespace
@@ -0,0 +1,84 @@
+#include "control/system/denormal.h"
+#include "control/filter/biquad.h"
+#include "control/classic/pid.h"
+#include "control/system/ss.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+
+namespace {
+
+using control::system::snap;
+
+TEST(DenormalTest, SnapTest) {
+  EXPECT_EQ(snap(1e-35f), 0.f);
+  EXPECT_EQ(snap(-1e-35f), 0.f);
+  EXPECT_EQ(snap(1e-20f), 1e-20f);
+  EXPECT_EQ(snap(1e-300), 0.);
+  EXPECT_EQ(snap(1e-200), 1e-200);
+  EXPECT_EQ(snap(1), 1);
+}
+
+/**
+ * The decay tail of a biquad ends in exact zeros instead of subnormals
+ */
+TEST(DenormalTest, BiquadTailTest) {
+  control::filter::Biquad<float> b(0.1f, 0, 0, -0.9f, 0);
+  b.step(1);
+  for (int i = 0; i < 2000; i++) {
+    float y = b.step(0);
+    ASSERT_NE(std::fpclassify(y), FP_SUBNORMAL);
+    b.snap();
+  }
+  EXPECT_EQ(b.step(0), 0.f);
+}
+
+TEST(DenormalTest, ControllerTailTest) {
+  control::classic::PID<float> c(0.5f, 1.f, 1.f, 1.f, 1.f);
+  c.step(1);
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_NE(std::fpclassify(c.step(0)), FP_SUBNORMAL);
+    c.snap();
+  }
+
+  // Only the integrator remains
+  float u = c.step(0);
+  EXPECT_EQ(c.step(0), u);
+}
+
+TEST(DenormalTest, StateSpaceTailTest) {
+  using ss = control::system::ss<float, 2>;
+  ss::TA A;
+  ss::TB B;
+  ss::TC C;
+  ss::TD D;
+  A << 0.5, 0.1, 0, 0.5;
+  B << 1, 1;
+  C << 1, 1;
+  D << 0;
+  ss P(A, B, C, D);
+
+  P.step(ss::Tu::Ones());
+  for (int i = 0; i < 1000; i++) {
+    auto y = P.step(ss::Tu::Zero());
+    ASSERT_NE(std::fpclassify(y(0)), FP_SUBNORMAL);
+    P.snap();
+  }
+  EXPECT_TRUE(P.x.isZero(0));
+}
+
+TEST(DenormalTest, FlushGuardTest) {
+  if (!control::system::FlushDenormals::supported())
+    return;
+
+  volatile float tiny = std::numeric_limits<float>::min();
+  volatile float half = 0.5f;
+  {
+    control::system::FlushDenormals guard;
+    EXPECT_EQ(tiny * half, 0.f);
+  }
+  EXPECT_NE(tiny * half, 0.f);
+}
+
+}  // namespace
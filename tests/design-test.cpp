@@ -0,0 +1,88 @@
+#include "control/filter/design.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+
+namespace {
+
+using namespace control::filter::design;
+
+double dB(std::complex<double> h) {
+  return 20 * std::log10(std::abs(h));
+}
+
+/**
+ * 2-nd order Butterworth LP with Wc = 0.1 from the readme
+ */
+TEST(DesignTest, ButterworthReadmeTest) {
+  auto s = butter<2>(0.1);
+  EXPECT_NEAR(s[0].b0, 0.0201, 1e-4);
+  EXPECT_NEAR(s[0].b1, 0.0402, 1e-4);
+  EXPECT_NEAR(s[0].b2, 0.0201, 1e-4);
+  EXPECT_NEAR(s[0].a1, -1.5610, 1e-4);
+  EXPECT_NEAR(s[0].a2, 0.6414, 1e-4);
+}
+
+TEST(DesignTest, ButterworthTest) {
+  auto lp = butter<5>(0.3);
+  EXPECT_NEAR(std::abs(freqz(lp, 0.)), 1, 1e-12);
+  EXPECT_NEAR(dB(freqz(lp, 0.3)), -3.0103, 1e-3);
+
+  auto hp = butter<4>(0.3, pass::high);
+  EXPECT_NEAR(std::abs(freqz(hp, 1.)), 1, 1e-12);
+  EXPECT_NEAR(dB(freqz(hp, 0.3)), -3.0103, 1e-3);
+  EXPECT_NEAR(std::abs(freqz(hp, 0.)), 0, 1e-12);
+}
+
+TEST(DesignTest, ChebyshevTest) {
+  auto s = cheby1<5>(1., 0.3);
+  for (double w = 0; w < 0.3; w += 0.01) {
+    EXPECT_LE(dB(freqz(s, w)), 1e-9);
+    EXPECT_GE(dB(freqz(s, w)), -1 - 1e-9);
+  }
+  EXPECT_NEAR(dB(freqz(s, 0.3)), -1, 1e-6);
+}
+
+TEST(DesignTest, EllipticTest) {
+  auto s = ellip<4>(1., 40., 0.3);
+  for (double w = 0; w < 0.3; w += 0.01)
+    EXPECT_GE(dB(freqz(s, w)), -1 - 1e-6);
+  EXPECT_NEAR(dB(freqz(s, 0.3)), -1, 1e-6);
+  for (double w = 0.45; w <= 1; w += 0.01)
+    EXPECT_LE(dB(freqz(s, w)), -40 + 1e-6);
+}
+
+/**
+ * Sections are ordered by increasing pole radius
+ */
+TEST(DesignTest, OrderingTest) {
+  auto s = ellip<5>(0.5, 60., 0.3);
+  for (size_t i = 1; i < s.size(); i++)
+    EXPECT_LT(std::abs(s[i - 1].a2), std::abs(s[i].a2) + 1e-12);
+}
+
+TEST(DesignTest, CascadeTest) {
+  auto s = butter<4>(0.2);
+  auto bc = cascade(s);
+
+  // Unity DC gain
+  double y = 0;
+  for (int i = 0; i < 500; i++)
+    y = bc.step(1);
+  EXPECT_NEAR(y, 1, 1e-9);
+}
+
+TEST(DesignTest, NotchRetuneTest) {
+  control::filter::Biquad<double, double> b(notch(0.2, 5.));
+  std::array<control::filter::sos<double>, 1> s{b.coefficients()};
+  EXPECT_NEAR(std::abs(freqz(s, 0.2)), 0, 1e-9);
+  EXPECT_NEAR(std::abs(freqz(s, 0.)), 1, 1e-12);
+
+  b.coefficients(notch(0.4, 5.));
+  s[0] = b.coefficients();
+  EXPECT_NEAR(std::abs(freqz(s, 0.4)), 0, 1e-9);
+  EXPECT_NEAR(std::abs(freqz(s, 1.)), 1, 1e-12);
+}
+
+}  // namespace
@@ -0,0 +1,142 @@
+#include "control/system/executor.h"
+#include "control/classic/pid.h"
+#include "control/filter/biquad.h"
+#include "control/filter/ghk.h"
+#include "control/system/ss.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <vector>
+
+namespace {
+
+using namespace control::system;
+
+TEST(ExecutorTest, RatesTest) {
+  Executor<3> ex;
+  int a = 0, b = 0, c = 0;
+  ex.every(100, [&] { c++; });
+  ex.every(1, [&] { a++; });
+  ex.every(10, [&] { b++; });
+  EXPECT_EQ(ex.hyperperiod(), 100u);
+
+  for (int i = 0; i < 1000; i++)
+    ex.tick();
+  EXPECT_EQ(ex.frame(), 1000u);
+  EXPECT_EQ(a, 1000);
+  EXPECT_EQ(b, 100);
+  EXPECT_EQ(c, 10);
+  EXPECT_EQ(ex.task_stats(0).steps, 10u);
+  EXPECT_EQ(ex.frame_stats().steps, 1000u);
+
+  ex.reset();
+  EXPECT_EQ(ex.frame(), 0u);
+  EXPECT_EQ(ex.task_stats(1).steps, 0u);
+}
+
+/**
+ * Within a frame, faster tasks run first; equal rates keep their order
+ */
+TEST(ExecutorTest, OrderTest) {
+  Executor<4> ex;
+  std::vector<int> log;
+  log.reserve(64);
+  ex.every(4, [&] { log.push_back(4); });
+  ex.every(2, [&] { log.push_back(2); }, 0, 1);
+  ex.every(1, [&] { log.push_back(1); });
+  ex.every(4, [&] { log.push_back(5); });
+
+  for (int i = 0; i < 4; i++)
+    ex.tick();
+  EXPECT_THAT(log, ::testing::ElementsAre(1, 4, 5, 1, 2, 1, 1, 2));
+
+  EXPECT_THROW(ex.every(1, [] {}), std::length_error);
+  Executor<1> ex1;
+  EXPECT_THROW(ex1.every(0, [] {}), std::invalid_argument);
+  EXPECT_THROW(ex1.every(2, [] {}, 0, 2), std::invalid_argument);
+}
+
+/**
+ * Phases spread slow tasks over frames
+ */
+TEST(ExecutorTest, WorstCaseTest) {
+  Executor<3> ex;
+  ex.every(1, [] {}, 10);
+  ex.every(10, [] {}, 50);
+  ex.every(10, [] {}, 50);
+  EXPECT_EQ(ex.worst_case(), 110u);
+
+  Executor<3> spread;
+  spread.every(1, [] {}, 10);
+  spread.every(10, [] {}, 50);
+  spread.every(10, [] {}, 50, 5);
+  EXPECT_EQ(spread.worst_case(), 60u);
+}
+
+TEST(ExecutorTest, DeadlineTest) {
+  volatile double sink = 0;
+  Executor<2> ex(1);
+  ex.every(1, [&] {
+    for (int i = 0; i < 10000; i++)
+      sink = sink + 1.;
+  }, 1);
+  ex.every(1, [] {});
+
+  bool met = true;
+  for (int i = 0; i < 10; i++)
+    met = ex.tick() && met;
+  EXPECT_FALSE(met);
+  EXPECT_EQ(ex.frame_stats().misses, 10u);
+  EXPECT_EQ(ex.task_stats(0).misses, 10u);
+  EXPECT_EQ(ex.task_stats(1).misses, 0u);
+
+  // Released frames at 10 kHz; overruns depend on the host, so are not checked
+  Executor<1> idle;
+  idle.every(1, [] {});
+  auto t0 = ticks();
+  idle.run(uint64_t(tick_rate() / 10000), 100);
+  EXPECT_GE(ticks() - t0, uint64_t(99 * tick_rate() / 10000));
+  EXPECT_EQ(idle.frame(), 100u);
+  EXPECT_EQ(idle.jitter_stats().steps, 100u);
+}
+
+/**
+ * Current lag at 10 kHz, motor and velocity PI at 1 kHz, g-h-k tracker at 100 Hz
+ */
+TEST(ExecutorTest, CascadeTest) {
+  using P = ss<double, 1>;
+  P::TA A;
+  P::TB B;
+  P::TC C;
+  P::TD D;
+  A << 1;
+  B << 0.01;
+  C << 1;
+  D << 0;
+  P motor(A, B, C, D);
+
+  control::filter::Biquad<double> lag(0.1, 0, 0, -0.9, 0);
+  control::classic::PI<double> velocity(1e-3, 2., 0.05);
+  auto g = control::ghk::parameterize::critical_dampened(0.5);
+  control::ghk::state<double> track{};
+
+  const double vref = 1.;
+  double iref = 0., i = 0., v = 0., verr = 0.;
+
+  Executor<4> ex;
+  ex.every(1, lag, iref, i);
+  ex.every(10, [&] {
+    v = motor.step(P::Tu::Constant(i))(0);
+    verr = vref - v;
+  });
+  ex.every(10, velocity, verr, iref);
+  ex.every(100, [&] { track = control::ghk::correct_predict(g, track, v, 1e-2).correction; });
+
+  for (int k = 0; k < 20000; k++)
+    ex.tick();
+  EXPECT_NEAR(v, vref, 1e-3);
+  EXPECT_NEAR(track.x, vref, 1e-3);
+  EXPECT_EQ(ex.task_stats(3).steps, 200u);
+}
+
+}  // namespace
@@ -0,0 +1,111 @@
+#include "control/filter/fir.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using namespace control::filter;
+
+template<typename T>
+std::vector<T> signal(size_t n) {
+  std::vector<T> x(n);
+  for (size_t i = 0; i < n; i++)
+    x[i] = T(std::sin(0.05 * i) + 0.5 * std::cos(1.3 * i) + (i % 97 == 0));
+  return x;
+}
+
+template<typename T, size_t N>
+std::array<T, N> taps() {
+  std::array<T, N> h;
+  for (size_t k = 0; k < N; k++)
+    h[k] = T(std::exp(-3. * k / N) * std::cos(0.3 * k));
+  return h;
+}
+
+// Direct convolution in double precision, h[0] on the newest sample
+template<typename T, size_t N>
+std::vector<double> convolve(const std::array<T, N> &h, const std::vector<T> &x) {
+  std::vector<double> y(x.size(), 0);
+  for (size_t n = 0; n < x.size(); n++)
+    for (size_t k = 0; k < N && k <= n; k++)
+      y[n] += double(h[k]) * double(x[n - k]);
+  return y;
+}
+
+TEST(FftTest, DftTest) {
+  using fft = FFT<double, 16>;
+  fft F;
+  std::array<fft::complex, 16> x, X;
+  for (size_t i = 0; i < 16; i++)
+    x[i] = X[i] = fft::complex(std::cos(0.7 * i), 0.1 * i);
+  F.forward(X.data());
+
+  const double pi = std::acos(-1.);
+  for (size_t k = 0; k < 16; k++) {
+    fft::complex d = 0;
+    for (size_t n = 0; n < 16; n++)
+      d += x[n] * std::polar(1., -2 * pi * k * n / 16);
+    EXPECT_NEAR(X[k].real(), d.real(), 1e-12);
+    EXPECT_NEAR(X[k].imag(), d.imag(), 1e-12);
+  }
+
+  F.inverse(X.data());
+  for (size_t i = 0; i < 16; i++) {
+    EXPECT_NEAR(X[i].real(), x[i].real(), 1e-14);
+    EXPECT_NEAR(X[i].imag(), x[i].imag(), 1e-14);
+  }
+}
+
+template<typename T, size_t N, size_t B>
+void compare(double tol) {
+  auto h = taps<T, N>();
+  auto x = signal<T>(3 * N + 77);
+  auto ref = convolve(h, x);
+
+  // Large filters do not belong on the stack
+  auto f = std::make_unique<Fir<T, N, B>>(h);
+  std::vector<T> y(x.size());
+  f->process(x.data(), x.size(), y.data());
+  for (size_t n = 0; n < x.size(); n++)
+    ASSERT_NEAR(y[n], ref[n], tol) << "at " << n;
+
+  // Identical after reset
+  f->reset();
+  for (size_t n = 0; n < x.size(); n++)
+    ASSERT_EQ(f->step(x[n]), y[n]);
+}
+
+TEST(FirTest, DirectTest) {
+  compare<double, 33, 0>(1e-12);
+  compare<float, 33, 0>(1e-5);
+}
+
+TEST(FirTest, PartitionedTest) {
+  compare<double, 100, 16>(1e-12);
+  compare<double, 300, 64>(1e-12);
+  compare<double, 4096, detail::fir_partition(4096)>(1e-11);
+  compare<float, 1000, detail::fir_partition(1000)>(1e-4);
+}
+
+TEST(FirTest, PartitionTest) {
+  EXPECT_EQ(detail::fir_partition(64), 0u);
+  EXPECT_EQ(detail::fir_partition(512), 0u);
+  EXPECT_EQ(detail::fir_partition(1000), 32u);
+  EXPECT_EQ(detail::fir_partition(4096), 32u);
+  EXPECT_EQ(detail::fir_partition(16384), 64u);
+}
+
+TEST(FirTest, ImpulseTest) {
+  auto h = taps<double, 600>();
+  Fir<double, 600> f(h);
+  EXPECT_NEAR(f.step(1), h[0], 1e-15);
+  for (size_t k = 1; k < 600; k++)
+    EXPECT_NEAR(f.step(0), h[k], 1e-14);
+  EXPECT_NEAR(f.step(0), 0, 1e-14);
+}
+
+}  // namespace
@@ -0,0 +1,188 @@
+#include "control/system/flat.h"
+#include "control/filter/design.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+using namespace control::system;
+using control::filter::Biquad;
+using control::filter::BiquadBank;
+using control::filter::BiquadCascade;
+
+std::string temp(const std::string &name) {
+  const char *dir = std::getenv("TMPDIR");
+  return std::string(dir ? dir : "/tmp") + "/control-flat-" + name;
+}
+
+ss<double, 2> plant() {
+  using P = ss<double, 2>;
+  P::TA A;
+  P::TB B;
+  P::TC C;
+  P::TD D;
+  A << 0.9, 0.1, -0.2, 0.8;
+  B << 0, 1;
+  C << 1, 0.5;
+  D << 0.1;
+  return P(A, B, C, D);
+}
+
+/**
+ * A bank steps its channels like the separate cascades
+ */
+TEST(FlatTest, BankTest) {
+  using namespace control::filter::design;
+  std::vector<BiquadCascade<Biquad<double>, 2>> cs;
+  for (double w : {0.05, 0.1, 0.2})
+    cs.push_back(cascade(butter<4>(w)));
+
+  BiquadBank<double> b(cs.size(), 2);
+  for (size_t k = 0; k < cs.size(); k++)
+    b.channel(k, cs[k]);
+
+  for (int t = 0; t < 200; t++) {
+    double x[3], y[3];
+    for (size_t k = 0; k < 3; k++)
+      x[k] = std::sin(0.1 * t * (k + 1));
+    b.step(x, y);
+    for (size_t k = 0; k < 3; k++)
+      ASSERT_NEAR(y[k], cs[k].step(x[k]), 1e-12) << t << " " << k;
+  }
+
+  EXPECT_EQ(b.section(1, 0).b0, cs[1].sections()[0].coefficients().b0);
+  b.reset();
+  EXPECT_THAT(std::vector<double>(b.state(), b.state() + 12), ::testing::Each(0.));
+}
+
+/**
+ * Configurations survive a round trip through an image
+ */
+TEST(FlatTest, RoundTripTest) {
+  auto cs = control::filter::design::cascade(control::filter::design::butter<4>(0.1));
+  control::classic::PID<double> pid(1e-3, 2., 0.5, 0.01, 10., 5.);
+  auto P = plant();
+  control::ghk::coeff<double> g{0.5, 0.4, 0.1};
+
+  FlatWriter<double> w;
+  EXPECT_EQ(w.add(cs), 0u);
+  EXPECT_EQ(w.add(pid), 1u);
+  EXPECT_EQ(w.add(P), 2u);
+  EXPECT_EQ(w.add(g), 3u);
+  auto bytes = w.bytes();
+  EXPECT_EQ(bytes.size() % 64, 0u);
+
+  FlatImage<double> img(bytes.data(), bytes.size());
+  ASSERT_EQ(img.size(), 4u);
+  EXPECT_EQ(img.kind(0), record::biquads);
+  EXPECT_EQ(img.kind(3), record::ghk);
+  EXPECT_FALSE(img.has_state(1));
+
+  auto cs2 = img.cascade<2>(0);
+  auto pid2 = img.pid(1);
+  auto P2 = img.statespace<2>(2);
+  auto g2 = img.ghk(3);
+  EXPECT_EQ(g2.h, 0.4);
+  EXPECT_EQ(P2.getA(), P.getA());
+  EXPECT_EQ(P2.getD(), P.getD());
+
+  for (int t = 0; t < 100; t++) {
+    double x = std::cos(0.2 * t);
+    ASSERT_EQ(cs2.step(x), cs.step(x));
+    ASSERT_EQ(pid2.step(x), pid.step(x));
+    P.step(ss<double, 2>::Tu::Constant(x));
+    P2.step(ss<double, 2>::Tu::Constant(x));
+    ASSERT_EQ(P2.y, P.y);
+  }
+
+  // Kind and size are checked
+  EXPECT_THROW(img.pid(0), std::runtime_error);
+  EXPECT_THROW(img.cascade<3>(0), std::runtime_error);
+  EXPECT_THROW(img.statespace<3>(2), std::runtime_error);
+  EXPECT_THROW(img.kind(4), std::runtime_error);
+}
+
+/**
+ * Restored state continues where the saved components left off, without a transient
+ */
+TEST(FlatTest, StateTest) {
+  auto cs = control::filter::design::cascade(control::filter::design::butter<4>(0.1));
+  control::classic::PID<double> pid(1e-3, 2., 0.5, 0.01, 10., 0.5);
+  auto P = plant();
+  control::ghk::state<double> s{1., 2., 3.};
+  for (int t = 0; t < 50; t++) {
+    cs.step(1.);
+    pid.step(1.);
+    P.step(ss<double, 2>::Tu::Constant(1.));
+  }
+  ASSERT_TRUE(pid.clipping);
+
+  auto path = temp("state");
+  FlatWriter<double> w;
+  w.add(cs, true);
+  w.add(pid, true);
+  w.add(P, true);
+  w.add(control::ghk::coeff<double>{0.5, 0.4, 0.1}, &s);
+  w.save(path);
+
+  auto img = FlatImage<double>::open(path);
+  EXPECT_TRUE(img.has_state(0));
+  auto cs2 = img.cascade<2>(0);
+  auto pid2 = img.pid(1);
+  auto P2 = img.statespace<2>(2);
+  control::ghk::state<double> s2{};
+  img.ghk(3, &s2);
+  EXPECT_EQ(s2.ddx, 3.);
+  EXPECT_TRUE(pid2.clipping);
+  EXPECT_EQ(P2.x, P.x);
+
+  auto b = img.bank(0);
+  EXPECT_EQ(b.channels(), 1u);
+  for (int t = 0; t < 50; t++) {
+    double x = 1., y;
+    b.step(&x, &y);
+    double r = cs.step(x);
+    ASSERT_EQ(cs2.step(x), r);
+    ASSERT_NEAR(y, r, 1e-12);
+    ASSERT_EQ(pid2.step(x), pid.step(x));
+  }
+  std::remove(path.c_str());
+}
+
+TEST(FlatTest, MalformedTest) {
+  BiquadBank<float> b(4, 3);
+  FlatWriter<float> w;
+  w.add(b, true);
+  auto bytes = w.bytes();
+
+  EXPECT_NO_THROW(FlatImage<float>(bytes.data(), bytes.size()));
+  EXPECT_THROW(FlatImage<double>(bytes.data(), bytes.size()), std::runtime_error);
+  EXPECT_THROW(FlatImage<float>(bytes.data(), bytes.size() - 64), std::runtime_error);
+  EXPECT_THROW(FlatImage<float>(bytes.data(), 10), std::runtime_error);
+
+  auto bad = bytes;
+  bad[0] = 'X';
+  EXPECT_THROW(FlatImage<float>(bad.data(), bad.size()), std::runtime_error);
+  bad = bytes;
+  bad[8] = 2;
+  EXPECT_THROW(FlatImage<float>(bad.data(), bad.size()), std::runtime_error);
+
+  // Dimensions whose payload size wraps around
+  bad = bytes;
+  const uint32_t dims[2] = {1u << 31, 1u << 31};
+  std::memcpy(bad.data() + 64 + 8, dims, sizeof(dims));
+  EXPECT_THROW(FlatImage<float>(bad.data(), bad.size()), std::runtime_error);
+  bad = bytes;
+  const uint64_t records = uint64_t(1) << 59;
+  std::memcpy(bad.data() + 16, &records, sizeof(records));
+  EXPECT_THROW(FlatImage<float>(bad.data(), bad.size()), std::runtime_error);
+
+  EXPECT_THROW(FlatImage<float>::open(temp("missing")), std::system_error);
+}
+
+}  // namespace
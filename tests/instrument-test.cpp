@@ -0,0 +1,133 @@
+#define CONTROL_INSTRUMENT
+#include "control/system/instrument.h"
+#include "control/classic/pid.h"
+#include "control/filter/biquad.h"
+#include "control/system/ss.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+using namespace control::system;
+
+TEST(InstrumentTest, ProbeTest) {
+  Probe p(100);
+  p.record(1);
+  p.record(5);
+  p.record(300);
+  p.record(0);
+
+  auto s = p.snapshot();
+  EXPECT_EQ(s.steps, 4u);
+  EXPECT_EQ(s.total, 306u);
+  EXPECT_EQ(s.min, 0u);
+  EXPECT_EQ(s.max, 300u);
+  EXPECT_EQ(s.misses, 1u);
+  EXPECT_EQ(s.histogram[0], 2u);
+  EXPECT_EQ(s.histogram[2], 1u);
+  EXPECT_EQ(s.histogram[8], 1u);
+  EXPECT_EQ(s.quantile(0.5), 1u);
+  EXPECT_EQ(s.quantile(0.75), 7u);
+  EXPECT_EQ(s.quantile(1), 511u);
+
+  p.reset();
+  EXPECT_EQ(p.snapshot().steps, 0u);
+}
+
+TEST(InstrumentTest, SaturationTest) {
+  Instrumented<control::classic::P<double>> c(control::classic::P<double>(1., 1.));
+
+  // In, out, out, in, out
+  for (double e : {0.5, 2., 3., 0.1, -5.})
+    c.step(e);
+
+  auto s = c.snapshot();
+  EXPECT_EQ(s.steps, 5u);
+  EXPECT_EQ(s.saturated, 3u);
+  EXPECT_EQ(s.saturations, 2u);
+  EXPECT_EQ(s.nonfinite, 0u);
+  EXPECT_TRUE(c->clipping);
+}
+
+TEST(InstrumentTest, NonFiniteTest) {
+  Instrumented<control::filter::Biquad<float>> b(control::filter::Biquad<float>(0.5f, 0, 0, 0, 0));
+  EXPECT_EQ(b.step(1.f), 0.5f);
+  b.step(std::numeric_limits<float>::quiet_NaN());
+  b.step(std::numeric_limits<float>::infinity());
+
+  auto s = b.snapshot();
+  EXPECT_EQ(s.steps, 3u);
+  EXPECT_EQ(s.nonfinite, 2u);
+  EXPECT_EQ(s.saturated, 0u);
+}
+
+TEST(InstrumentTest, StateSpaceTest) {
+  using ss = control::system::ss<double, 1>;
+  ss::TA A;
+  ss::TB B;
+  ss::TC C;
+  ss::TD D;
+  A << 0.5;
+  B << 1;
+  C << 1;
+  D << 0;
+
+  Instrumented<ss> P(ss(A, B, C, D));
+  for (int i = 0; i < 100; i++)
+    P.step(ss::Tu::Ones());
+  EXPECT_NEAR(P->x(0), 2., 1e-12);
+
+  auto s = P.snapshot();
+  EXPECT_EQ(s.steps, 100u);
+  EXPECT_EQ(std::accumulate(s.histogram.begin(), s.histogram.end(), uint64_t(0)), 100u);
+  EXPECT_LE(s.min, s.max);
+  EXPECT_GT(tick_rate(), 0.);
+}
+
+/**
+ * Snapshots from a reader thread while the writer steps
+ */
+TEST(InstrumentTest, ConcurrentSnapshotTest) {
+  Instrumented<control::classic::P<double>> c(control::classic::P<double>(2.));
+  std::atomic<bool> done{false};
+  uint64_t last = 0;
+  bool monotonic = true;
+
+  std::thread reader([&] {
+    while (!done.load()) {
+      auto s = c.snapshot();
+      monotonic &= s.steps >= last;
+      last = s.steps;
+    }
+  });
+
+  for (int i = 0; i < 100000; i++)
+    c.step(1.);
+  done = true;
+  reader.join();
+
+  EXPECT_TRUE(monotonic);
+  EXPECT_EQ(c.snapshot().steps, 100000u);
+}
+
+/**
+ * Without a probe the wrapper is the component and records nothing
+ */
+TEST(InstrumentTest, NullProbeTest) {
+  static_assert(std::is_same_v<DefaultProbe, Probe> && instrumented, "CONTROL_INSTRUMENT selects Probe");
+  using B = control::filter::Biquad<float>;
+  static_assert(std::is_empty_v<NullProbe>, "NullProbe must be empty");
+  static_assert(sizeof(Instrumented<B, NullProbe>) == sizeof(B), "NullProbe must take no space");
+
+  Instrumented<B, NullProbe> b(B(0.5f, 0, 0, 0, 0));
+  EXPECT_EQ(b.step(1.f), 0.5f);
+  EXPECT_EQ(b.snapshot().steps, 0u);
+}
+
+}  // namespace
@@ -0,0 +1,153 @@
+#include "control/system/kalman.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+using namespace control::system;
+
+const double Ts = 0.01;
+
+// Pendulum: angle and angular velocity, torque in, angle out
+auto pendulum() {
+  auto f = [](const auto &x, const auto &u) {
+    auto r = x.eval();
+    r.row(0) += Ts * x.row(1);
+    r.row(1) += Ts * (u.row(0) - 9.81 * x.row(0).array().sin().matrix() - 0.1 * x.row(1));
+    return r;
+  };
+  auto h = [](const auto &x) { return x.row(0).eval(); };
+  return nonlinear<double, 2>(f, h);
+}
+
+// Range to a beacon at (1, 0) of a point moving at constant velocity
+auto range() {
+  auto f = [](const auto &x, const auto &u) {
+    auto r = x.eval();
+    r.template topRows<2>() += Ts * x.template bottomRows<2>() + 0 * u;
+    return r;
+  };
+  auto h = [](const auto &x) {
+    auto dx = (x.row(0).array() - 1).eval();
+    return (dx * dx + x.row(1).array() * x.row(1).array()).sqrt().matrix().eval();
+  };
+  return nonlinear<double, 4, 1, 1>(f, h);
+}
+
+TEST(KalmanTest, NonlinearTest) {
+  auto P = pendulum();
+  P.x << 0.5, 0;
+  decltype(P)::Tu u(0.2);
+  auto y = P.step(u);
+  EXPECT_DOUBLE_EQ(P.x(0), 0.5);
+  EXPECT_DOUBLE_EQ(P.x(1), Ts * (0.2 - 9.81 * std::sin(0.5)));
+  EXPECT_DOUBLE_EQ(y(0), 0.5);
+
+  // Columns of states evaluate like single states
+  Eigen::Matrix<double, 2, 3> X;
+  X << 0.1, -1, 2, 0.5, 0, -3;
+  Eigen::Matrix<double, 2, 3> Xn = P.transition(X, Eigen::Matrix<double, 1, 3>::Constant(0.3));
+  for (int i = 0; i < 3; i++) {
+    Eigen::Vector2d xi = X.col(i);
+    Eigen::Vector2d xn = P.transition(xi, decltype(P)::Tu(0.3));
+    EXPECT_TRUE(Xn.col(i).isApprox(xn)) << i;
+  }
+}
+
+TEST(KalmanTest, JacobianTest) {
+  auto P = pendulum();
+  using S = decltype(P);
+  Eigen::Matrix2d Q = 1e-6 * Eigen::Matrix2d::Identity();
+  Eigen::Matrix<double, 1, 1> R(1e-4);
+  ekf<S> n(P, Q, R);
+  ekf<S, jacobian::autodiff> a(P, Q, R);
+
+  Eigen::Vector2d x(0.7, -0.3);
+  S::Tu u(0.1);
+  Eigen::Matrix2d F;
+  F << 1, Ts, -Ts * 9.81 * std::cos(0.7), 1 - 0.1 * Ts;
+  EXPECT_TRUE(a.transition_jacobian(x, u).isApprox(F, 1e-15));
+  EXPECT_TRUE(n.transition_jacobian(x, u).isApprox(F, 1e-9));
+  EXPECT_TRUE(a.output_jacobian(x).isApprox(Eigen::RowVector2d(1, 0)));
+
+  auto B = range();
+  using SB = decltype(B);
+  ekf<SB> nb(B, SB::Tx::Ones().asDiagonal(), Q.topLeftCorner<1, 1>());
+  ekf<SB, jacobian::autodiff> ab(B, SB::Tx::Ones().asDiagonal(), Q.topLeftCorner<1, 1>());
+  SB::Tx xb(4, 4, 1, 1);
+  EXPECT_TRUE(ab.output_jacobian(xb).isApprox(Eigen::RowVector4d(0.6, 0.8, 0, 0)));
+  EXPECT_TRUE(nb.output_jacobian(xb).isApprox(Eigen::RowVector4d(0.6, 0.8, 0, 0), 1e-9));
+}
+
+/**
+ * Both filters recover the velocity of a swinging pendulum from noisy angles
+ */
+TEST(KalmanTest, PendulumTest) {
+  auto P = pendulum();
+  using S = decltype(P);
+  Eigen::Matrix2d Q = Eigen::Vector2d(1e-8, 1e-6).asDiagonal();
+  Eigen::Matrix<double, 1, 1> R(1e-4);
+  S::Tx x0(0, 0);
+  ekf<S, jacobian::autodiff> e(P, Q, R, x0);
+  ekf<S> en(P, Q, R, x0);
+  ukf<S> k(P, Q, R, x0);
+  ukf<S, false> kc(P, Q, R, x0);
+
+  std::mt19937 gen(1);
+  std::normal_distribution<double> noise(0., 1e-2);
+  P.x << 1, 0;
+  double ee = 0, ek = 0;
+  for (int i = 0; i < 2000; i++) {
+    S::Tu u(std::sin(0.01 * i));
+    S::Ty z = P.step(u) + S::Ty(noise(gen));
+    e.step(u, z);
+    en.step(u, z);
+    k.step(u, z);
+    kc.step(u, z);
+    ASSERT_TRUE(k.x.isApprox(kc.x, 1e-9)) << i;
+    ASSERT_TRUE(e.x.isApprox(en.x, 1e-6)) << i;
+    if (i >= 1000) {
+      ee += std::pow(e.x(1) - P.x(1), 2);
+      ek += std::pow(k.x(1) - P.x(1), 2);
+    }
+  }
+  EXPECT_LT(std::sqrt(ee / 1000), 0.05);
+  EXPECT_LT(std::sqrt(ek / 1000), 0.05);
+  EXPECT_TRUE(k.P.isApprox(kc.P, 1e-9));
+}
+
+/**
+ * On a linear system, the sigma points are exact and the UKF is the Kalman filter
+ */
+TEST(KalmanTest, LinearTest) {
+  Eigen::Matrix3d A;
+  A << 0.9, 0.1, 0, 0, 0.8, 0.2, 0.05, 0, 0.7;
+  Eigen::Vector3d B(0, 0, 1);
+  Eigen::RowVector3d C(1, 0.5, 0);
+  auto f = [A, B](const auto &x, const auto &u) { return (A * x + B * u).eval(); };
+  auto h = [C](const auto &x) { return (C * x).eval(); };
+  auto L = nonlinear<double, 3>(f, h);
+  using S = decltype(L);
+
+  Eigen::Matrix3d Q = 0.01 * Eigen::Matrix3d::Identity();
+  Eigen::Matrix<double, 1, 1> R(0.1);
+  ekf<S> e(L, Q, R);
+  ukf<S> k(L, Q, R, S::Tx::Zero(), Eigen::Matrix3d::Identity(), 1.);
+
+  for (int i = 0; i < 50; i++) {
+    S::Tu u(std::cos(0.3 * i));
+    S::Ty z(std::sin(0.2 * i));
+    e.step(u, z);
+    k.step(u, z);
+    ASSERT_LT((e.x - k.x).norm(), 1e-10) << i;
+    ASSERT_LT((e.P - k.P).norm(), 1e-10) << i;
+  }
+
+  k.P(0, 0) = -1;
+  EXPECT_THROW(k.predict(S::Tu(0.)), std::domain_error);
+}
+
+}  // namespace
@@ -0,0 +1,68 @@
+#include "control/predictive/mpc.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+namespace {
+
+class MPCTest : public ::testing::Test {
+ public:
+  using ss = control::system::ss<double, 2>;
+  using mpc = control::predictive::MPC<double, 2, 1, 1, 30>;
+ protected:
+  ss P;
+  mpc C;
+
+  static ss plant() {
+    ss::TA A;
+    ss::TB B;
+    ss::TC C;
+    ss::TD D;
+    A << 1, 1, 0, 1;
+    B << 0.5, 1;
+    C << 1, 0;
+    D << 0;
+    return ss(A, B, C, D);
+  }
+
+  MPCTest() : P(plant()), C(P, mpc::TQ::Identity(), 10 * mpc::TR::Identity(),
+                            mpc::Tu::Constant(-0.2), mpc::Tu::Constant(0.2), 30, 200) {}
+};
+
+TEST_F(MPCTest, RespectsBoundsTest) {
+  mpc::Ty r;
+  r << 10;
+
+  for (int i = 0; i < 100; i++) {
+    auto u = C.step(P.x, r);
+    ASSERT_LE(u(0), 0.2 + 1e-9);
+    ASSERT_GE(u(0), -0.2 - 1e-9);
+    ASSERT_LE(C.stats().iterations, 200u);
+    P.step(u);
+  }
+
+  EXPECT_NEAR(P.y(0), 10, 1e-2);
+}
+
+TEST_F(MPCTest, SaturatesWhenFarTest) {
+  mpc::Ty r;
+  r << 10;
+
+  // Far from the reference, the first move is at the bound
+  auto u = C.step(P.x, r);
+  EXPECT_NEAR(u(0), 0.2, 1e-6);
+  EXPECT_TRUE(C.stats().converged);
+  EXPECT_GE(C.stats().time.count(), 0);
+}
+
+TEST_F(MPCTest, IterationCapTest) {
+  mpc F(P, mpc::TQ::Identity(), mpc::TR::Identity(),
+        mpc::Tu::Constant(-0.2), mpc::Tu::Constant(0.2), 30, 3);
+  mpc::Ty r;
+  r << 10;
+
+  F.step(P.x, r);
+  EXPECT_EQ(F.stats().iterations, 3u);
+  EXPECT_FALSE(F.stats().converged);
+}
+
+}  // namespace
@@ -0,0 +1,141 @@
+#include "control/filter/multirate.h"
+#include "control/filter/design.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+
+namespace {
+
+using namespace control::filter;
+
+std::vector<double> signal(size_t n) {
+  std::vector<double> x(n);
+  for (size_t i = 0; i < n; i++)
+    x[i] = std::sin(0.05 * i) + 0.5 * std::cos(1.3 * i) + (i % 17 == 0);
+  return x;
+}
+
+// Direct convolution, h[0] on the newest sample
+template<size_t N>
+std::vector<double> fir(const std::array<double, N> &h, const std::vector<double> &x) {
+  std::vector<double> y(x.size(), 0);
+  for (size_t n = 0; n < x.size(); n++)
+    for (size_t k = 0; k < N && k <= n; k++)
+      y[n] += h[k] * x[n - k];
+  return y;
+}
+
+TEST(DelayLineTest, WindowTest) {
+  DelayLine<int, 3> d;
+  for (int i = 1; i <= 5; i++)
+    d.push(i);
+  EXPECT_THAT(std::vector<int>(d.window(), d.window() + 3), ::testing::ElementsAre(3, 4, 5));
+}
+
+TEST(MultirateTest, FirDecimatorTest) {
+  std::array<double, 11> h{};
+  for (size_t k = 0; k < h.size(); k++)
+    h[k] = 1. / (1 + k);
+
+  auto x = signal(200);
+  auto ref = fir(h, x);
+
+  FirDecimator<double, 11, 4> d(h);
+  std::vector<double> y(x.size() / 4 + 1);
+  ASSERT_EQ(d.process(x.data(), x.size(), y.data()), 50u);
+  for (size_t m = 0; m < 50; m++)
+    EXPECT_NEAR(y[m], ref[4 * m + 3], 1e-12);
+}
+
+TEST(MultirateTest, FirInterpolatorTest) {
+  std::array<double, 10> h{};
+  for (size_t k = 0; k < h.size(); k++)
+    h[k] = 0.1 * k - 0.3;
+
+  auto x = signal(50);
+
+  // Zero-stuffed reference
+  std::vector<double> up(x.size() * 3, 0);
+  for (size_t i = 0; i < x.size(); i++)
+    up[3 * i] = x[i];
+  auto ref = fir(h, up);
+
+  FirInterpolator<double, 10, 3> p(h);
+  std::vector<double> y(up.size());
+  p.process(x.data(), x.size(), y.data());
+  for (size_t n = 0; n < y.size(); n++)
+    EXPECT_NEAR(y[n], ref[n], 1e-12);
+}
+
+TEST(MultirateTest, CICTest) {
+  CIC<int64_t, 4, 3> c;
+  EXPECT_EQ(c.gain(), 64);
+
+  // Reference: three moving sums of 4, then keep every 4th
+  std::vector<int64_t> x(64), r(64);
+  for (size_t i = 0; i < x.size(); i++)
+    x[i] = int64_t(i % 5) - 2;
+  r = x;
+  for (int s = 0; s < 3; s++) {
+    std::vector<int64_t> t(r.size(), 0);
+    for (size_t n = 0; n < r.size(); n++)
+      for (size_t k = 0; k < 4 && k <= n; k++)
+        t[n] += r[n - k];
+    r = t;
+  }
+
+  std::vector<int64_t> y(17);
+  ASSERT_EQ(c.process(x.data(), x.size(), y.data()), 16u);
+  for (size_t m = 0; m < 16; m++)
+    EXPECT_EQ(y[m], r[4 * m + 3]);
+}
+
+TEST(MultirateTest, IIRDecimatorTest) {
+  auto s = design::butter<4>(0.08);
+  auto full = design::cascade(s);
+  IIRDecimator<double, 2, 10> d(s);
+
+  auto x = signal(1000);
+  size_t m = 0;
+  for (size_t n = 0; n < x.size(); n++) {
+    double yf = full.step(x[n]), y;
+    if (d.push(x[n], y)) {
+      EXPECT_EQ(n % 10, 9u);
+      EXPECT_NEAR(y, yf, 1e-9);
+      m++;
+    }
+  }
+  EXPECT_EQ(m, 100u);
+}
+
+/**
+ * Decimators step as SISOs at the input rate, holding the latest output
+ */
+TEST(MultirateTest, SisoTest) {
+  std::array<double, 8> h{};
+  for (size_t k = 0; k < h.size(); k++)
+    h[k] = 0.125;
+  FirDecimator<double, 8, 4> a(h), ra(h);
+  IIRDecimator<double, 2, 10> b(design::butter<4>(0.08)), rb(design::butter<4>(0.08));
+  CIC<int, 4, 2> c, rc;
+
+  control::system::SISO<double> &sa = a, &sb = b;
+  control::system::SISO<int> &sc = c;
+  auto x = signal(200);
+  double ya = 0, yb = 0;
+  int yc = 0;
+  for (size_t n = 0; n < x.size(); n++) {
+    ra.push(x[n], ya);
+    rb.push(x[n], yb);
+    rc.push(int(n % 7), yc);
+    ASSERT_EQ(sa.step(x[n]), ya) << n;
+    ASSERT_EQ(sb.step(x[n]), yb) << n;
+    ASSERT_EQ(sc.step(int(n % 7)), yc) << n;
+  }
+
+  a.reset();
+  EXPECT_EQ(a.step(1.), 0.);
+}
+
+}  // namespace
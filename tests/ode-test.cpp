@@ -0,0 +1,178 @@
+#include "control/system/ode.h"
+#include "control/classic/pid.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using namespace control::system::ode;
+
+const double pi = std::acos(-1.);
+
+// x'' = -w^2 x, per column w = 1, 2, ...
+auto oscillator = [](double, const auto &x) {
+  auto dx = x.eval();
+  for (int k = 0; k < x.cols(); k++) {
+    dx(0, k) = x(1, k);
+    dx(1, k) = -(k + 1) * (k + 1) * x(0, k);
+  }
+  return dx;
+};
+
+TEST(OdeTest, Rk4Test) {
+  double e[2];
+  for (int i = 0; i < 2; i++) {
+    rk4<Eigen::Vector2d> I(0.02 / (i + 1));
+    Eigen::Vector2d x(1, 0);
+    double t = 0;
+    I.integrate(oscillator, t, x, 2 * pi);
+    EXPECT_EQ(t, 2 * pi);
+    e[i] = (x - Eigen::Vector2d(1, 0)).norm();
+  }
+  EXPECT_LT(e[0], 1e-6);
+  EXPECT_NEAR(e[0] / e[1], 16., 1.);
+}
+
+TEST(OdeTest, Dopri5Test) {
+  dopri5<Eigen::Vector2d> I(1e-9, 1e-12);
+  Eigen::Vector2d x(1, 0);
+  double t = 0;
+  I.integrate(oscillator, t, x, 10.);
+  EXPECT_EQ(t, 10.);
+  EXPECT_NEAR(x(0), std::cos(10.), 1e-8);
+  EXPECT_NEAR(x(1), -std::sin(10.), 1e-8);
+  EXPECT_GT(I.accepted, 0u);
+
+  // Dense output at instants inside the steps
+  dopri5<Eigen::Vector2d> D(1e-8, 1e-10);
+  x << 1, 0;
+  t = 0;
+  std::vector<double> ts;
+  D.sample(oscillator, t, x, 5., 0.01, [&](double ti, const Eigen::Vector2d &xi) {
+    ts.push_back(ti);
+    EXPECT_NEAR(xi(0), std::cos(ti), 1e-7) << ti;
+  });
+  ASSERT_EQ(ts.size(), 500u);
+  EXPECT_NEAR(ts[0], 0.01, 1e-15);
+  EXPECT_EQ(ts.back(), 5.);
+  EXPECT_LT(D.accepted, 100u);
+}
+
+/**
+ * A non-finite derivative fails instead of rejecting steps forever
+ */
+TEST(OdeTest, NonFiniteTest) {
+  auto nan = [](double t, const Eigen::Vector2d &x) {
+    Eigen::Vector2d dx = oscillator(t, x);
+    if (t > 1)
+      dx(1) = std::nan("");
+    return dx;
+  };
+
+  dopri5<Eigen::Vector2d> D;
+  Eigen::Vector2d x(1, 0);
+  double t = 0;
+  EXPECT_THROW(D.integrate(nan, t, x, 10.), std::domain_error);
+  EXPECT_GT(t, 0.5);
+  EXPECT_LE(t, 1.);
+
+  ros2<Eigen::Vector2d> R;
+  x << 1, 0;
+  t = 0;
+  EXPECT_THROW(R.integrate(nan, t, x, 10.), std::domain_error);
+  EXPECT_LE(t, 1.);
+}
+
+/**
+ * A stiff plant closely following a slow input
+ */
+TEST(OdeTest, StiffTest) {
+  auto f = [](double t, const auto &x) {
+    auto dx = x.eval();
+    dx(0) = -1e4 * (x(0) - std::cos(t));
+    return dx;
+  };
+  Eigen::Matrix<double, 1, 1> x0(1);
+
+  ros2<Eigen::Matrix<double, 1, 1>> R(1e-5, 1e-8);
+  auto x = x0;
+  double t = 0;
+  R.integrate(f, t, x, 2.);
+  EXPECT_NEAR(x(0), std::cos(2.) + 1e-4 * std::sin(2.), 1e-5);
+
+  dopri5<Eigen::Matrix<double, 1, 1>> D(1e-5, 1e-8);
+  x = x0;
+  t = 0;
+  D.integrate(f, t, x, 2.);
+  EXPECT_NEAR(x(0), std::cos(2.) + 1e-4 * std::sin(2.), 1e-5);
+
+  // The explicit method is bound by stability, not accuracy
+  EXPECT_LT(10 * R.accepted, D.accepted);
+}
+
+/**
+ * Instances in columns integrate together, each as accurately as on its own
+ */
+TEST(OdeTest, BatchedTest) {
+  using X = Eigen::Matrix<double, 2, 4>;
+  X x0;
+  x0 << 1, 1, 1, 1, 0, 0, 0, 0;
+
+  for (int m = 0; m < 3; m++) {
+    X x = x0;
+    double t = 0;
+    if (m == 0) {
+      rk4<X> I(0.001);
+      I.integrate(oscillator, t, x, 3.);
+    } else if (m == 1) {
+      dopri5<X> I(1e-9, 1e-12);
+      I.integrate(oscillator, t, x, 3.);
+    } else {
+      ros2<X> I(1e-6, 1e-9);
+      I.integrate(oscillator, t, x, 3.);
+    }
+    for (int k = 0; k < 4; k++)
+      EXPECT_NEAR(x(0, k), std::cos((k + 1) * 3.), m == 2 ? 1e-3 : 1e-7) << m << " " << k;
+  }
+
+  // Batched rk4 matches single instances exactly
+  rk4<X> I(0.01);
+  X x = x0;
+  double t = 0;
+  I.integrate(oscillator, t, x, 1.);
+  rk4<Eigen::Vector2d> S(0.01);
+  Eigen::Vector2d xs(1, 0);
+  t = 0;
+  S.integrate(oscillator, t, xs, 1.);
+  EXPECT_EQ(x(0, 0), xs(0));
+  EXPECT_EQ(x(1, 0), xs(1));
+}
+
+/**
+ * A PI controller on the continuous plant matches it on the exactly discretized plant
+ */
+TEST(OdeTest, ZohTest) {
+  const double Ts = 0.01, a = std::exp(-Ts);
+  auto f = [](double, const Eigen::Matrix<double, 1, 1> &x, double u) { return (-x.array() + u).matrix().eval(); };
+  zoh P(dopri5<Eigen::Matrix<double, 1, 1>>(1e-10, 1e-12), f, Ts);
+  zoh R(ros2<Eigen::Matrix<double, 1, 1>>(1e-8, 1e-10), f, Ts);
+
+  control::classic::PI<double> pi1(Ts, 2., 0.5), pi2(Ts, 2., 0.5), pi3(Ts, 2., 0.5);
+  double y = 0, yd = 0, yr = 0;
+  for (int k = 0; k < 500; k++) {
+    y = P.step(pi1.step(1. - y))(0);
+    yr = R.step(pi3.step(1. - yr))(0);
+    double u = pi2.step(1. - yd);
+    yd = a * yd + (1 - a) * u;
+    ASSERT_NEAR(y, yd, 1e-9) << k;
+    ASSERT_NEAR(yr, yd, 1e-5) << k;
+  }
+  EXPECT_NEAR(P.t, 5., 1e-12);
+  EXPECT_NEAR(y, 1., 1e-3);
+}
+
+}  // namespace
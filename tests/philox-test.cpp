@@ -0,0 +1,54 @@
+#include "control/ident/philox.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <vector>
+
+namespace {
+
+using control::ident::philox4x32;
+
+/**
+ * Known-answer vectors of Random123
+ */
+TEST(PhiloxTest, KnownAnswerTest) {
+  EXPECT_THAT(philox4x32::block({0, 0, 0, 0}, {0, 0}),
+              ::testing::ElementsAre(0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u));
+  EXPECT_THAT(philox4x32::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              ::testing::ElementsAre(0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu));
+  EXPECT_THAT(philox4x32::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+              ::testing::ElementsAre(0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u));
+
+  // Word n of stream s is word n % 4 of block (n / 4, s) under the seed
+  philox4x32 e(0x299f31d0a4093822ull, 0x0370734413198a2eull);
+  e.discard(4 * 0x243f6a88ull + 2);
+  auto r = philox4x32::block({0x243f6a88, 0, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+  EXPECT_EQ(e(), r[2]);
+  EXPECT_EQ(e(), r[3]);
+}
+
+TEST(PhiloxTest, StreamTest) {
+  philox4x32 a(42, 3), b(42, 3), c(42, 4);
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_NE(a(), c());
+  b();
+
+  // Bulk generation continues the sequence from any position
+  std::vector<uint32_t> w(1001);
+  a.generate(w.data(), w.size());
+  for (size_t i = 0; i < w.size(); i++)
+    ASSERT_EQ(w[i], b()) << i;
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.position(), 1002u);
+
+  // Jump ahead
+  philox4x32 d(42, 3);
+  d.discard(1000);
+  EXPECT_EQ(d(), w[999]);
+  EXPECT_EQ(d(), w[1000]);
+  d.seed(42, 3);
+  EXPECT_EQ(d, philox4x32(42, 3));
+}
+
+}  // namespace
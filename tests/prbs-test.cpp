@@ -2,6 +2,11 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
 namespace {
 
 class PRBSTest : public ::testing::Test {
@@ -26,5 +31,54 @@ TEST_F(PRBSFloatTest, SimplePRBSFloatTest) {
   EXPECT_THAT(r, ::testing::Each(::testing::AnyOf(-1.0,1.0)));
 }
 
+/**
+ * Channels are reproducible, independent of threads and mutually uncorrelated
+ */
+TEST(PRBSChannelTest, MultichannelTest) {
+  using namespace control::ident;
+  const size_t n = 100000, channels = 4;
+  std::vector<std::vector<float>> y(channels, std::vector<float>(n)), z = y;
+  std::vector<float *> yp, zp;
+  for (size_t c = 0; c < channels; c++) {
+    yp.push_back(y[c].data());
+    zp.push_back(z[c].data());
+  }
+  prbs(yp, n, 7, 1);
+  prbs(zp, n, 7, 3);
+  EXPECT_EQ(y, z);
+
+  for (size_t c = 0; c < channels; c++) {
+    PRBS<float> P(philox4x32(7, c));
+    for (size_t i = 0; i < n; i++)
+      ASSERT_EQ(P.get(), y[c][i]) << c << " " << i;
+
+    // Random access from any sample
+    std::vector<float> part(1000);
+    prbs(part.data(), part.size(), 7, c, 12345);
+    EXPECT_TRUE(std::equal(part.begin(), part.end(), y[c].begin() + 12345));
+
+    for (size_t d = 0; d <= c; d++) {
+      double r = 0;
+      for (size_t i = 0; i < n; i++)
+        r += double(y[c][i] * y[d][i]) / n;
+      EXPECT_NEAR(r, c == d ? 1. : 0., 0.02) << c << " " << d;
+    }
+  }
+}
+
+TEST(PRBSEngineTest, EngineTest) {
+  control::ident::PRBS<int, std::mt19937> M;
+  control::ident::PRBS<int, std::minstd_rand> S;
+  int m = 0, s = 0;
+  for (int i = 0; i < 10000; i++) {
+    int a = M.get(), b = S.get();
+    ASSERT_TRUE(a == 1 || a == -1);
+    ASSERT_TRUE(b == 1 || b == -1);
+    m += a;
+    s += b;
+  }
+  EXPECT_LT(std::abs(m), 400);
+  EXPECT_LT(std::abs(s), 400);
+}
 
 }  // namespace
@@ -0,0 +1,90 @@
+#include "control/filter/realization.h"
+#include "control/filter/design.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+
+namespace {
+
+using namespace control::filter;
+
+template<typename B>
+class RealizationTest : public ::testing::Test {};
+
+using Realizations = ::testing::Types<BiquadDF1<double>, BiquadCoupled<double>, BiquadSVF<double>>;
+TYPED_TEST_CASE(RealizationTest, Realizations);
+
+/**
+ * Same response as Direct form II transposed for complex and real poles
+ */
+TYPED_TEST(RealizationTest, EquivalenceTest) {
+  std::vector<sos<double>> cs = {
+      design::butter<2>(0.1)[0],
+      design::butter<2>(0.1, design::pass::high)[0],
+      design::notch(0.3, 2.),
+      {0.2, 0.3, -0.1, -0.9, 0.18},  // real poles 0.6, 0.3
+      {0.5, 0.5, 0, -0.5, 0},        // first-order
+  };
+
+  for (auto &c : cs) {
+    Biquad<double> ref(c);
+    TypeParam b(c);
+    for (int i = 0; i < 200; i++) {
+      double x = std::sin(0.37 * i) + (i % 7 == 0);
+      ASSERT_NEAR(b.step(x), ref.step(x), 1e-12);
+    }
+  }
+}
+
+TYPED_TEST(RealizationTest, ResetTest) {
+  TypeParam b(design::butter<2>(0.2)[0]);
+  double y0 = b.step(1);
+  b.step(1);
+  b.reset();
+  EXPECT_DOUBLE_EQ(b.step(1), y0);
+}
+
+/**
+ * Low cut-off in float: the coupled and state-variable forms track the double
+ * precision response far better than the transposed direct form
+ */
+TEST(RealizationFloatTest, LowCutoffTest) {
+  auto c = design::butter<2>(0.001)[0];
+  Biquad<double> ref(c);
+  Biquad<float> df2t(c);
+  BiquadCoupled<float> coupled(c);
+  BiquadSVF<float> svf(c);
+
+  double e_df2t = 0, e_coupled = 0, e_svf = 0;
+  for (int i = 0; i < 40000; i++) {
+    float x = (i / 5000) % 2 ? 1.f : -.3f;
+    double y = ref.step(x);
+    e_df2t = std::max(e_df2t, std::abs(df2t.step(x) - y));
+    e_coupled = std::max(e_coupled, std::abs(coupled.step(x) - y));
+    e_svf = std::max(e_svf, std::abs(svf.step(x) - y));
+  }
+
+  EXPECT_LT(e_coupled, 1e-4);
+  EXPECT_LT(e_svf, 1e-4);
+  EXPECT_GT(e_df2t, 100 * std::max(e_coupled, e_svf));
+}
+
+/**
+ * Realizations selected per section
+ */
+TEST(RealizationChainTest, MixedTest) {
+  auto s = design::butter<4>(0.05);
+  auto ref = design::cascade(s);
+  BiquadChain<BiquadCoupled<double>, BiquadSVF<double>> chain(s[0], s[1]);
+  auto svf = design::cascade<BiquadSVF<double>>(s);
+
+  for (int i = 0; i < 200; i++) {
+    double x = i % 20 < 10;
+    double y = ref.step(x);
+    ASSERT_NEAR(chain.step(x), y, 1e-12);
+    ASSERT_NEAR(svf.step(x), y, 1e-12);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,156 @@
+#include "control/system/reduce.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <complex>
+
+namespace {
+
+using namespace control::system;
+using reduce::MatrixX;
+using reduce::SparseX;
+using cd = std::complex<double>;
+
+struct model {
+  SparseX<double> A;
+  MatrixX<double> B, C, D;
+
+  cd response(cd z) const {
+    MatrixX<cd> M = z * MatrixX<cd>::Identity(A.rows(), A.cols()) - MatrixX<double>(A).cast<cd>();
+    return (C.cast<cd>() * M.partialPivLu().solve(B.cast<cd>()))(0) + D(0);
+  }
+};
+
+/**
+ * Damped chain of unit masses and springs, forward Euler at 10 kHz
+ *
+ * States are the positions and then the velocities; force on the last mass,
+ * output the position of the first.
+ */
+model chain(int masses, double k = 1e4, double Ts = 1e-4) {
+  const int n = 2 * masses;
+  const double alpha = 2., beta = 2 * Ts;
+  std::vector<Eigen::Triplet<double>> t;
+  for (int i = 0; i < n; i++)
+    t.emplace_back(i, i, 1.);
+  for (int i = 0; i < masses; i++) {
+    const int v = masses + i;
+    t.emplace_back(i, v, Ts);
+    t.emplace_back(v, v, -Ts * alpha);
+    for (int j : {i - 1, i, i + 1}) {
+      if (j < 0 || j >= masses)
+        continue;
+      double K = j == i ? 2 * k : -k;
+      t.emplace_back(v, j, -Ts * K);
+      t.emplace_back(v, masses + j, -Ts * beta * K);
+    }
+  }
+  model m{SparseX<double>(n, n), MatrixX<double>::Zero(n, 1), MatrixX<double>::Zero(1, n), MatrixX<double>::Zero(1, 1)};
+  m.A.setFromTriplets(t.begin(), t.end());
+  m.B(n - 1) = Ts;
+  m.C(0) = 1e4;
+  return m;
+}
+
+/**
+ * Heat conduction along a rod of n elements, forward Euler
+ *
+ * Heat flux into the first element, output the temperature a third along.
+ */
+model rod(int n) {
+  const double r = 0.25;   // Ts kappa / dx^2
+  std::vector<Eigen::Triplet<double>> t;
+  for (int i = 0; i < n; i++) {
+    t.emplace_back(i, i, 1 - 2 * r);
+    if (i > 0)
+      t.emplace_back(i, i - 1, r);
+    if (i + 1 < n)
+      t.emplace_back(i, i + 1, r);
+  }
+  model m{SparseX<double>(n, n), MatrixX<double>::Zero(n, 1), MatrixX<double>::Zero(1, n), MatrixX<double>::Zero(1, 1)};
+  m.A.setFromTriplets(t.begin(), t.end());
+  m.B(0) = r;
+  m.C(n / 3) = 1;
+  return m;
+}
+
+template<size_t Nr>
+cd response(const ss<double, Nr> &P, cd z) {
+  Eigen::Matrix<cd, Nr, Nr> M = z * Eigen::Matrix<cd, Nr, Nr>::Identity() - P.getA().template cast<cd>();
+  return (P.getC().template cast<cd>() * M.partialPivLu().solve(P.getB().template cast<cd>()))(0) + P.getD()(0);
+}
+
+// Largest error over frequencies up to Nyquist
+template<size_t Nr>
+double error(const model &c, const reduction<double, Nr, 1, 1> &r) {
+  double e = 0;
+  for (int i = 0; i <= 150; i++) {
+    cd z = std::polar(1., std::acos(-1.) * std::pow(10., -4. + 4. * i / 150));
+    e = std::max(e, std::abs(c.response(z) - response(r.model, z)));
+  }
+  return e;
+}
+
+TEST(ReduceTest, SteinTest) {
+  MatrixX<double> A(3, 3), B(3, 1);
+  A << 0.9, 0.2, 0, -0.1, 0.8, 0.1, 0, 0, 0.5;
+  B << 1, 0, 2;
+  auto P = reduce::stein<double>(A, B * B.transpose());
+  EXPECT_LT((P - A * P * A.transpose() - B * B.transpose()).norm(), 1e-12 * P.norm());
+
+  auto Z = reduce::factor(P);
+  EXPECT_LT((Z * Z.transpose() - P).norm(), 1e-12 * P.norm());
+
+  A(0, 0) = 1.2;
+  EXPECT_THROW(reduce::stein<double>(A, B * B.transpose()), std::domain_error);
+}
+
+TEST(ReduceTest, DenseTest) {
+  auto c = chain(30);
+  MatrixX<double> A(c.A);
+  auto r = truncate<6>(A, c.B, c.C, c.D);
+
+  ASSERT_EQ(r.hsv.size(), 60u);
+  EXPECT_TRUE(std::is_sorted(r.hsv.rbegin(), r.hsv.rend()));
+  EXPECT_LT(r.model.getA().eigenvalues().cwiseAbs().maxCoeff(), 1.);
+
+  // sigma_(r+1) <= ||G - Gr|| <= 2 sum sigma_(i>r)
+  double e = error(c, r);
+  EXPECT_LE(e, r.bound * (1 + 1e-6));
+  EXPECT_GE(e, 0.5 * r.hsv[6]);
+  EXPECT_NEAR(std::abs(c.response(1.) - response(r.model, cd(1.))), 0., r.bound);
+
+  // From a fixed-size state-space
+  using P4 = ss<double, 4>;
+  P4::TA A4;
+  P4::TB B4;
+  P4::TC C4;
+  P4::TD D4;
+  A4 << 0.9, 0.1, 0, 0, -0.1, 0.9, 0, 0, 0, 0, 0.5, 0.2, 0, 0, 0, 0.1;
+  B4 << 1, 0, 1, 1;
+  C4 << 1, 0, 0.1, 0.01;
+  D4 << 0.5;
+  auto r2 = truncate<2>(P4(A4, B4, C4, D4));
+  EXPECT_EQ(r2.hsv.size(), 4u);
+  EXPECT_EQ(r2.model.getD()(0), 0.5);
+}
+
+/**
+ * Low-rank Gramians of the sparse model agree with the dense ones
+ */
+TEST(ReduceTest, SparseTest) {
+  auto c = rod(200);
+  auto r = truncate<8>(c.A, c.B, c.C, c.D);
+  auto d = truncate<8>(MatrixX<double>(c.A), c.B, c.C, c.D);
+
+  for (size_t i = 0; i < 8; i++)
+    EXPECT_NEAR(r.hsv[i], d.hsv[i], 1e-6 * d.hsv[0]) << i;
+  EXPECT_NEAR(r.bound, d.bound, 1e-6 * d.hsv[0]);
+
+  double e = error(c, r);
+  EXPECT_LE(e, r.bound * (1 + 1e-3));
+  EXPECT_GE(e, 0.5 * d.hsv[8]);
+}
+
+}  // namespace
@@ -0,0 +1,154 @@
+#include "control/system/replay.h"
+#include "control/classic/pid.h"
+#include "control/filter/design.h"
+#include "control/filter/multirate.h"
+#include "control/system/ss.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+using namespace control::system;
+
+std::string temp(const std::string &name) {
+  const char *dir = std::getenv("TMPDIR");
+  return std::string(dir ? dir : "/tmp") + "/control-replay-" + name;
+}
+
+ColumnFile<float> recording(const std::string &path, size_t n) {
+  auto f = ColumnFile<float>::create(path, 2, n);
+  float *r = f.column(0), *d = f.column(1);
+  for (size_t i = 0; i < n; i++) {
+    r[i] = float(i / 500 % 2);
+    d[i] = 0.1f * std::sin(0.3f * i);
+  }
+  return f;
+}
+
+TEST(ReplayTest, ColumnFileTest) {
+  auto path = temp("columns");
+  {
+    auto f = recording(path, 1000);
+    EXPECT_TRUE(f.writable());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(f.column(1)) % 64, 0u);
+  }
+
+  auto f = ColumnFile<float>::open(path);
+  EXPECT_FALSE(f.writable());
+  EXPECT_EQ(f.columns(), 2u);
+  EXPECT_EQ(f.rows(), 1000u);
+  EXPECT_EQ(f.column(0)[500], 1.f);
+  EXPECT_FLOAT_EQ(f.column(1)[10], 0.1f * std::sin(3.f));
+
+  EXPECT_THROW(ColumnFile<double>::open(path), std::runtime_error);
+  EXPECT_THROW(ColumnFile<float>::open(temp("missing")), std::system_error);
+  std::remove(path.c_str());
+}
+
+TEST(ReplayTest, MalformedTest) {
+  auto path = temp("malformed");
+  // Header fields: columns at byte 16, rows at byte 24
+  auto corrupt = [&path](uint64_t cols, uint64_t rows) {
+    auto f = ColumnFile<float>::create(path, 2, 16);
+    auto p = static_cast<char *>(f.mapping().data());
+    std::memcpy(p + 16, &cols, 8);
+    std::memcpy(p + 24, &rows, 8);
+  };
+
+  corrupt(2, 16);
+  EXPECT_NO_THROW(ColumnFile<float>::open(path));
+  corrupt(3, 16);
+  EXPECT_THROW(ColumnFile<float>::open(path), std::runtime_error);
+  // cols times the 64-byte stride wraps to zero
+  corrupt(uint64_t(1) << 58, 1);
+  EXPECT_THROW(ColumnFile<float>::open(path), std::runtime_error);
+  // The stride of the rows wraps
+  corrupt(1, ~uint64_t(0) / 4);
+  EXPECT_THROW(ColumnFile<float>::open(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+/**
+ * Candidates replayed in parallel into a mapped file equal serial stepping
+ */
+TEST(ReplayTest, CandidatesTest) {
+  const size_t n = 100000;
+  auto in = recording(temp("input"), n);
+
+  std::vector<control::classic::PI<float>> cs;
+  for (int k = 0; k < 7; k++)
+    cs.emplace_back(1e-3f, 0.5f + 0.25f * k, 2.f, 5.f);
+  auto ref = cs;
+
+  auto out = ColumnFile<float>::create(temp("output"), cs.size(), n);
+  auto produced = replay(in.column(0), n, cs, out, 1000, 3);
+  EXPECT_THAT(produced, ::testing::Each(n));
+
+  for (size_t k = 0; k < ref.size(); k++)
+    for (size_t i = 0; i < n; i++)
+      ASSERT_EQ(out.column(k)[i], ref[k].step(in.column(0)[i])) << k << " " << i;
+
+  std::remove(temp("input").c_str());
+  std::remove(temp("output").c_str());
+}
+
+/**
+ * Sinks reduce outputs to a score per candidate without storing them
+ */
+TEST(ReplayTest, SinkTest) {
+  std::vector<double> x(10000);
+  for (size_t i = 0; i < x.size(); i++)
+    x[i] = std::sin(0.001 * i) + std::sin(2. * i);
+
+  // Low-pass candidates, scored by the energy left of the 2 rad/sample tone
+  std::vector<control::filter::BiquadCascade<control::filter::Biquad<double>, 2>> cs;
+  for (double w : {0.05, 0.1, 0.2, 0.4})
+    cs.push_back(control::filter::design::cascade(control::filter::design::butter<4>(w)));
+
+  std::vector<double> score(cs.size(), 0);
+  replay(x.data(), x.size(), cs, [&](size_t k, const double *y, size_t m) {
+    for (size_t i = 0; i < m; i++)
+      score[k] += y[i] * y[i];
+  }, 256, 2);
+
+  EXPECT_LT(score[0], score[1]);
+  EXPECT_LT(score[1], score[2]);
+  EXPECT_LT(score[2], score[3]);
+}
+
+TEST(ReplayTest, ComponentsTest) {
+  using ss = control::system::ss<double, 1>;
+  ss::TA A;
+  ss::TB B;
+  ss::TC C;
+  ss::TD D;
+  A << 0.5;
+  B << 1;
+  C << 1;
+  D << 0;
+
+  std::vector<double> x(100, 1.);
+  std::vector<ss> plants{ss(A, B, C, D)};
+  double last = 0;
+  replay(x.data(), x.size(), plants, [&](size_t, const double *y, size_t m) { last = y[m - 1]; });
+  EXPECT_NEAR(last, 2., 1e-12);
+
+  // Decimators produce fewer outputs
+  std::array<double, 2> h{0.5, 0.5};
+  std::vector<control::filter::FirDecimator<double, 2, 4>> ds(2, control::filter::FirDecimator<double, 2, 4>(h));
+  size_t outputs = 0;
+  std::mutex m;
+  replay(x.data(), x.size(), ds, [&](size_t, const double *, size_t k) {
+    std::lock_guard<std::mutex> lock(m);
+    outputs += k;
+  }, 30);
+  EXPECT_EQ(outputs, 50u);
+}
+
+}  // namespace
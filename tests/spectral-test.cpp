@@ -0,0 +1,171 @@
+#include "control/ident/spectral.h"
+#include "control/ident/idsignal.h"
+#include "control/filter/biquad.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace control::ident;
+using C = std::complex<double>;
+
+const double pi = std::acos(-1.);
+
+TEST(SpectralTest, DensityTest) {
+  const double fs = 100, sigma = 2;
+  std::mt19937 gen(1);
+  std::normal_distribution<double> d(0, sigma);
+  std::vector<double> u(1 << 16), y(u.size());
+  for (size_t i = 0; i < u.size(); i++) {
+    u[i] = d(gen);
+    y[i] = std::sin(2 * pi * 12.5 * double(i) / fs);   // on bin 32
+  }
+
+  auto W = std::make_unique<Welch<double, 256>>(fs);
+  W->process(u.data(), y.data(), u.size());
+  auto s = W->result();
+  EXPECT_EQ(s.segments, 511u);
+  ASSERT_EQ(s.f.size(), 129u);
+  EXPECT_DOUBLE_EQ(s.f[32], 12.5);
+
+  // White noise: flat at 2 sigma^2 / fs
+  double mean = 0;
+  for (size_t k = 1; k < 128; k++)
+    mean += s.Puu[k] / 127;
+  EXPECT_NEAR(mean, 2 * sigma * sigma / fs, 0.02 * 2 * sigma * sigma / fs);
+
+  // Sine: power A^2 / 2
+  double power = 0;
+  for (auto p : s.Pyy)
+    power += p * fs / 256;
+  EXPECT_NEAR(power, 0.5, 1e-6);
+  EXPECT_GT(s.Pyy[32], 1e3 * s.Pyy[40]);
+}
+
+/**
+ * Transfer function of a resonant biquad identified from a PRBS experiment
+ */
+TEST(SpectralTest, TransferTest) {
+  const double b0 = 0.02, b1 = 0.04, b2 = 0.02, a1 = -1.7, a2 = 0.8;
+  control::filter::Biquad<double> G(b0, b1, b2, a1, a2);
+  PRBS<double> prbs;
+  std::mt19937 gen(2);
+  std::normal_distribution<double> noise(0, 0.05);
+
+  std::vector<double> u(1 << 17), y(u.size()), yn(u.size());
+  for (size_t i = 0; i < u.size(); i++) {
+    u[i] = prbs.get();
+    y[i] = G.step(u[i]);
+    yn[i] = y[i] + noise(gen);
+  }
+
+  auto s = welch<1024>(u.data(), {y.data(), yn.data()}, u.size());
+  ASSERT_EQ(s.size(), 2u);
+  auto h = s[0].h1(), hn = s[1].h1(), h2n = s[1].h2();
+  auto c = s[0].coherence(), cn = s[1].coherence();
+
+  double ratio = 0;
+  for (size_t k = 1; k < 200; k++) {
+    C z = std::polar(1., 2 * pi * s[0].f[k]);
+    C g = (b0 * z * z + b1 * z + b2) / (z * z + a1 * z + a2);
+    EXPECT_NEAR(std::abs(h[k] - g), 0., 0.01 * std::abs(g)) << k;
+    if (k < 100) {
+      EXPECT_NEAR(std::abs(hn[k] - g), 0., 0.05 * std::abs(g)) << k;
+    }
+    EXPECT_GT(c[k], 0.995) << k;
+    EXPECT_LT(cn[k], c[k]) << k;
+    ratio += std::abs(h2n[k]) / std::abs(hn[k]) / 199;
+  }
+  // Output noise biases H2 upwards, by 1 / coherence
+  EXPECT_GT(ratio, 1.);
+}
+
+/**
+ * Streaming, batched and threaded estimates agree
+ */
+TEST(SpectralTest, ThreadedTest) {
+  std::mt19937 gen(3);
+  std::normal_distribution<double> d(0, 1);
+  const size_t n = 20000, channels = 5;
+  std::vector<double> u(n);
+  std::vector<std::vector<double>> y(channels, std::vector<double>(n));
+  std::vector<const double *> yp;
+  for (size_t i = 0; i < n; i++)
+    u[i] = d(gen);
+  for (size_t c = 0; c < channels; c++) {
+    for (size_t i = 0; i < n; i++)
+      y[c][i] = 0.5 * u[i] + (i > c ? u[i - c - 1] : 0) + 0.1 * d(gen);
+    yp.push_back(y[c].data());
+  }
+
+  auto one = welch<128>(u.data(), yp, n, 10., 32, 1);
+  auto many = welch<128>(u.data(), yp, n, 10., 32, 3);
+  auto few = welch<128>(u.data(), yp, 300, 10., 32, 8);   // 6 segments over 8 threads
+  ASSERT_EQ(one[0].segments, 622u);
+  ASSERT_EQ(few[0].segments, 6u);
+
+  for (size_t c = 0; c < channels; c++) {
+    Welch<double, 128> W(10., 32);
+    std::uniform_int_distribution<size_t> chunk(1, 300);
+    for (size_t i = 0; i < n;) {
+      size_t m = std::min(n - i, chunk(gen));
+      if (m == 1)
+        W.push(u[i], y[c][i]);
+      else
+        W.process(u.data() + i, y[c].data() + i, m);
+      i += m;
+    }
+    auto s = W.result();
+    ASSERT_EQ(s.segments, one[c].segments);
+    auto f = welch<128>(u.data(), {yp[c]}, 300, 10., 32, 1);
+
+    for (size_t k = 0; k < 65; k++) {
+      EXPECT_NEAR(s.Puu[k], one[c].Puu[k], 1e-12 * one[c].Puu[k]);
+      EXPECT_NEAR(s.Pyy[k], one[c].Pyy[k], 1e-12 * one[c].Pyy[k]);
+      EXPECT_NEAR(std::abs(s.Puy[k] - one[c].Puy[k]), 0., 1e-12 * std::abs(one[c].Puy[k]));
+      EXPECT_NEAR(many[c].Pyy[k], one[c].Pyy[k], 1e-12 * one[c].Pyy[k]);
+      EXPECT_NEAR(std::abs(many[c].Puy[k] - one[c].Puy[k]), 0., 1e-12 * std::abs(one[c].Puy[k]));
+      EXPECT_NEAR(few[c].Pyy[k], f[0].Pyy[k], 1e-12 * f[0].Pyy[k]);
+      EXPECT_NEAR(std::abs(few[c].Puy[k] - f[0].Puy[k]), 0., 1e-12 * std::abs(f[0].Puy[k]));
+    }
+  }
+}
+
+/**
+ * More threads than segments with a channel count that does not divide evenly
+ */
+TEST(SpectralTest, UnevenSplitTest) {
+  std::mt19937 gen(4);
+  std::normal_distribution<double> d(0, 1);
+  const size_t channels = 5;
+  std::vector<double> u(128);
+  std::vector<std::vector<double>> y(channels, std::vector<double>(128));
+  std::vector<const double *> yp;
+  for (auto &v : u)
+    v = d(gen);
+  for (auto &c : y) {
+    for (auto &v : c)
+      v = d(gen);
+    yp.push_back(c.data());
+  }
+
+  for (unsigned threads : {2u, 3u, 4u, 7u}) {
+    auto s = welch<128>(u.data(), yp, 128, 1., 64, threads);
+    ASSERT_EQ(s.size(), channels);
+    for (size_t c = 0; c < channels; c++) {
+      auto f = welch<128>(u.data(), {yp[c]}, 128, 1., 64, 1);
+      ASSERT_EQ(s[c].segments, 1u);
+      for (size_t k = 0; k < 65; k++) {
+        EXPECT_NEAR(s[c].Puu[k], f[0].Puu[k], 1e-12 * f[0].Puu[k]);
+        EXPECT_NEAR(s[c].Pyy[k], f[0].Pyy[k], 1e-12 * f[0].Pyy[k]);
+        EXPECT_NEAR(std::abs(s[c].Puy[k] - f[0].Puy[k]), 0., 1e-12 * std::abs(f[0].Puy[k]));
+      }
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,92 @@
+#include "control/system/ssbank.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <vector>
+
+namespace {
+
+using namespace control::system;
+
+using P = ss<double, 3, 2, 2>;
+
+P plant() {
+  P::TA A;
+  P::TB B;
+  P::TC C;
+  P::TD D;
+  A << 0.9, 0.1, 0, -0.2, 0.8, 0.1, 0, 0.3, 0.5;
+  B << 1, 0, 0, 0.5, 0.2, 0.1;
+  C << 1, 0, 1, 0, 1, -1;
+  D << 0, 0.1, 0, 0;
+  return P(A, B, C, D);
+}
+
+/**
+ * Every stream of a bank follows its own ss, including a partial last tile
+ */
+TEST(SsBankTest, StreamsTest) {
+  const size_t K = 2 * ssbank<double, 3, 2, 2>::tile + 5, n = 50;
+  P p = plant();
+  p.x << 1, -1, 0.5;
+  std::vector<P> each(K, p);
+  ssbank<double, 3, 2, 2> bank(p, K), stepped(p, K);
+  EXPECT_EQ(bank.streams(), K);
+  EXPECT_EQ(bank.x.col(K - 1), p.x);
+
+  // Frame t: input i of stream k at (2 t + i) K + k
+  std::vector<double> u(2 * K * n), y(2 * K * n);
+  for (size_t i = 0; i < u.size(); i++)
+    u[i] = double((i * 7919) % 23) / 11 - 1;
+  bank.process(u.data(), n, y.data());
+
+  for (size_t t = 0; t < n; t++) {
+    ssbank<double, 3, 2, 2>::TU U = Eigen::Map<ssbank<double, 3, 2, 2>::TU>(&u[2 * K * t], 2, K);
+    auto Y = stepped.step(U);
+    for (size_t k = 0; k < K; k++) {
+      auto r = each[k].step(P::Tu(u[2 * K * t + k], u[2 * K * t + K + k]));
+      for (size_t i = 0; i < 2; i++) {
+        ASSERT_NEAR(y[(2 * t + i) * K + k], r(i), 1e-12) << t << " " << k;
+        ASSERT_EQ(Y(i, k), y[(2 * t + i) * K + k]);
+      }
+    }
+  }
+  for (size_t k = 0; k < K; k++)
+    EXPECT_NEAR((bank.x.col(k) - each[k].x).norm(), 0., 1e-12);
+  EXPECT_EQ(bank.y, stepped.y);
+  EXPECT_EQ(bank.x, stepped.x);
+}
+
+/**
+ * In-place processing of frames and reset
+ */
+TEST(SsBankTest, InPlaceTest) {
+  ss<float, 2>::TA A;
+  ss<float, 2>::TB B;
+  ss<float, 2>::TC C;
+  ss<float, 2>::TD D;
+  A << 1, 1, 0, 1;
+  B << 0.5, 1;
+  C << 1, 0;
+  D << 0;
+  ss<float, 2> p(A, B, C, D);
+
+  // Stream k is driven by k + 1, a double integrator: y = (k + 1) t^2 / 2
+  const size_t K = 3, n = 9;
+  ssbank<float, 2> bank(p, K);
+  std::vector<float> v(K * n);
+  for (size_t t = 0; t < n; t++)
+    for (size_t k = 0; k < K; k++)
+      v[t * K + k] = float(k + 1);
+  bank.process(v.data(), n, v.data());
+  for (size_t t = 0; t < n; t++)
+    for (size_t k = 0; k < K; k++)
+      EXPECT_FLOAT_EQ(v[t * K + k], float(k + 1) * float((t + 1) * (t + 1)) / 2);
+  EXPECT_FLOAT_EQ(bank.y(0, 2), 3 * 81.f / 2);
+
+  bank.reset();
+  EXPECT_EQ(bank.x.norm(), 0.f);
+  EXPECT_EQ(bank.y.norm(), 0.f);
+}
+
+}  // namespace
@@ -0,0 +1,127 @@
+#include "control/system/stability.h"
+#include "control/classic/pid.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace control::system;
+using control::filter::sos;
+
+/**
+ * Closed-form margins match the poles, for complex and real pairs
+ */
+TEST(StabilityTest, BiquadTest) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> d(-2.5, 2.5);
+  std::vector<sos<double>> s(5000);
+  for (auto &c : s) {
+    c = {1, 0, 0, d(gen), d(gen) / 2};
+    control::filter::Biquad<double> b(c);
+    auto p = b.poles();
+    const double r = std::max(std::abs(p.first), std::abs(p.second));
+    ASSERT_NEAR(radius(c), r, 1e-9) << c.a1 << " " << c.a2;
+    ASSERT_EQ(b.stable(), r <= 1 + 1e-12) << c.a1 << " " << c.a2;
+    if (std::abs(r - 1) > 1e-12)
+      ASSERT_EQ(asymptotically_stable(c), r < 1) << c.a1 << " " << c.a2;
+  }
+
+  // Batched, on any number of threads
+  auto m1 = margins(s, 1), m3 = margins(s, 3);
+  ASSERT_EQ(m1.size(), s.size());
+  for (size_t i = 0; i < s.size(); i++) {
+    ASSERT_DOUBLE_EQ(m1[i], margin(s[i]));
+    ASSERT_EQ(m1[i], m3[i]);
+  }
+
+  // Edges of the stability triangle are marginally stable
+  EXPECT_TRUE(control::filter::Biquad<double>(1, 0, 0, 2, 1).stable());     // double pole at -1
+  EXPECT_TRUE(control::filter::Biquad<double>(1, 0, 0, 0, -1).stable());    // poles at 1 and -1
+  EXPECT_FALSE(control::filter::Biquad<double>(1, 0, 0, 0.5, -1).stable());
+  EXPECT_FALSE(asymptotically_stable(sos<double>{1, 0, 0, 2, 1}));
+  EXPECT_FALSE(asymptotically_stable(sos<double>{1, 0, 0, 0, -1}));
+  EXPECT_TRUE(asymptotically_stable(sos<double>{1, 0, 0, -1, 0.25}));
+  EXPECT_DOUBLE_EQ(margin(sos<double>{1, 0, 0, 0, -1}), 0.);
+  EXPECT_DOUBLE_EQ(margin(sos<double>{1, 0, 0, -1, 0.25}), 0.5);            // double pole at 0.5
+
+  // A PID integrates: margin zero
+  control::classic::PID<double> pid(0.01, 2, 0.5, 0.1, 10);
+  EXPECT_NEAR(margin(pid.coefficients()), 0., 1e-12);
+}
+
+TEST(StabilityTest, BankTest) {
+  control::filter::BiquadBank<float> bank(3, 2);
+  bank.section(0, 1, {1, 0, 0, -1.3f, 0.4f});    // 0.8, 0.5
+  bank.section(1, 0, {1, 0, 0, 0, 1.21f});       // +-1.1 j
+  auto m = margins(bank, 2);
+  ASSERT_EQ(m.size(), 3u);
+  EXPECT_NEAR(m[0], 0.2f, 1e-6);
+  EXPECT_NEAR(m[1], -0.1f, 1e-6);
+  EXPECT_EQ(m[2], 1.f);
+}
+
+TEST(StabilityTest, StateSpaceTest) {
+  using P = ss<double, 2>;
+  P::TB B = P::TB::Ones();
+  P::TC C = P::TC::Ones();
+  P::TD D = P::TD::Zero();
+  auto plant = [&](double a, double b, double c, double d) {
+    P::TA A;
+    A << a, b, c, d;
+    return P(A, B, C, D);
+  };
+
+  // Norm below one
+  EXPECT_TRUE(asymptotically_stable(plant(0.5, 0.2, -0.3, 0.1)));
+  // Large norm, stable: needs the eigenvalues
+  EXPECT_TRUE(asymptotically_stable(plant(0.5, 10, 0, 0.5)));
+  EXPECT_DOUBLE_EQ(margin(plant(0.5, 10, 0, 0.5)), 0.5);
+  // Trace and determinant small, one pole outside
+  EXPECT_FALSE(asymptotically_stable(plant(1.2, 0, 0, 0.5)));
+  EXPECT_NEAR(margin(plant(1.2, 0, 0, 0.5)), -0.2, 1e-12);
+  // Determinant large
+  EXPECT_FALSE(asymptotically_stable(plant(0, 2, 0.6, 0)));
+  // Rotation on the unit circle
+  EXPECT_FALSE(asymptotically_stable(plant(std::cos(1.), -std::sin(1.), std::sin(1.), std::cos(1.))));
+  EXPECT_NEAR(margin(plant(std::cos(1.), -std::sin(1.), std::sin(1.), std::cos(1.))), 0., 1e-12);
+
+  std::mt19937 gen(2);
+  std::normal_distribution<double> d(0, 0.6);
+  std::vector<ss<double, 5>> many;
+  for (int i = 0; i < 2000; i++) {
+    ss<double, 5>::TA A = ss<double, 5>::TA::NullaryExpr([&]() { return d(gen); });
+    many.emplace_back(A, ss<double, 5>::TB::Ones(), ss<double, 5>::TC::Ones(), ss<double, 5>::TD::Zero());
+  }
+  auto m = margins(many, 3);
+  int n = 0;
+  for (size_t i = 0; i < many.size(); i++) {
+    auto ev = many[i].getA().eigenvalues();
+    ASSERT_NEAR(m[i], 1 - ev.cwiseAbs().maxCoeff(), 1e-12);
+    ASSERT_EQ(asymptotically_stable(many[i]), m[i] > 0) << i;
+    n += m[i] > 0;
+  }
+  // Both outcomes are exercised
+  EXPECT_GT(n, 100);
+  EXPECT_LT(n, 1900);
+}
+
+/**
+ * An integrator is marginally stable as a biquad and as a state-space alike
+ */
+TEST(StabilityTest, MarginalTest) {
+  const sos<double> s{1, 0, 0, -1, 0};   // pole at 1, e.g. a PI controller
+  EXPECT_TRUE(control::filter::Biquad<double>(s).stable());
+  EXPECT_FALSE(asymptotically_stable(s));
+  EXPECT_DOUBLE_EQ(margin(s), 0.);
+
+  using P = ss<double, 1>;
+  P I(P::TA::Ones(), P::TB::Ones(), P::TC::Ones(), P::TD::Zero());
+  EXPECT_FALSE(asymptotically_stable(I));
+  EXPECT_DOUBLE_EQ(margin(I), 0.);
+}
+
+}  // namespace
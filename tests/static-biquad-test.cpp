@@ -0,0 +1,63 @@
+#include "control/filter/biquad.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+namespace {
+
+using control::filter::sos;
+
+struct full { static constexpr sos<double> value{1, 2, 3, 1, 2}; };
+struct unity { static constexpr sos<double> value{1, 0, 0, 0, 0}; };
+struct notch { static constexpr sos<double> value{1, 0, 1, 0, 0.5}; };
+struct integrator { static constexpr sos<double> value{0.5, 0.5, 0, -1, 0}; };
+
+template<typename C>
+using SB = control::filter::StaticBiquad<double, C>;
+
+/**
+ * Same outputs as the run-time biquad of biquad-test
+ */
+TEST(StaticBiquadTest, SimpleTest) {
+  SB<full> b;
+  std::vector<double> v = { 0, 1, 3, 5, 5 };
+  for( int i = 0; i < 5; i++ )
+    EXPECT_DOUBLE_EQ( b.step(i), v[i] );
+  EXPECT_FALSE(b.stable());
+}
+
+TEST(StaticBiquadTest, EquivalenceTest) {
+  SB<notch> sn;
+  SB<integrator> si;
+  control::filter::Biquad<double> bn(notch::value), bi(integrator::value);
+
+  for( int i = 0; i < 20; i++ ) {
+    double x = (i % 3) - 0.5 * (i % 4);
+    EXPECT_DOUBLE_EQ( sn.step(x), bn.step(x) );
+    EXPECT_DOUBLE_EQ( si.step(x), bi.step(x) );
+  }
+
+  EXPECT_EQ(sn.poles(), bn.poles());
+}
+
+/**
+ * Cascade from biquad-cascade-test with a static pass-through section
+ */
+TEST(StaticBiquadTest, ChainTest) {
+  using B = control::filter::Biquad<double>;
+  control::filter::BiquadChain<B, SB<unity>> bc(B(1,2,3,4,5), SB<unity>());
+
+  std::vector<double> v = { 0, 1, 0, 5, -4 };
+  for( int i = 0; i < 5; i++ )
+    EXPECT_DOUBLE_EQ( bc.step(i), v[i] );
+}
+
+TEST(StaticBiquadTest, CascadeTest) {
+  control::filter::BiquadCascade<SB<integrator>, 2> bc;
+
+  // Double integration of a unit step
+  std::vector<double> v = { 0.25, 1.25, 3.25, 6.25 };
+  for( int i = 0; i < 4; i++ )
+    EXPECT_DOUBLE_EQ( bc.step(1), v[i] );
+}
+
+}  // namespace
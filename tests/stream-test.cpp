@@ -0,0 +1,157 @@
+#include "control/system/stream.h"
+#include "control/filter/design.h"
+#include "control/filter/multirate.h"
+#include "control/classic/pid.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace control::system;
+
+TEST(StreamTest, RingTest) {
+  SpscRing<int, 4> r;
+  EXPECT_EQ(r.capacity(), 4u);
+
+  int x[6] = {1, 2, 3, 4, 5, 6}, y[6];
+  EXPECT_EQ(r.push(x, 6), 4u);
+  EXPECT_FALSE(r.push(7));
+  EXPECT_EQ(r.size(), 4u);
+
+  EXPECT_EQ(r.pop(y, 3), 3u);
+  EXPECT_THAT(std::vector<int>(y, y + 3), ::testing::ElementsAre(1, 2, 3));
+
+  // Wraps around
+  EXPECT_EQ(r.push(x + 4, 2), 2u);
+  EXPECT_EQ(r.pop(y, 6), 3u);
+  EXPECT_THAT(std::vector<int>(y, y + 3), ::testing::ElementsAre(4, 5, 6));
+
+  int z;
+  EXPECT_FALSE(r.pop(z));
+}
+
+TEST(StreamTest, FrameTest) {
+  using frame = std::array<float, 8>;
+  SpscRing<frame, 2> r;
+  frame a, b;
+  a.fill(1.5f);
+  EXPECT_TRUE(r.push(a));
+  EXPECT_TRUE(r.pop(b));
+  EXPECT_EQ(a, b);
+}
+
+/**
+ * A producer and a consumer thread see every element exactly once, in order
+ */
+TEST(StreamTest, ThreadedRingTest) {
+  auto r = std::make_unique<SpscRing<uint32_t, 256>>();
+  const uint32_t n = 1000000;
+
+  std::thread producer([&r] {
+    uint32_t batch[7];
+    for (uint32_t i = 0; i < n;) {
+      uint32_t m = std::min<uint32_t>(7, n - i);
+      for (uint32_t j = 0; j < m; j++)
+        batch[j] = i + j;
+      i += write<overflow::block>(*r, batch, m);
+    }
+  });
+
+  uint32_t next = 0, batch[13];
+  bool ordered = true;
+  while (next < n) {
+    size_t m = r->pop(batch, 13);
+    for (size_t j = 0; j < m; j++)
+      ordered &= batch[j] == next++;
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(r->size(), 0u);
+}
+
+/**
+ * A filter stage on its own thread produces the same output as direct stepping
+ */
+TEST(StreamTest, StageTest) {
+  auto s = control::filter::design::butter<4>(0.1);
+  auto ref = control::filter::design::cascade(s);
+
+  auto in = std::make_unique<SpscRing<double, 64>>();
+  auto out = std::make_unique<SpscRing<double, 64>>();
+  Stage<double, decltype(ref), 64, 64, overflow::block> stage(ref, *in, *out);
+
+  const size_t n = 20000;
+  std::vector<double> x(n), y;
+  for (size_t i = 0; i < n; i++)
+    x[i] = std::sin(0.01 * i) + (i % 31 == 0);
+
+  std::thread producer([&] {
+    write<overflow::block>(*in, x.data(), n);
+  });
+
+  std::thread worker([&] {
+    for (size_t done = 0; done < n;)
+      done += stage.run();
+  });
+
+  double v;
+  while (y.size() < n)
+    if (out->pop(v))
+      y.push_back(v);
+
+  producer.join();
+  worker.join();
+
+  for (size_t i = 0; i < n; i++)
+    ASSERT_EQ(y[i], ref.step(x[i]));
+  EXPECT_EQ(stage.drops(), 0u);
+}
+
+TEST(StreamTest, DropTest) {
+  SpscRing<float, 16> in, out;
+  Stage<float, control::classic::P<float>, 16, 16> stage(control::classic::P<float>(2.f), in, out);
+
+  std::array<float, 16> x;
+  x.fill(1.f);
+  in.push(x.data(), 16);
+  EXPECT_EQ(stage.run(), 16u);
+  in.push(x.data(), 16);
+  EXPECT_EQ(stage.run(), 16u);
+
+  // The reader never read, so the second batch was dropped
+  EXPECT_EQ(stage.drops(), 16u);
+  EXPECT_EQ(out.size(), 16u);
+
+  float y;
+  out.pop(y);
+  EXPECT_EQ(y, 2.f);
+}
+
+TEST(StreamTest, ChainTest) {
+  // Decimator and filter run by the same thread, chained through a ring
+  SpscRing<float, 64> a, b, c;
+  std::array<float, 4> h{0.25f, 0.25f, 0.25f, 0.25f};
+  Stage<float, control::filter::FirDecimator<float, 4, 4>, 64, 64> dec(
+      control::filter::FirDecimator<float, 4, 4>(h), a, b);
+  Stage<float, control::classic::P<float>, 64, 64> gain(control::classic::P<float>(4.f), b, c);
+
+  std::array<float, 64> x;
+  for (size_t i = 0; i < x.size(); i++)
+    x[i] = float(i / 4);
+  a.push(x.data(), x.size());
+
+  EXPECT_EQ(dec.run(), 64u);
+  EXPECT_EQ(gain.run(), 16u);
+
+  std::array<float, 16> y;
+  ASSERT_EQ(c.pop(y.data(), 16), 16u);
+  for (size_t m = 0; m < 16; m++)
+    EXPECT_EQ(y[m], 4.f * m);
+}
+
+}  // namespace
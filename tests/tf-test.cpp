@@ -0,0 +1,222 @@
+#include "control/system/tf.h"
+#include "control/classic/pid.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+
+namespace {
+
+using namespace control::system;
+using ::testing::ElementsAre;
+using ::testing::DoubleNear;
+
+using C = std::complex<double>;
+
+// Response of second-order sections at z
+C response(const std::vector<control::filter::sos<double>> &s, C z) {
+  C h = 1;
+  for (auto &si : s)
+    h *= (si.b0 * z * z + si.b1 * z + si.b2) / (z * z + si.a1 * z + si.a2);
+  return h;
+}
+
+ss<double, 2> plant() {
+  using P = ss<double, 2>;
+  P::TA A;
+  P::TB B;
+  P::TC Cm;
+  P::TD D;
+  A << 1, 0.01, 0, 0.98;
+  B << 0, 0.02;
+  Cm << 1, 0;
+  D << 0;
+  return P(A, B, Cm, D);
+}
+
+TEST(TfTest, ArithmeticTest) {
+  tf<double> a({1, 1}, {2, -1});   // (z + 1) / (2z - 1)
+  EXPECT_THAT(a.num(), ElementsAre(0.5, 0.5));
+  EXPECT_THAT(a.den(), ElementsAre(1, -0.5));
+  EXPECT_EQ(a.order(), 1u);
+  EXPECT_DOUBLE_EQ(a.dcgain(), 2.);
+
+  tf<double> b({1}, {1, 0});   // 1 / z
+  auto s = a * b;
+  EXPECT_THAT(s.num(), ElementsAre(0.5, 0.5));
+  EXPECT_THAT(s.den(), ElementsAre(1, -0.5, 0));
+
+  auto p = a + 1.;
+  EXPECT_THAT(p.num(), ElementsAre(1.5, 0));
+  EXPECT_DOUBLE_EQ((a - a).dcgain(), 0.);
+  EXPECT_DOUBLE_EQ((-a).dcgain(), -2.);
+  EXPECT_DOUBLE_EQ((a / a).dcgain(), 1.);
+
+  // Unity negative feedback: G / (1 + G)
+  auto f = a.feedback();
+  C z(0.3, 0.4);
+  EXPECT_NEAR(std::abs(f(z) - a(z) / (1. + a(z))), 0., 1e-12);
+  auto fp = a.feedback(b, 1);
+  EXPECT_NEAR(std::abs(fp(z) - a(z) / (1. - a(z) * b(z))), 0., 1e-12);
+
+  EXPECT_EQ(tf<double>::delay(3).den().size(), 4u);
+  EXPECT_THROW(tf<double>({1}, {0, 0}), std::invalid_argument);
+  EXPECT_FALSE(tf<double>({1, 0, 0}, {1, 0.5}).proper());
+}
+
+TEST(TfTest, RootsTest) {
+  // (z - 0.5)(z - 0.9)(z^2 - z + 0.5) z
+  std::vector<C> r{0.5, 0.9, {0.5, 0.5}, {0.5, -0.5}, 0.};
+  auto p = poly(r);
+  EXPECT_THAT(p, ElementsAre(1, DoubleNear(-2.4, 1e-12), DoubleNear(2.35, 1e-12), DoubleNear(-1.15, 1e-12),
+                             DoubleNear(0.225, 1e-12), 0));
+
+  auto q = roots(p);
+  ASSERT_EQ(q.size(), 5u);
+  for (auto ri : r) {
+    double d = 1;
+    for (auto qi : q)
+      d = std::min(d, std::abs(qi - ri));
+    EXPECT_LT(d, 1e-10) << ri;
+  }
+
+  // Clustered roots of a high-order low-pass
+  auto lp = tf<double>(1.);
+  for (auto &s : control::filter::design::butter<12>(0.05))
+    lp = lp * tf<double>(s);
+  for (auto z : lp.poles())
+    EXPECT_LT(std::abs(z), 1.);
+  EXPECT_TRUE(lp.stable());
+  EXPECT_FALSE(tf<double>({1}, {1, -1}).stable());
+}
+
+/**
+ * An expanded seventh-order elliptic filter factors back into sections with the same response
+ */
+TEST(TfTest, SectionsTest) {
+  auto s0 = control::filter::design::ellip<7>(0.5, 60., 0.2);
+  std::vector<control::filter::sos<double>> ref(s0.begin(), s0.end());
+  auto h = tf<double>(1.);
+  for (auto &s : ref)
+    h = h * tf<double>(s);
+  ASSERT_EQ(h.order(), 7u);
+
+  auto s = h.sections();
+  ASSERT_EQ(s.size(), 4u);
+  for (double w : {0.01, 0.1, 0.19, 0.3, 0.8}) {
+    C z = std::polar(1., w * std::acos(-1.));
+    auto r = response(ref, z);
+    EXPECT_NEAR(std::abs(response(s, z) - r), 0., 1e-8 * std::max(1., std::abs(r))) << w;
+  }
+
+  // Sections run stably as a cascade
+  auto c = h.cascade<5>();
+  double y = 0;
+  for (int i = 0; i < 2000; i++)
+    y = c.step(1.);
+  EXPECT_NEAR(y, h.dcgain(), 1e-9);
+
+  // Zeros at infinity become delays
+  auto d = tf<double>({2}, {1, -0.5}) * tf<double>::delay(2);
+  auto cd = d.cascade<2>();
+  std::vector<double> out;
+  for (int i = 0; i < 5; i++)
+    out.push_back(cd.step(i == 0 ? 1. : 0.));
+  EXPECT_THAT(out, ElementsAre(0, 0, 0, DoubleNear(2, 1e-12), DoubleNear(1, 1e-12)));
+
+  EXPECT_EQ(tf<double>(3.).sections()[0].b0, 3.);
+  EXPECT_THROW(h.cascade<3>(), std::length_error);
+}
+
+/**
+ * Closed loop PID * plant / (1 + PID * plant) runs like the loop itself
+ *
+ * The stepped plant returns its output after the state update, so the loop
+ * feeds back the previous output.
+ */
+TEST(TfTest, ClosedLoopTest) {
+  auto P = plant();
+  control::classic::PID<double> pid(0.01, 5., 0.5, 0.05, 10.);
+  auto G = tf<double>(P);
+  auto K = tf<double>(pid.coefficients());
+  auto T = (K * G).feedback(tf<double>::delay(1));
+  EXPECT_EQ(T.order(), 4u);
+  EXPECT_TRUE(T.stable());
+  EXPECT_NEAR(T.dcgain(), 1., 1e-9);
+
+  auto c = T.cascade<2>();
+  double y = 0;
+  for (int k = 0; k < 500; k++) {
+    double u = pid.step(1. - y);
+    y = P.step(ss<double, 2>::Tu::Constant(u))(0);
+    ASSERT_NEAR(c.step(1.), y, 1e-9) << k;
+  }
+}
+
+TEST(TfTest, StateSpaceTest) {
+  auto P = plant();
+  auto G = tf<double>(P);
+  EXPECT_EQ(G.order(), 2u);
+  C z(0.7, 0.2);
+  auto H = z * (P.getC() * ((z * Eigen::Matrix2cd::Identity() - P.getA().cast<C>()).inverse() * P.getB().cast<C>()));
+  EXPECT_NEAR(std::abs(G(z) - H(0)), 0., 1e-12);
+
+  // Balanced realization of a third-order filter
+  tf<double> h({1, 0.5, 0.25}, {1, -2.65, 2.335, -0.684});
+  auto R = h.statespace<3>();
+  EXPECT_NEAR(std::abs(tf<double>(R)(z) - h(z)), 0., 1e-9);
+
+  // Stepping runs h itself
+  auto Q = h.statespace<3>();
+  auto c = h.cascade<2>();
+  for (int k = 0; k < 100; k++) {
+    double x = std::sin(0.1 * k);
+    ASSERT_NEAR(Q.step(ss<double, 3>::Tu::Constant(x))(0), c.step(x), 1e-9) << k;
+  }
+
+  EXPECT_THROW(h.statespace<2>(), std::length_error);
+
+  // A pole at the origin takes one more state
+  auto g = tf<double>({1}, {1, -0.5}) * tf<double>::delay(1);
+  ASSERT_EQ(g.states(), 3u);
+  EXPECT_THROW(g.statespace<2>(), std::length_error);
+  auto S = g.statespace<3>();
+  auto e = g.cascade<2>();
+  for (int k = 0; k < 20; k++) {
+    double x = std::sin(0.1 * k);
+    ASSERT_NEAR(S.step(ss<double, 3>::Tu::Constant(x))(0), e.step(x), 1e-12) << k;
+  }
+}
+
+/**
+ * A biproper PID realization steps like its biquad
+ */
+TEST(TfTest, BiproperStateSpaceTest) {
+  control::classic::PID<double> pid(0.01, 5., 0.5, 0.05, 10.);
+  tf<double> K(pid.coefficients());
+  ASSERT_EQ(K.order(), 2u);
+  ASSERT_NE(K.num()[0], 0.);
+  ASSERT_EQ(K.states(), 3u);   // the derivative filter has its pole at the origin
+
+  auto R = K.statespace<3>();
+  C z(0.7, 0.2);
+  EXPECT_NEAR(std::abs(tf<double>(R)(z) - K(z)), 0., 1e-9 * std::abs(K(z)));
+
+  auto c = K.cascade<1>();
+  for (int k = 0; k < 100; k++) {
+    double x = std::sin(0.1 * k);
+    ASSERT_NEAR(R.step(ss<double, 3>::Tu::Constant(x))(0), c.step(x), 1e-9) << k;
+  }
+
+  // Without a pole at the origin the feed-through is H(0)
+  tf<double> L({0.2, 0.4, 0.2}, {1, -0.6, 0.2});
+  auto Q = L.statespace<2>();
+  EXPECT_NEAR(Q.getD()(0), 1., 1e-12);   // 0.2 / 0.2
+  auto l = L.cascade<1>();
+  for (int k = 0; k < 100; k++) {
+    double x = std::sin(0.1 * k);
+    ASSERT_NEAR(Q.step(ss<double, 2>::Tu::Constant(x))(0), l.step(x), 1e-12) << k;
+  }
+}
+
+}  // namespace
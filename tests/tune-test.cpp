@@ -0,0 +1,120 @@
+#include "control/classic/tune.h"
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <cmath>
+
+namespace {
+
+using namespace control::classic::tune;
+
+// Motor position: integrator and a first-order lag of 0.5 s, forward Euler
+loop<double, 2> motor() {
+  using ss = control::system::ss<double, 2>;
+  const double Ts = 0.01, tau = 0.5;
+  ss::TA A;
+  ss::TB B;
+  ss::TC C;
+  ss::TD D;
+  A << 1, Ts, 0, 1 - Ts / tau;
+  B << 0, Ts / tau;
+  C << 1, 0;
+  D << 0;
+  return {ss(A, B, C, D), Ts, 1000};
+}
+
+// 1 / (s + 1)^3, forward Euler: Ku = 8, Tu = 2 pi / sqrt(3)
+loop<double, 3> lag3() {
+  using ss = control::system::ss<double, 3>;
+  const double Ts = 1e-3;
+  ss::TA A;
+  ss::TB B;
+  ss::TC C;
+  ss::TD D;
+  A << 1 - Ts, 0, 0, Ts, 1 - Ts, 0, 0, Ts, 1 - Ts;
+  B << Ts, 0, 0;
+  C << 0, 0, 1;
+  D << 0;
+  return {ss(A, B, C, D), Ts, 40000};
+}
+
+TEST(TuneTest, SimulateTest) {
+  auto l = motor();
+  auto m = simulate(l, {2., 2., 0.1});
+  EXPECT_TRUE(m.stable);
+  EXPECT_GT(m.ise, 0.);
+  EXPECT_GT(m.overshoot, 0.);
+  EXPECT_LT(m.settling, 10.);
+
+  // Far too much gain for the sample time
+  EXPECT_FALSE(simulate(l, {5000., 0.01, 0.}).stable);
+}
+
+TEST(TuneTest, BatchTest) {
+  auto l = motor();
+  l.Limit = 1.5;
+  l.N = 10;
+
+  std::array<gains<double>, 8> g{{{1, 5, 0}, {2, 2, 0.1}, {4, 1, 0.2}, {0.5, 10, 0},
+                                  {8, 0.5, 0.05}, {5000, 0.01, 0}, {3, 3, 0.3}, {1.5, 0.8, 0}}};
+  auto m = simulate(l, g);
+  for (size_t k = 0; k < g.size(); k++) {
+    auto r = simulate(l, g[k]);
+    ASSERT_EQ(m[k].stable, r.stable) << k;
+    if (!r.stable)
+      continue;
+    EXPECT_NEAR(m[k].ise, r.ise, 1e-9 * r.ise) << k;
+    EXPECT_NEAR(m[k].iae, r.iae, 1e-9 * r.iae) << k;
+    EXPECT_NEAR(m[k].overshoot, r.overshoot, 1e-9) << k;
+    EXPECT_EQ(m[k].settling, r.settling) << k;
+  }
+}
+
+TEST(TuneTest, SweepTest) {
+  auto l = motor();
+  auto g = grid(space(0.5, 8., 9), space(0.5, 8., 9), space(0., 0.4, 5));
+  ASSERT_EQ(g.size(), 405u);
+
+  auto m = sweep(l, g, 4);
+  ASSERT_EQ(m.size(), g.size());
+
+  auto b = best(m, ise<double>);
+  EXPECT_EQ(m[b].ise, simulate(l, g[b]).ise);
+  for (auto &mi : m)
+    EXPECT_GE(mi.ise, m[b].ise);
+
+  // Settling-time criterion, among candidates with little overshoot
+  auto s = best(m, [](const metrics<double> &mi) { return mi.overshoot < 0.05 ? mi.settling : 1e9; });
+  EXPECT_LT(m[s].overshoot, 0.05);
+  EXPECT_LT(m[s].settling, 2.);
+}
+
+TEST(TuneTest, NelderMeadTest) {
+  auto l = motor();
+  gains<double> x0{1, 4, 0.05};
+  auto x = nelder_mead(l, x0, ise<double>);
+  EXPECT_LT(simulate(l, x).ise, 0.8 * simulate(l, x0).ise);
+
+  // PI only
+  auto pi = nelder_mead(l, gains<double>{1, 4, 0}, ise<double>);
+  EXPECT_EQ(pi.Td, 0.);
+  EXPECT_LT(simulate(l, pi).ise, simulate(l, {1., 4., 0.}).ise);
+}
+
+TEST(TuneTest, RelayTest) {
+  auto l = lag3();
+  l.r = 0;
+  auto u = relay(l, 1., 0.);
+  const double pi = std::acos(-1.);
+  EXPECT_NEAR(u.Tu, 2 * pi / std::sqrt(3.), 0.05 * 2 * pi / std::sqrt(3.));
+  EXPECT_NEAR(u.Ku, 8., 0.1 * 8.);
+
+  auto g = ziegler_nichols(u);
+  l.r = 1;
+  l.steps = 20000;
+  auto m = simulate(l, g);
+  EXPECT_TRUE(m.stable);
+  EXPECT_LT(m.settling, 20.);
+}
+
+}  // namespace